@@ -0,0 +1,386 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include <asmjit/x86.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "./asmbatch.h"
+#include "./asmparser.h"
+#include "./threadutils_p.h"
+
+namespace asmtk {
+
+using namespace asmjit;
+
+//! Maximum number of threads of the worker pool.
+static constexpr uint32_t kBatchMaxThreads = 64;
+//! Number of jobs a worker claims at once - jobs are tiny, so claiming them one by one would only contend.
+static constexpr size_t kBatchJobChunkSize = 16;
+
+// ============================================================================
+// [asmtk::AsmBatchWorker]
+// ============================================================================
+
+//! Worker of `AsmBatch` - everything a job needs, reused by all jobs the worker runs.
+struct AsmBatchWorker {
+  CodeHolder code;
+  x86::Assembler assembler;
+  BasicAsmParser<x86::Assembler> parser;
+
+  //! Machine code of the jobs the worker ran, moved to the output buffer of `AsmBatch` when all jobs are done.
+  uint8_t* data;
+  size_t size;
+  size_t capacity;
+
+  std::thread thread;
+
+  inline AsmBatchWorker() noexcept
+    : parser(&assembler),
+      data(nullptr),
+      size(0),
+      capacity(0) {}
+
+  inline ~AsmBatchWorker() noexcept { ::free(data); }
+};
+
+// ============================================================================
+// [asmtk::AsmBatchPool]
+// ============================================================================
+
+struct AsmBatchPool {
+  std::mutex mutex;
+  std::condition_variable start_condition;
+  std::condition_variable done_condition;
+
+  //! Incremented by each `run()` to wake up workers.
+  uint64_t generation;
+  //! Number of worker threads that may still join the current generation.
+  uint32_t wake_count;
+  //! Number of worker threads that haven't finished the current generation yet.
+  uint32_t running_count;
+  //! Set when the pool is being stopped.
+  bool stop;
+
+  //! Jobs of the current generation.
+  const AsmBatch::Job* jobs;
+  AsmBatch::Result* results;
+  size_t job_count;
+  std::atomic<size_t> next_job;
+
+  //! Workers, the first worker is the thread that calls `run()`.
+  AsmBatchWorker* workers;
+  uint32_t thread_count;
+};
+
+template<typename T>
+static Error batch_reserve(T** data, size_t* capacity, size_t n) noexcept {
+  if (n <= *capacity)
+    return Error::kOk;
+
+  size_t new_capacity = std::max<size_t>(*capacity, 1024);
+  while (new_capacity < n)
+    new_capacity *= 2;
+
+  if (ASMJIT_UNLIKELY(new_capacity > SIZE_MAX / sizeof(T)))
+    return make_error(Error::kOutOfMemory);
+
+  T* new_data = static_cast<T*>(::realloc(*data, new_capacity * sizeof(T)));
+  if (ASMJIT_UNLIKELY(!new_data))
+    return make_error(Error::kOutOfMemory);
+
+  *data = new_data;
+  *capacity = new_capacity;
+  return Error::kOk;
+}
+
+// Reuses the CodeHolder of the worker if the job targets the same environment as the previous job, which keeps its
+// memory and the attached assembler, otherwise the CodeHolder is initialized again.
+static Error prepare_worker(AsmBatchWorker& worker, const AsmBatch::Job& job) noexcept {
+  CodeHolder& code = worker.code;
+
+  if (code.is_initialized() && code.arch() == job.arch && code.base_address() == job.base_address) {
+    ASMJIT_PROPAGATE(code.reinit());
+  }
+  else {
+    code.reset();
+    ASMJIT_PROPAGATE(code.init(Environment(job.arch), job.base_address));
+    ASMJIT_PROPAGATE(code.attach(&worker.assembler));
+  }
+
+  worker.parser.reset();
+  return Error::kOk;
+}
+
+static void run_job(AsmBatchWorker& worker, uint32_t worker_id, const AsmBatch::Job& job, AsmBatch::Result& result) noexcept {
+  result.worker_id = worker_id;
+  result.error_offset = 0;
+  result.offset = 0;
+  result.size = 0;
+
+  result.err = prepare_worker(worker, job);
+  if (result.err != Error::kOk)
+    return;
+
+  result.err = worker.parser.parse(job.input, job.size);
+  if (result.err != Error::kOk) {
+    result.error_offset = worker.parser.current_command_offset();
+    return;
+  }
+
+  const CodeBuffer& buffer = worker.code.text_section()->buffer();
+  result.err = batch_reserve(&worker.data, &worker.capacity, worker.size + buffer.size());
+  if (result.err != Error::kOk)
+    return;
+
+  memcpy(worker.data + worker.size, buffer.data(), buffer.size());
+  result.offset = worker.size;
+  result.size = buffer.size();
+  worker.size += buffer.size();
+}
+
+static void run_jobs(AsmBatchPool& pool, uint32_t worker_id) noexcept {
+  AsmBatchWorker& worker = pool.workers[worker_id];
+
+  for (;;) {
+    size_t begin = pool.next_job.fetch_add(kBatchJobChunkSize, std::memory_order_relaxed);
+    if (begin >= pool.job_count)
+      break;
+
+    size_t end = std::min(begin + kBatchJobChunkSize, pool.job_count);
+    for (size_t i = begin; i < end; i++)
+      run_job(worker, worker_id, pool.jobs[i], pool.results[i]);
+  }
+}
+
+static void worker_main(AsmBatchPool* pool, uint32_t worker_id) noexcept {
+  uint64_t generation = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(pool->mutex);
+      pool->start_condition.wait(lock, [&] {
+        return pool->stop || (pool->generation != generation && pool->wake_count != 0);
+      });
+
+      if (pool->stop)
+        return;
+      generation = pool->generation;
+      pool->wake_count--;
+    }
+
+    run_jobs(*pool, worker_id);
+
+    {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      if (--pool->running_count == 0)
+        pool->done_condition.notify_one();
+    }
+  }
+}
+
+static void destroy_pool(AsmBatchPool* pool) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->stop = true;
+  }
+  pool->start_condition.notify_all();
+
+  for (uint32_t i = 0; i < pool->thread_count; i++) {
+    AsmBatchWorker& worker = pool->workers[i];
+    if (worker.thread.joinable())
+      worker.thread.join();
+    worker.~AsmBatchWorker();
+  }
+
+  ::free(pool->workers);
+  pool->~AsmBatchPool();
+  ::free(pool);
+}
+
+// ============================================================================
+// [asmtk::AsmBatch - Construction & Destruction]
+// ============================================================================
+
+AsmBatch::AsmBatch() noexcept
+  : _pool(nullptr),
+    _results(nullptr),
+    _result_count(0),
+    _result_capacity(0),
+    _data(nullptr),
+    _data_size(0),
+    _data_capacity(0),
+    _stats() {}
+
+AsmBatch::~AsmBatch() noexcept {
+  reset();
+}
+
+// ============================================================================
+// [asmtk::AsmBatch - Initialization]
+// ============================================================================
+
+Error AsmBatch::init(uint32_t thread_count) noexcept {
+  reset();
+
+  if (thread_count == 0)
+    thread_count = std::thread::hardware_concurrency();
+  thread_count = std::min(std::max(thread_count, 1u), kBatchMaxThreads);
+
+  AsmBatchPool* pool = static_cast<AsmBatchPool*>(::malloc(sizeof(AsmBatchPool)));
+  AsmBatchWorker* workers = static_cast<AsmBatchWorker*>(::malloc(thread_count * sizeof(AsmBatchWorker)));
+
+  if (ASMJIT_UNLIKELY(!pool || !workers)) {
+    ::free(pool);
+    ::free(workers);
+    return make_error(Error::kOutOfMemory);
+  }
+
+  new(pool) AsmBatchPool();
+  pool->generation = 0;
+  pool->wake_count = 0;
+  pool->running_count = 0;
+  pool->stop = false;
+  pool->jobs = nullptr;
+  pool->results = nullptr;
+  pool->job_count = 0;
+  pool->workers = workers;
+  pool->thread_count = thread_count;
+
+  for (uint32_t i = 0; i < thread_count; i++)
+    new(&workers[i]) AsmBatchWorker();
+
+  // Threads that were started are stopped and joined by `destroy_pool()` if the rest cannot be started.
+  for (uint32_t i = 1; i < thread_count; i++) {
+    if (ASMJIT_UNLIKELY(!ThreadUtils::start_thread(workers[i].thread, worker_main, pool, i))) {
+      destroy_pool(pool);
+      return make_error(Error::kOutOfMemory);
+    }
+  }
+
+  _pool = pool;
+  return Error::kOk;
+}
+
+void AsmBatch::reset() noexcept {
+  if (_pool) {
+    destroy_pool(_pool);
+    _pool = nullptr;
+  }
+
+  ::free(_results);
+  ::free(_data);
+
+  _results = nullptr;
+  _result_count = 0;
+  _result_capacity = 0;
+  _data = nullptr;
+  _data_size = 0;
+  _data_capacity = 0;
+  _stats = Stats();
+}
+
+uint32_t AsmBatch::thread_count() const noexcept {
+  return _pool ? _pool->thread_count : 0u;
+}
+
+// ============================================================================
+// [asmtk::AsmBatch - Run]
+// ============================================================================
+
+Error AsmBatch::run(const Job* jobs, size_t count) noexcept {
+  if (ASMJIT_UNLIKELY(!_pool))
+    return make_error(Error::kNotInitialized);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  _result_count = 0;
+  _data_size = 0;
+  ASMJIT_PROPAGATE(batch_reserve(&_results, &_result_capacity, count));
+
+  AsmBatchPool& pool = *_pool;
+  uint32_t thread_count = pool.thread_count;
+
+  pool.jobs = jobs;
+  pool.results = _results;
+  pool.job_count = count;
+  pool.next_job.store(0, std::memory_order_relaxed);
+
+  // Don't wake up workers that would have nothing to do - each chunk of jobs needs at most one thread, and the calling
+  // thread takes the first one. Each woken worker takes one of `wake_count` slots, so other workers keep sleeping.
+  uint32_t wake_count = uint32_t(std::min<size_t>(thread_count, (count + kBatchJobChunkSize - 1u) / kBatchJobChunkSize));
+
+  if (wake_count > 1u) {
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      pool.wake_count = wake_count - 1u;
+      pool.running_count = wake_count - 1u;
+      pool.generation++;
+    }
+
+    for (uint32_t i = 1; i < wake_count; i++)
+      pool.start_condition.notify_one();
+  }
+
+  run_jobs(pool, 0);
+
+  if (wake_count > 1u) {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done_condition.wait(lock, [&] { return pool.running_count == 0; });
+  }
+
+  // Move the machine code of all workers to the output buffer in the order of jobs.
+  size_t code_size = 0;
+  for (uint32_t i = 0; i < thread_count; i++)
+    code_size += pool.workers[i].size;
+
+  Error err = batch_reserve(&_data, &_data_capacity, code_size);
+
+  if (err == Error::kOk) {
+    size_t failed_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+      Result& result = _results[i];
+      const AsmBatchWorker& worker = pool.workers[result.worker_id];
+
+      // Failed jobs have no code, and neither may the worker, so there is nothing to copy from.
+      if (result.size != 0)
+        memcpy(_data + _data_size, worker.data + result.offset, result.size);
+
+      result.offset = _data_size;
+      _data_size += result.size;
+
+      if (result.err != Error::kOk)
+        failed_count++;
+    }
+
+    _result_count = count;
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    _stats.job_count = count;
+    _stats.failed_count = failed_count;
+    _stats.code_size = code_size;
+    _stats.duration = duration.count() * 1000.0;
+  }
+
+  for (uint32_t i = 0; i < thread_count; i++)
+    pool.workers[i].size = 0;
+
+  pool.jobs = nullptr;
+  pool.results = nullptr;
+  pool.job_count = 0;
+
+  return err;
+}
+
+} // {asmtk}
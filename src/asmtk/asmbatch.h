@@ -0,0 +1,174 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_ASMBATCH_H
+#define _ASMTK_ASMBATCH_H
+
+#include "./globals.h"
+
+namespace asmtk {
+
+struct AsmBatchPool;
+
+// ============================================================================
+// [asmtk::AsmBatch]
+// ============================================================================
+
+//! Assembles many independent snippets on a fixed pool of worker threads.
+//!
+//! Each worker owns a `CodeHolder`, an `x86::Assembler`, and an `AsmParser`, which are reused by all jobs the worker
+//! runs, so assembling a snippet doesn't allocate unless it's bigger than all snippets the worker assembled before.
+//! The machine code of all jobs is stored in a single output buffer in the order of jobs, see `job_data()`.
+//!
+//! ```
+//! AsmBatch batch;
+//! batch.init(4);
+//!
+//! AsmBatch::Job jobs[] = {
+//!   { "mov eax, ebx", SIZE_MAX, Arch::kX64, 0x1000 },
+//!   { "ret"         , SIZE_MAX, Arch::kX86, 0x2000 }
+//! };
+//!
+//! batch.run(jobs, 2);
+//! for (size_t i = 0; i < 2; i++) {
+//!   const AsmBatch::Result& result = batch.result_at(i);
+//!   if (result.err == Error::kOk)
+//!     use(batch.job_data(i), result.size);
+//! }
+//! ```
+class AsmBatch {
+public:
+  //! Job to assemble.
+  struct Job {
+    //! Input (not required to be null terminated if `size` is given).
+    const char* input;
+    //! Size of the input, or `SIZE_MAX` if it's null terminated.
+    size_t size;
+    //! Target architecture (either `Arch::kX86` or `Arch::kX64`).
+    asmjit::Arch arch;
+    //! Base address, or `Globals::kNoBaseAddress`.
+    uint64_t base_address;
+  };
+
+  //! Result of a job.
+  struct Result {
+    //! Error returned by the parser, `Error::kOk` on success.
+    Error err;
+    //! Worker that assembled the job.
+    uint32_t worker_id;
+    //! Offset of the command that failed, see `AsmParser::current_command_offset()`.
+    size_t error_offset;
+    //! Offset of the machine code in the output buffer.
+    size_t offset;
+    //! Size of the machine code, zero if the job failed.
+    size_t size;
+  };
+
+  //! Statistics of the last `run()`.
+  struct Stats {
+    //! Number of jobs.
+    size_t job_count;
+    //! Number of jobs that failed.
+    size_t failed_count;
+    //! Size of the machine code of all jobs.
+    size_t code_size;
+    //! Wall-clock duration of `run()` in milliseconds.
+    double duration;
+
+    //! Returns the number of jobs assembled per second.
+    inline double jobs_per_second() const noexcept {
+      return duration > 0.0 ? double(job_count) * 1000.0 / duration : 0.0;
+    }
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Worker threads and their assemblers.
+  AsmBatchPool* _pool;
+
+  //! Results of the last `run()`.
+  Result* _results;
+  size_t _result_count;
+  size_t _result_capacity;
+
+  //! Machine code of all jobs of the last `run()`.
+  uint8_t* _data;
+  size_t _data_size;
+  size_t _data_capacity;
+
+  Stats _stats;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmBatch() noexcept;
+  ASMTK_API ~AsmBatch() noexcept;
+
+  AsmBatch(const AsmBatch& other) = delete;
+  AsmBatch& operator=(const AsmBatch& other) = delete;
+
+  //! \}
+
+  //! \name Initialization
+  //! \{
+
+  //! Starts the worker pool of `thread_count` threads (including the thread that calls `run()`), zero uses the
+  //! number of hardware threads. Any previous pool is stopped first.
+  //!
+  //! Returns `Error::kOutOfMemory` if the pool cannot be allocated or if a thread cannot be created, in which case
+  //! the threads already started are stopped and the batch is left uninitialized.
+  ASMTK_API Error init(uint32_t thread_count = 0) noexcept;
+
+  //! Stops the worker pool and releases all results.
+  ASMTK_API void reset() noexcept;
+
+  inline bool is_initialized() const noexcept { return _pool != nullptr; }
+
+  //! Returns the number of threads of the worker pool.
+  ASMTK_API uint32_t thread_count() const noexcept;
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  //! Assembles `count` jobs and replaces the results of the previous run.
+  //!
+  //! A failed job doesn't stop other jobs, its error is stored in its `Result`. The returned error is only non-zero
+  //! if the batch itself couldn't run (not initialized or out of memory).
+  ASMTK_API Error run(const Job* jobs, size_t count) noexcept;
+
+  inline Error run(asmjit::Span<const Job> jobs) noexcept { return run(jobs.data(), jobs.size()); }
+
+  //! \}
+
+  //! \name Results
+  //! \{
+
+  inline size_t result_count() const noexcept { return _result_count; }
+  inline const Result& result_at(size_t index) const noexcept {
+    ASMJIT_ASSERT(index < _result_count);
+    return _results[index];
+  }
+
+  //! Returns the machine code of all jobs, the machine code of a job follows the machine code of the previous job.
+  inline const uint8_t* data() const noexcept { return _data; }
+  inline size_t data_size() const noexcept { return _data_size; }
+
+  //! Returns the machine code of the job at `index`, see `Result::size`.
+  inline const uint8_t* job_data(size_t index) const noexcept { return _data + result_at(index).offset; }
+
+  inline const Stats& stats() const noexcept { return _stats; }
+
+  //! \}
+};
+
+} // {asmtk}
+
+#endif // _ASMTK_ASMBATCH_H
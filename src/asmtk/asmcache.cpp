@@ -0,0 +1,483 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include "./asmcache.h"
+#include "./mappedfile_p.h"
+
+#if defined(_WIN32)
+  #include <process.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace asmtk {
+
+using namespace asmjit;
+
+// ============================================================================
+// [asmtk::AsmCache - File Format]
+// ============================================================================
+
+// A cache file consists of the following parts, each aligned to 8 bytes:
+//
+//   - CacheFileHeader.
+//   - CacheLabel[label_count] - labels in the order of their ids, so they get the same ids when created again.
+//   - uint32_t[label_count]   - label indexes sorted by offset, which is the order in which they are bound.
+//   - char[names_size]        - label names.
+//   - uint8_t[code_size]      - machine code of the text section.
+//
+// Integers are stored in the byte order of the host, which is verified by `magic`.
+
+static constexpr uint64_t kCacheFileMagic = 0x3165686361436B54u; // "TkCache1" when stored little endian.
+
+struct CacheFileHeader {
+  uint64_t magic;
+  uint32_t format_version;
+  uint32_t asmtk_version;
+  uint32_t asmjit_version;
+  uint32_t arch;
+  uint64_t base_address;
+  uint64_t hash[2];
+  uint64_t input_size;
+  uint32_t encoding_options;
+  uint32_t label_count;
+  uint32_t current_global_label_id;
+  uint32_t names_size;
+  uint64_t code_size;
+};
+
+struct CacheLabel {
+  uint64_t offset;
+  uint32_t name_offset;
+  uint32_t name_size;
+  uint32_t parent_id;
+  uint32_t label_type;
+};
+
+static_assert(sizeof(CacheFileHeader) % 8u == 0, "CacheFileHeader must keep the following parts 8-byte aligned");
+static_assert(sizeof(CacheLabel) % 8u == 0, "CacheLabel must keep the following parts 8-byte aligned");
+
+//! Layout of a cache file.
+struct CacheFileLayout {
+  size_t labels_offset;
+  size_t bind_order_offset;
+  size_t names_offset;
+  size_t code_offset;
+  size_t file_size;
+
+  inline bool init(uint64_t label_count, uint64_t names_size, uint64_t code_size) noexcept {
+    // Calculated in 64 bits, which cannot overflow with 32-bit counts and sizes limited to 2^40 bytes.
+    constexpr uint64_t kMaxCodeSize = uint64_t(1) << 40;
+    if (label_count > UINT32_MAX || names_size > UINT32_MAX || code_size > kMaxCodeSize)
+      return false;
+
+    uint64_t labels = sizeof(CacheFileHeader);
+    uint64_t bind_order = labels + label_count * sizeof(CacheLabel);
+    uint64_t names = bind_order + Support::align_up(label_count * sizeof(uint32_t), 8u);
+    uint64_t code = names + Support::align_up(names_size, 8u);
+    uint64_t size = code + code_size;
+
+    if (size > uint64_t(SIZE_MAX))
+      return false;
+
+    labels_offset = size_t(labels);
+    bind_order_offset = size_t(bind_order);
+    names_offset = size_t(names);
+    code_offset = size_t(code);
+    file_size = size_t(size);
+    return true;
+  }
+};
+
+// ============================================================================
+// [asmtk::AsmCache - Utilities]
+// ============================================================================
+
+static inline uint64_t hash_fmix(uint64_t x) noexcept {
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDu;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53u;
+  x ^= x >> 33;
+  return x;
+}
+
+static inline uint64_t hash_rotl(uint64_t x, uint32_t n) noexcept {
+  return (x << n) | (x >> (64u - n));
+}
+
+// Two independent 64-bit lanes (in the style of MurmurHash3) hash 8 bytes at a time - the input is hashed on each
+// lookup, so the hash must be much faster than parsing. Not meant to withstand crafted collisions.
+static void hash_input(const uint8_t* p, size_t size, uint64_t seed, uint64_t out[2]) noexcept {
+  constexpr uint64_t k1 = 0x87C37B91114253D5u;
+  constexpr uint64_t k2 = 0x4CF5AD432745937Fu;
+
+  uint64_t h1 = seed ^ uint64_t(size);
+  uint64_t h2 = hash_fmix(seed) ^ uint64_t(size);
+
+  const uint8_t* end = p + (size & ~size_t(7));
+  while (p != end) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+
+    h1 = hash_rotl(h1 ^ hash_rotl(v * k1, 31) * k2, 27) * 5u + 0x52DCE729u;
+    h2 = hash_rotl(h2 ^ hash_rotl(v * k2, 33) * k1, 31) * 5u + 0x38495AB5u;
+    p += 8;
+  }
+
+  uint64_t tail = 0;
+  size_t tail_size = size & 7u;
+  for (size_t i = 0; i < tail_size; i++)
+    tail |= uint64_t(p[i]) << (i * 8u);
+
+  h1 ^= hash_rotl(tail * k1, 31) * k2;
+  h2 ^= hash_rotl(tail * k2, 33) * k1;
+
+  h1 += h2;
+  h2 += h1;
+  h1 = hash_fmix(h1);
+  h2 = hash_fmix(h2);
+  h1 += h2;
+  h2 += h1;
+
+  out[0] = h1;
+  out[1] = h2;
+}
+
+// Everything the machine code depends on, besides the input.
+static void init_header(CacheFileHeader& header, BaseEmitter* emitter, const AsmCache::Key& key) noexcept {
+  memset(&header, 0, sizeof(header));
+
+  header.magic = kCacheFileMagic;
+  header.format_version = AsmCache::kFormatVersion;
+  header.asmtk_version = ASMTK_LIBRARY_VERSION;
+  header.asmjit_version = ASMJIT_LIBRARY_VERSION;
+  header.arch = uint32_t(emitter->arch());
+  header.base_address = emitter->code()->base_address();
+  header.hash[0] = key.hash[0];
+  header.hash[1] = key.hash[1];
+  header.input_size = key.input_size;
+  header.encoding_options = uint32_t(emitter->encoding_options());
+}
+
+static inline bool is_same_entry(const CacheFileHeader& a, const CacheFileHeader& b) noexcept {
+  return a.magic == b.magic &&
+         a.format_version == b.format_version &&
+         a.asmtk_version == b.asmtk_version &&
+         a.asmjit_version == b.asmjit_version &&
+         a.arch == b.arch &&
+         a.base_address == b.base_address &&
+         a.hash[0] == b.hash[0] &&
+         a.hash[1] == b.hash[1] &&
+         a.input_size == b.input_size &&
+         a.encoding_options == b.encoding_options;
+}
+
+//! Path of a cache file (or of its temporary file).
+struct CachePath {
+  // Directory + separator + 32 hex digits + extension + temporary suffix.
+  char* data;
+  char buffer[256];
+
+  inline CachePath() noexcept : data(buffer) {}
+  inline ~CachePath() noexcept {
+    if (data != buffer)
+      ::free(data);
+  }
+
+  bool init(const AsmCache& cache, const AsmCache::Key& key, const char* suffix) noexcept {
+    size_t size = cache._directory_size + 64u + strlen(suffix);
+    if (size > sizeof(buffer)) {
+      data = static_cast<char*>(::malloc(size));
+      if (!data) {
+        data = buffer;
+        return false;
+      }
+    }
+
+    snprintf(data, size, "%s/%016llx%016llx.asmc%s",
+      cache._directory, (unsigned long long)key.hash[0], (unsigned long long)key.hash[1], suffix);
+    return true;
+  }
+};
+
+// Tests whether a cache file is a valid entry of `expected` and initializes its `layout`.
+static bool validate_entry(const uint8_t* data, size_t size, const CacheFileHeader& expected, CacheFileLayout& layout) noexcept {
+  if (size < sizeof(CacheFileHeader))
+    return false;
+
+  CacheFileHeader header;
+  memcpy(&header, data, sizeof(header));
+
+  if (!is_same_entry(header, expected) || !layout.init(header.label_count, header.names_size, header.code_size) || layout.file_size != size)
+    return false;
+
+  const CacheLabel* labels = reinterpret_cast<const CacheLabel*>(data + layout.labels_offset);
+  const uint32_t* bind_order = reinterpret_cast<const uint32_t*>(data + layout.bind_order_offset);
+
+  for (uint32_t i = 0; i < header.label_count; i++) {
+    const CacheLabel& label = labels[i];
+    if (uint64_t(label.name_offset) + label.name_size > header.names_size || label.offset > header.code_size)
+      return false;
+
+    if (label.label_type == uint32_t(LabelType::kGlobal)) {
+      if (label.parent_id != Globals::kInvalidId)
+        return false;
+    }
+    else if (label.label_type != uint32_t(LabelType::kLocal) || label.parent_id >= i) {
+      return false;
+    }
+
+    if (bind_order[i] >= header.label_count || (i && labels[bind_order[i]].offset < labels[bind_order[i - 1]].offset))
+      return false;
+  }
+
+  return header.current_global_label_id == Globals::kInvalidId || header.current_global_label_id < header.label_count;
+}
+
+// ============================================================================
+// [asmtk::AsmCache - Construction & Destruction]
+// ============================================================================
+
+AsmCache::AsmCache() noexcept
+  : _directory(nullptr),
+    _directory_size(0),
+    _stats() {}
+
+AsmCache::~AsmCache() noexcept {
+  reset();
+}
+
+// ============================================================================
+// [asmtk::AsmCache - Initialization]
+// ============================================================================
+
+Error AsmCache::init(const char* directory) noexcept {
+  reset();
+
+  size_t size = strlen(directory);
+  while (size > 1 && (directory[size - 1] == '/' || directory[size - 1] == '\\'))
+    size--;
+
+  if (ASMJIT_UNLIKELY(!size))
+    return make_error(Error::kInvalidArgument);
+
+  char* copy = static_cast<char*>(::malloc(size + 1));
+  if (ASMJIT_UNLIKELY(!copy))
+    return make_error(Error::kOutOfMemory);
+
+  memcpy(copy, directory, size);
+  copy[size] = '\0';
+
+  _directory = copy;
+  _directory_size = size;
+  return Error::kOk;
+}
+
+void AsmCache::reset() noexcept {
+  ::free(_directory);
+
+  _directory = nullptr;
+  _directory_size = 0;
+  _stats = Stats();
+}
+
+// ============================================================================
+// [asmtk::AsmCache - Cache Operations]
+// ============================================================================
+
+bool AsmCache::is_cacheable(BaseEmitter* emitter) noexcept {
+  CodeHolder* code = emitter->code();
+  if (!code || !emitter->is_assembler())
+    return false;
+
+  // The machine code would depend on the existing content otherwise.
+  return code->section_count() == 1 &&
+         code->label_count() == 0 &&
+         code->text_section()->buffer().size() == 0;
+}
+
+AsmCache::Key AsmCache::make_key(BaseEmitter* emitter, const char* input, size_t size) noexcept {
+  CodeHolder* code = emitter->code();
+
+  uint64_t seed = uint64_t(ASMTK_LIBRARY_VERSION) ^
+                  (uint64_t(ASMJIT_LIBRARY_VERSION) << 24) ^
+                  (uint64_t(emitter->arch()) << 56) ^
+                  hash_fmix(code->base_address()) ^
+                  hash_fmix(uint64_t(emitter->encoding_options()) + kFormatVersion);
+
+  Key key;
+  hash_input(reinterpret_cast<const uint8_t*>(input), size, seed, key.hash);
+  key.input_size = size;
+  return key;
+}
+
+Error AsmCache::load(BaseEmitter* emitter, const Key& key, uint32_t* current_global_label_id, bool* hit) noexcept {
+  ASMJIT_ASSERT(is_cacheable(emitter));
+  *hit = false;
+
+  CachePath path;
+  MappedFile file;
+
+  if (!is_initialized() || !path.init(*this, key, "") || file.open(path.data) != Error::kOk) {
+    _stats.miss_count++;
+    return Error::kOk;
+  }
+
+  CacheFileHeader expected;
+  init_header(expected, emitter, key);
+
+  CacheFileLayout layout;
+  const uint8_t* data = file.data();
+
+  if (!validate_entry(data, file.size(), expected, layout)) {
+    _stats.miss_count++;
+    return Error::kOk;
+  }
+
+  const CacheFileHeader* header = reinterpret_cast<const CacheFileHeader*>(data);
+  const CacheLabel* labels = reinterpret_cast<const CacheLabel*>(data + layout.labels_offset);
+  const uint32_t* bind_order = reinterpret_cast<const uint32_t*>(data + layout.bind_order_offset);
+  const char* names = reinterpret_cast<const char*>(data + layout.names_offset);
+  const uint8_t* code = data + layout.code_offset;
+
+  // Labels are created in the order of their ids, which makes them get the same ids as they had.
+  for (uint32_t i = 0; i < header->label_count; i++) {
+    const CacheLabel& cl = labels[i];
+    Label label = emitter->new_named_label(names + cl.name_offset, cl.name_size, LabelType(cl.label_type), cl.parent_id);
+
+    if (ASMJIT_UNLIKELY(!label.is_valid()))
+      return make_error(Error::kOutOfMemory);
+
+    if (ASMJIT_UNLIKELY(label.id() != i))
+      return make_error(Error::kInvalidState);
+  }
+
+  // Labels are bound in the order of their offsets while the machine code is copied.
+  size_t offset = 0;
+  for (uint32_t i = 0; i < header->label_count; i++) {
+    uint32_t label_id = bind_order[i];
+    size_t label_offset = size_t(labels[label_id].offset);
+
+    if (label_offset > offset) {
+      ASMJIT_PROPAGATE(emitter->embed(code + offset, label_offset - offset));
+      offset = label_offset;
+    }
+
+    ASMJIT_PROPAGATE(emitter->bind(Label(label_id)));
+  }
+
+  if (size_t(header->code_size) > offset)
+    ASMJIT_PROPAGATE(emitter->embed(code + offset, size_t(header->code_size) - offset));
+
+  *current_global_label_id = header->current_global_label_id;
+  *hit = true;
+
+  _stats.hit_count++;
+  return Error::kOk;
+}
+
+void AsmCache::store(BaseEmitter* emitter, const Key& key, uint32_t current_global_label_id) noexcept {
+  if (!is_initialized())
+    return;
+
+  CodeHolder* code = emitter->code();
+  if (code->section_count() != 1 || code->reloc_count() != 0 || code->has_unresolved_fixups())
+    return;
+
+  size_t label_count = code->label_count();
+  size_t names_size = 0;
+
+  for (size_t i = 0; i < label_count; i++) {
+    const LabelEntry& le = code->label_entry_of(uint32_t(i));
+    if (!le.has_name() || !le.is_bound() || le.section_id() != 0)
+      return;
+    names_size += le.name_size();
+  }
+
+  const CodeBuffer& buffer = code->text_section()->buffer();
+
+  CacheFileLayout layout;
+  if (!layout.init(label_count, names_size, buffer.size()))
+    return;
+
+  uint8_t* data = static_cast<uint8_t*>(::calloc(1, layout.file_size));
+  if (!data)
+    return;
+
+  CacheFileHeader* header = reinterpret_cast<CacheFileHeader*>(data);
+  init_header(*header, emitter, key);
+  header->label_count = uint32_t(label_count);
+  header->current_global_label_id = current_global_label_id;
+  header->names_size = uint32_t(names_size);
+  header->code_size = buffer.size();
+
+  CacheLabel* labels = reinterpret_cast<CacheLabel*>(data + layout.labels_offset);
+  uint32_t* bind_order = reinterpret_cast<uint32_t*>(data + layout.bind_order_offset);
+  char* names = reinterpret_cast<char*>(data + layout.names_offset);
+
+  uint32_t name_offset = 0;
+  for (size_t i = 0; i < label_count; i++) {
+    const LabelEntry& le = code->label_entry_of(uint32_t(i));
+
+    CacheLabel& cl = labels[i];
+    cl.offset = le.offset();
+    cl.name_offset = name_offset;
+    cl.name_size = le.name_size();
+    cl.parent_id = le.parent_id();
+    cl.label_type = uint32_t(le.label_type());
+
+    memcpy(names + name_offset, le.name(), le.name_size());
+    name_offset += le.name_size();
+    bind_order[i] = uint32_t(i);
+  }
+
+  // Labels bound at the same offset keep the order of their ids. Sorted in place as `std::stable_sort()` may allocate.
+  std::sort(bind_order, bind_order + label_count, [&](uint32_t a, uint32_t b) noexcept {
+    return labels[a].offset < labels[b].offset || (labels[a].offset == labels[b].offset && a < b);
+  });
+
+  memcpy(data + layout.code_offset, buffer.data(), buffer.size());
+
+  // Write to a temporary file first, which is then renamed - readers never see an incomplete entry.
+#if defined(_WIN32)
+  unsigned long long process_id = (unsigned long long)_getpid();
+#else
+  unsigned long long process_id = (unsigned long long)getpid();
+#endif
+
+  char suffix[64];
+  snprintf(suffix, sizeof(suffix), ".%llx.%llx.tmp", process_id,
+    (unsigned long long)std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+  CachePath path;
+  CachePath tmp_path;
+
+  if (path.init(*this, key, "") && tmp_path.init(*this, key, suffix)) {
+    FILE* f = fopen(tmp_path.data, "wb");
+    if (f) {
+      bool ok = fwrite(data, 1, layout.file_size, f) == layout.file_size;
+      ok &= fclose(f) == 0;
+
+      if (ok && rename(tmp_path.data, path.data) == 0)
+        _stats.store_count++;
+      else
+        remove(tmp_path.data);
+    }
+  }
+
+  ::free(data);
+}
+
+} // {asmtk}
@@ -0,0 +1,115 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_ASMCACHE_H
+#define _ASMTK_ASMCACHE_H
+
+#include "./globals.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::AsmCache]
+// ============================================================================
+
+//! Persistent cache of assembled code, see `AsmParser::set_cache()`.
+//!
+//! Each entry is a file in the cache directory named after its key, which is a hash of the input, the architecture,
+//! the base address, the encoding options of the emitter, and the versions of AsmTK and AsmJit. The file contains
+//! the machine code and the labels of the parsed input in a format that is used directly from a read-only mapping,
+//! so a cache hit maps the file, creates the labels, and copies the machine code to the emitter.
+//!
+//! Only results that can be reproduced exactly are cached - the input must be parsed by an assembler into an empty
+//! `CodeHolder` and the result must not have relocations or unresolved labels (which typically means that the base
+//! address must be known). Other inputs are just parsed.
+//!
+//! Entries are written to a temporary file first, which is then renamed, so a directory can be shared by multiple
+//! threads and processes. A single `AsmCache` instance is not thread-safe as it keeps statistics.
+class AsmCache {
+public:
+  //! Version of the cache file format.
+  static constexpr uint32_t kFormatVersion = 1;
+
+  //! Cache key - 128-bit hash of the input and of everything else the machine code depends on.
+  struct Key {
+    uint64_t hash[2];
+    uint64_t input_size;
+  };
+
+  //! Cache statistics.
+  struct Stats {
+    //! Number of inputs found in the cache.
+    uint64_t hit_count;
+    //! Number of inputs not found in the cache (or found corrupted).
+    uint64_t miss_count;
+    //! Number of entries written to the cache.
+    uint64_t store_count;
+    //! Number of inputs that were not cacheable (parsed by a builder, into a non-empty `CodeHolder`, etc...).
+    uint64_t bypass_count;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Cache directory (null terminated).
+  char* _directory;
+  size_t _directory_size;
+
+  Stats _stats;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmCache() noexcept;
+  ASMTK_API ~AsmCache() noexcept;
+
+  AsmCache(const AsmCache& other) = delete;
+  AsmCache& operator=(const AsmCache& other) = delete;
+
+  //! \}
+
+  //! \name Initialization
+  //! \{
+
+  //! Uses `directory`, which must exist, as a cache directory.
+  ASMTK_API Error init(const char* directory) noexcept;
+
+  //! Releases the cache directory and resets statistics (the cache files are kept).
+  ASMTK_API void reset() noexcept;
+
+  inline bool is_initialized() const noexcept { return _directory != nullptr; }
+  inline const char* directory() const noexcept { return _directory; }
+
+  inline const Stats& stats() const noexcept { return _stats; }
+
+  //! \}
+
+  //! \name Cache Operations
+  //! \{
+
+  //! Tests whether the result of parsing into `emitter` can be cached.
+  ASMTK_API static bool is_cacheable(asmjit::BaseEmitter* emitter) noexcept;
+
+  //! Calculates the key of `input` of `size` parsed into `emitter`.
+  ASMTK_API static Key make_key(asmjit::BaseEmitter* emitter, const char* input, size_t size) noexcept;
+
+  //! Loads an entry of `key` into `emitter` (which must be cacheable) and sets `hit` to true if the entry was found.
+  //! `current_global_label_id` is set to the last global label bound by the input, which the parser continues with.
+  ASMTK_API Error load(asmjit::BaseEmitter* emitter, const Key& key, uint32_t* current_global_label_id, bool* hit) noexcept;
+
+  //! Stores the content of the `CodeHolder` attached to `emitter` as an entry of `key`. Does nothing if the content
+  //! has relocations or unresolved labels. Failing to write the entry is not an error, as the cache is only an
+  //! optimization.
+  ASMTK_API void store(asmjit::BaseEmitter* emitter, const Key& key, uint32_t current_global_label_id) noexcept;
+
+  //! \}
+};
+
+} // {asmtk}
+
+#endif // _ASMTK_ASMCACHE_H
@@ -0,0 +1,129 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include <algorithm>
+
+#include "./asmdiagnostics.h"
+#include "./scanutils_p.h"
+
+namespace asmtk {
+
+using namespace asmjit;
+
+//! Size of the source indexed at once - the newline index only has to have room for that many more newlines.
+static constexpr size_t kNewlineIndexChunkSize = 4096;
+
+template<typename T>
+static Error diagnostics_reserve(T** data, size_t* capacity, size_t n) noexcept {
+  if (n <= *capacity)
+    return Error::kOk;
+
+  size_t new_capacity = std::max<size_t>(*capacity * 2u, std::max<size_t>(n, 64u));
+  if (ASMJIT_UNLIKELY(new_capacity > SIZE_MAX / sizeof(T)))
+    return make_error(Error::kOutOfMemory);
+
+  T* new_data = static_cast<T*>(::realloc(*data, new_capacity * sizeof(T)));
+  if (ASMJIT_UNLIKELY(!new_data))
+    return make_error(Error::kOutOfMemory);
+
+  *data = new_data;
+  *capacity = new_capacity;
+  return Error::kOk;
+}
+
+// ============================================================================
+// [asmtk::AsmDiagnostics - Construction & Destruction]
+// ============================================================================
+
+AsmDiagnostics::AsmDiagnostics() noexcept
+  : _diagnostics(nullptr),
+    _size(0),
+    _capacity(0),
+    _source(nullptr),
+    _source_size(0),
+    _newlines(nullptr),
+    _newline_count(0),
+    _newline_capacity(0),
+    _has_newline_index(false) {}
+
+AsmDiagnostics::~AsmDiagnostics() noexcept {
+  reset();
+}
+
+// ============================================================================
+// [asmtk::AsmDiagnostics - Diagnostics]
+// ============================================================================
+
+Error AsmDiagnostics::add(size_t offset, size_t size, Error err) noexcept {
+  ASMJIT_PROPAGATE(diagnostics_reserve(&_diagnostics, &_capacity, _size + 1u));
+  _diagnostics[_size++] = Diagnostic{offset, size, err};
+  return Error::kOk;
+}
+
+void AsmDiagnostics::clear() noexcept {
+  _size = 0;
+  set_source(nullptr, 0);
+}
+
+void AsmDiagnostics::reset() noexcept {
+  ::free(_diagnostics);
+  ::free(_newlines);
+
+  _diagnostics = nullptr;
+  _size = 0;
+  _capacity = 0;
+  _newlines = nullptr;
+  _newline_capacity = 0;
+  set_source(nullptr, 0);
+}
+
+// ============================================================================
+// [asmtk::AsmDiagnostics - Source & Locations]
+// ============================================================================
+
+void AsmDiagnostics::set_source(const char* source, size_t size) noexcept {
+  _source = source;
+  _source_size = source ? size : size_t(0);
+  _newline_count = 0;
+  _has_newline_index = false;
+}
+
+Error AsmDiagnostics::build_newline_index() noexcept {
+  if (_has_newline_index)
+    return Error::kOk;
+
+  if (ASMJIT_UNLIKELY(!_source))
+    return make_error(Error::kInvalidState);
+
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(_source);
+  size_t count = 0;
+
+  for (size_t i = 0; i < _source_size; i += kNewlineIndexChunkSize) {
+    size_t n = std::min(_source_size - i, kNewlineIndexChunkSize);
+    ASMJIT_PROPAGATE(diagnostics_reserve(&_newlines, &_newline_capacity, count + n));
+    count += ScanUtils::index_newlines(p + i, p + i + n, i, _newlines + count);
+  }
+
+  _newline_count = count;
+  _has_newline_index = true;
+  return Error::kOk;
+}
+
+Error AsmDiagnostics::location_of(size_t offset, Location* out) noexcept {
+  ASMJIT_PROPAGATE(build_newline_index());
+
+  // The line is one plus the number of newlines that precede `offset`.
+  size_t line = (size_t)(std::lower_bound(_newlines, _newlines + _newline_count, offset) - _newlines);
+  size_t line_start = line ? _newlines[line - 1u] + 1u : size_t(0);
+
+  out->line = line + 1u;
+  out->column = offset - line_start + 1u;
+  return Error::kOk;
+}
+
+} // {asmtk}
@@ -0,0 +1,143 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_ASMDIAGNOSTICS_H
+#define _ASMTK_ASMDIAGNOSTICS_H
+
+#include "./globals.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::AsmDiagnostics]
+// ============================================================================
+
+//! Diagnostics collected by `AsmParser` in recovery mode, see `AsmParser::set_diagnostics()`.
+//!
+//! Each diagnostic refers to a failed command by its offset in the input, which is all the parser has to keep when
+//! it fails. Line and column numbers are calculated on demand by `location_of()`, which indexes newlines of the input
+//! the first time it's called, so inputs without errors never pay for it.
+//!
+//! ```
+//! AsmDiagnostics diagnostics;
+//! parser.set_diagnostics(&diagnostics);
+//!
+//! if (parser.parse(input, size) != Error::kOk) {
+//!   for (const AsmDiagnostics::Diagnostic& d : diagnostics.diagnostics()) {
+//!     AsmDiagnostics::Location loc;
+//!     diagnostics.location_of(d.offset, &loc);
+//!     printf("%zu:%zu: %s\n", loc.line, loc.column, DebugUtils::error_as_string(d.err));
+//!   }
+//! }
+//! ```
+class AsmDiagnostics {
+public:
+  //! Failed command.
+  struct Diagnostic {
+    //! Offset of the command in the input, see `AsmParser::current_command_offset()`.
+    size_t offset;
+    //! Size of the command - the rest of the line it starts at.
+    size_t size;
+    //! Error the command failed with.
+    Error err;
+  };
+
+  //! Location in the input (both one-based, the column is in bytes).
+  struct Location {
+    size_t line;
+    size_t column;
+  };
+
+  //! \name Members
+  //! \{
+
+  Diagnostic* _diagnostics;
+  size_t _size;
+  size_t _capacity;
+
+  //! Input the offsets refer to, null if unknown.
+  const char* _source;
+  size_t _source_size;
+
+  //! Offsets of all newlines of the source, built by the first call to `location_of()`.
+  size_t* _newlines;
+  size_t _newline_count;
+  size_t _newline_capacity;
+  bool _has_newline_index;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmDiagnostics() noexcept;
+  ASMTK_API ~AsmDiagnostics() noexcept;
+
+  AsmDiagnostics(const AsmDiagnostics& other) = delete;
+  AsmDiagnostics& operator=(const AsmDiagnostics& other) = delete;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  inline bool is_empty() const noexcept { return _size == 0; }
+  inline size_t size() const noexcept { return _size; }
+
+  inline const Diagnostic& diagnostic_at(size_t index) const noexcept {
+    ASMJIT_ASSERT(index < _size);
+    return _diagnostics[index];
+  }
+
+  inline asmjit::Span<const Diagnostic> diagnostics() const noexcept {
+    return asmjit::Span<const Diagnostic>(_diagnostics, _size);
+  }
+
+  //! \}
+
+  //! \name Diagnostics
+  //! \{
+
+  //! Adds a diagnostic.
+  ASMTK_API Error add(size_t offset, size_t size, Error err) noexcept;
+
+  //! Discards all diagnostics and the source, but keeps the allocated storage.
+  ASMTK_API void clear() noexcept;
+
+  //! Discards all diagnostics and the source and releases the allocated storage.
+  ASMTK_API void reset() noexcept;
+
+  //! \}
+
+  //! \name Source & Locations
+  //! \{
+
+  inline const char* source() const noexcept { return _source; }
+  inline size_t source_size() const noexcept { return _source_size; }
+
+  //! Sets the input the offsets refer to, which must stay valid until the first call to `location_of()`.
+  //!
+  //! `AsmParser::parse()` sets the source to the parsed input and `AsmParser::parse_file()` indexes the file before
+  //! it's unmapped if there are diagnostics. The parser cannot set the source of input provided by `feed()`, which
+  //! the caller has to do if it needs locations.
+  ASMTK_API void set_source(const char* source, size_t size) noexcept;
+
+  //! Maps `offset` of the source to a line and column.
+  //!
+  //! Returns `Error::kInvalidState` if the source is not known, or `Error::kOutOfMemory` if the newline index cannot
+  //! be allocated.
+  ASMTK_API Error location_of(size_t offset, Location* out) noexcept;
+
+  //! Builds the newline index of the source, which is otherwise built by the first call to `location_of()`. The
+  //! source is not needed afterwards.
+  ASMTK_API Error build_newline_index() noexcept;
+
+  //! \}
+};
+
+} // {asmtk}
+
+#endif // _ASMTK_ASMDIAGNOSTICS_H
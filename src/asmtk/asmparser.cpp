@@ -8,13 +8,52 @@
 
 #include <asmjit/x86.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "./asmparser.h"
+#include "./labelutils_p.h"
+#include "./mappedfile_p.h"
 #include "./parserutils.h"
+#include "./scanutils_p.h"
+#include "./strtod.h"
+#include "./threadutils_p.h"
+#include "./x86mnemonics_p.h"
+#include "./x86registers_p.h"
 
 namespace asmtk {
 
 using namespace asmjit;
 
+// ============================================================================
+// [asmtk::AsmParser - Statistics]
+// ============================================================================
+
+// Statistics are only collected if AsmTK is compiled with ASMTK_STATISTICS, otherwise the macros expand to nothing.
+// Timers don't include the time spent by tokenizing in between, see `AsmParserStatistics`.
+#if defined(ASMTK_STATISTICS)
+static inline uint64_t stat_now() noexcept {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static inline size_t stat_emitter_offset(const AsmParser& parser) noexcept {
+  BaseEmitter* emitter = parser._emitter;
+  return emitter->is_assembler() ? static_cast<BaseAssembler*>(emitter)->offset() : size_t(0);
+}
+
+  #define ASMTK_STAT_INC(parser, field) ((parser)._statistics.field++)
+  #define ASMTK_STAT_ADD(parser, field, value) ((parser)._statistics.field += uint64_t(value))
+  #define ASMTK_STAT_TIMER_START(parser, name) uint64_t name = stat_now() - (parser)._statistics.tokenize_time
+  #define ASMTK_STAT_TIMER_STOP(parser, field, name) ((parser)._statistics.field += stat_now() - (parser)._statistics.tokenize_time - name)
+#else
+  #define ASMTK_STAT_INC(parser, field) ((void)(parser))
+  #define ASMTK_STAT_ADD(parser, field, value) ((void)(parser))
+  #define ASMTK_STAT_TIMER_START(parser, name) ((void)0)
+  #define ASMTK_STAT_TIMER_STOP(parser, field, name) ((void)0)
+#endif
+
 // ============================================================================
 // [asmtk::X86Directive]
 // ============================================================================
@@ -25,51 +64,119 @@ enum X86Directive : uint32_t {
   kX86DirectiveDB,
   kX86DirectiveDW,
   kX86DirectiveDD,
-  kX86DirectiveDQ
+  kX86DirectiveDQ,
+  kX86DirectiveHalf,
+  kX86DirectiveFloat,
+  kX86DirectiveDouble,
+  kX86DirectiveIncbin
 };
 
 // ============================================================================
-// [asmtk::X86Alias]
+// [asmtk::AsmLabelCache]
 // ============================================================================
 
-enum X86Alias : uint32_t {
-  kX86AliasStart = 0x00010000u,
+AsmLabelCache::AsmLabelCache() noexcept
+  : _entries(nullptr),
+    _capacity(0),
+    _size(0),
+    _code(nullptr),
+    _label_count(0) {}
+
+AsmLabelCache::~AsmLabelCache() noexcept {
+  reset();
+}
+
+Error AsmLabelCache::insert(uint32_t hash, uint32_t label_id) noexcept {
+  ASMJIT_ASSERT(label_id != Globals::kInvalidId);
 
-  kX86AliasInsb = kX86AliasStart,
-  kX86AliasInsd,
-  kX86AliasInsw,
+  // Keep the load factor below 0.5 so probe sequences stay short.
+  if (ASMJIT_UNLIKELY((_size + 1u) * 2u > _capacity)) {
+    uint32_t new_capacity = _capacity ? _capacity * 2u : kInitialCapacity;
+    if (ASMJIT_UNLIKELY(new_capacity > 0x80000000u))
+      return make_error(Error::kOutOfMemory);
 
-  kX86AliasOutsb,
-  kX86AliasOutsd,
-  kX86AliasOutsw,
+    Entry* new_entries = static_cast<Entry*>(::malloc(size_t(new_capacity) * sizeof(Entry)));
+    if (ASMJIT_UNLIKELY(!new_entries))
+      return make_error(Error::kOutOfMemory);
 
-  kX86AliasCmpsb,
-  kX86AliasCmpsd,
-  kX86AliasCmpsq,
-  kX86AliasCmpsw,
+    memset(new_entries, 0xFF, size_t(new_capacity) * sizeof(Entry));
 
-  kX86AliasMovsb,
-  kX86AliasMovsd,
-  kX86AliasMovsq,
-  kX86AliasMovsw,
+    uint32_t new_mask = new_capacity - 1u;
+    for (uint32_t i = 0; i < _capacity; i++) {
+      const Entry& entry = _entries[i];
+      if (entry.label_id == Globals::kInvalidId)
+        continue;
 
-  kX86AliasLodsb,
-  kX86AliasLodsd,
-  kX86AliasLodsq,
-  kX86AliasLodsw,
+      uint32_t index = index_of(entry.hash, new_capacity);
+      while (new_entries[index].label_id != Globals::kInvalidId)
+        index = (index + 1u) & new_mask;
+      new_entries[index] = entry;
+    }
 
-  kX86AliasScasb,
-  kX86AliasScasd,
-  kX86AliasScasq,
-  kX86AliasScasw,
+    ::free(_entries);
+    _entries = new_entries;
+    _capacity = new_capacity;
+  }
 
-  kX86AliasStosb,
-  kX86AliasStosd,
-  kX86AliasStosq,
-  kX86AliasStosw,
+  uint32_t mask = _capacity - 1u;
+  uint32_t index = index_of(hash, _capacity);
 
-  kX86AliasJrcxz,
-};
+  while (_entries[index].label_id != Globals::kInvalidId)
+    index = (index + 1u) & mask;
+
+  _entries[index].hash = hash;
+  _entries[index].label_id = label_id;
+  _size++;
+
+  return Error::kOk;
+}
+
+void AsmLabelCache::clear() noexcept {
+  if (_size)
+    memset(_entries, 0xFF, size_t(_capacity) * sizeof(Entry));
+
+  _size = 0;
+  _code = nullptr;
+  _label_count = 0;
+}
+
+void AsmLabelCache::reset() noexcept {
+  ::free(_entries);
+
+  _entries = nullptr;
+  _capacity = 0;
+  _size = 0;
+  _code = nullptr;
+  _label_count = 0;
+}
+
+// ============================================================================
+// [asmtk::AsmValidationCache]
+// ============================================================================
+
+AsmValidationCache::AsmValidationCache() noexcept
+  : _entries(nullptr) {}
+
+AsmValidationCache::~AsmValidationCache() noexcept {
+  reset();
+}
+
+void AsmValidationCache::insert(const Key& key, Error err) noexcept {
+  if (ASMJIT_UNLIKELY(!_entries)) {
+    _entries = static_cast<Entry*>(::calloc(kCapacity, sizeof(Entry)));
+    if (ASMJIT_UNLIKELY(!_entries))
+      return;
+  }
+
+  Entry& entry = _entries[index_of(key)];
+  entry.key = key;
+  entry.err = err;
+}
+
+void AsmValidationCache::reset() noexcept {
+  ::free(_entries);
+  _entries = nullptr;
+}
 
 // ============================================================================
 // [asmtk::AsmParser]
@@ -77,246 +184,424 @@ enum X86Alias : uint32_t {
 
 AsmParser::AsmParser(BaseEmitter* emitter) noexcept
   : _emitter(emitter),
+    _stream_index(0),
+    _stream_value_index(0),
+    _use_stream(false),
     _current_command_offset(0),
     _current_global_label_id(Globals::kInvalidId),
     _unknown_symbol_handler(nullptr),
-    _unknown_symbol_handler_data(nullptr) {}
-AsmParser::~AsmParser() noexcept {}
+    _unknown_symbol_handler_data(nullptr),
+    _feed_buffer(nullptr),
+    _feed_size(0),
+    _feed_capacity(0),
+    _feed_offset(0),
+    _input_offset(0),
+    _record(nullptr),
+    _pipeline(nullptr),
+    _cache(nullptr),
+    _diagnostics(nullptr),
+    _include_dir(nullptr),
+    _has_included_files(false),
+    _validation(AsmValidation::kAlways),
+    _validation_interval(64),
+    _validation_counter(0) {}
+
+AsmParser::~AsmParser() noexcept {
+  ::free(_feed_buffer);
+}
 
-// ============================================================================
-// [asmtk::AsmParser - Input]
-// ============================================================================
+void AsmParser::reset() noexcept {
+  ASMJIT_ASSERT(_pipeline == nullptr);
 
-AsmTokenType AsmParser::next_token(AsmToken* token, ParseFlags flags) noexcept {
-  return _tokenizer.next(token, flags);
+  set_input("", 0);
+  _current_global_label_id = Globals::kInvalidId;
+
+  _unknown_symbol_handler = nullptr;
+  _unknown_symbol_handler_data = nullptr;
+
+  _label_cache.clear();
+
+  _feed_size = 0;
+  _feed_offset = 0;
+
+  _record = nullptr;
+  _cache = nullptr;
+  _diagnostics = nullptr;
+  _include_dir = nullptr;
+  _has_included_files = false;
+  set_validation(AsmValidation::kAlways);
 }
 
-void AsmParser::put_token_back(AsmToken* token) noexcept {
-  _tokenizer.put_back(token);
+void AsmParser::attach(BaseEmitter* emitter) noexcept {
+  _emitter = emitter;
+  reset();
 }
 
 // ============================================================================
-// [asmtk::AsmParser - Parse]
+// [asmtk::AsmTokenPipeline]
 // ============================================================================
 
-static void str_to_lower(uint8_t* dst, const uint8_t* src, size_t size) noexcept{
-  for (size_t i = 0; i < size; i++)
-    dst[i] = Support::ascii_to_lower<uint8_t>(uint8_t(src[i]));
+//! Number of token batches in the ring (power of 2).
+static constexpr uint32_t kPipelineSlotCount = 4;
+//! Minimum size of the input that `parse_pipelined()` tokenizes on another thread.
+static constexpr size_t kPipelineMinInputSize = 64 * 1024;
+
+//! Batch of tokens passed from the tokenizer thread to the parser.
+struct AsmTokenPipelineSlot {
+  AsmTokenStream stream;
+  //! Error returned by `AsmTokenizer::tokenize_all()`, the batch is incomplete if not `Error::kOk`.
+  Error err;
+  //! Tokenizer position at the beginning of the batch, to continue from in case of an error.
+  const uint8_t* start;
+};
+
+//! Single-producer/single-consumer ring of token batches - the tokenizer thread fills the slot at `head`, the parser
+//! takes the slot at `tail` by swapping it with its own stream, which recycles the storage of the consumed batch.
+struct AsmTokenPipeline {
+  AsmTokenPipelineSlot slots[kPipelineSlotCount];
+
+  //! Number of batches produced, written by the tokenizer thread.
+  alignas(64) std::atomic<uint32_t> head;
+  //! Number of batches consumed, written by the parser.
+  alignas(64) std::atomic<uint32_t> tail;
+  //! Set by the parser to stop the tokenizer thread early.
+  std::atomic<bool> stop;
+  //! Set by the parser after it received the last batch.
+  bool finished;
+
+  std::thread thread;
+
+  inline AsmTokenPipeline() noexcept
+    : head(0),
+      tail(0),
+      stop(false),
+      finished(false) {}
+};
+
+static inline bool is_last_batch(const AsmTokenPipelineSlot& slot) noexcept {
+  const AsmTokenStream& stream = slot.stream;
+  return slot.err != Error::kOk || stream.is_empty() || stream.types()[stream.size() - 1u] == AsmTokenType::kEnd;
 }
 
-#define COMB_CHAR_2(a, b) \
-  ((uint32_t(a) << 8) | uint32_t(b))
+// Runs on the tokenizer thread. The tokenizer is not touched by the parser until it receives the last batch.
+static void pipeline_produce(AsmTokenPipeline* pipeline, AsmTokenizer* tokenizer) noexcept {
+  uint32_t head = 0;
 
-#define COMB_CHAR_4(a, b, c, d) \
-  ((uint32_t(a) << 24) | (uint32_t(b) << 16) | (uint32_t(c) << 8) | uint32_t(d))
+  for (;;) {
+    while (head - pipeline->tail.load(std::memory_order_acquire) == kPipelineSlotCount) {
+      if (pipeline->stop.load(std::memory_order_relaxed))
+        return;
+      std::this_thread::yield();
+    }
 
-static uint32_t x86_register_count(Arch arch, RegType reg_type) noexcept {
-  if (arch == Arch::kX86)
-    return 8;
+    if (pipeline->stop.load(std::memory_order_relaxed))
+      return;
 
-  if (reg_type == RegType::kX86_St || reg_type == RegType::kX86_Mm || reg_type == RegType::kMask || reg_type == RegType::kTile)
-    return 8;
+    AsmTokenPipelineSlot& slot = pipeline->slots[head & (kPipelineSlotCount - 1u)];
+    slot.start = tokenizer->_cur;
+    slot.stream.clear();
+    slot.err = tokenizer->tokenize_all(slot.stream, AsmParser::kTokenBatchSize);
 
-  if (reg_type == RegType::kVec128 || reg_type == RegType::kVec256 || reg_type == RegType::kVec512)
-    return 32;
+    bool last = is_last_batch(slot);
+    pipeline->head.store(++head, std::memory_order_release);
 
-  return 16;
+    if (last)
+      return;
+  }
 }
 
-static bool x86_parse_register(AsmParser& parser, Operand_& op, const uint8_t* s, size_t size) noexcept {
-  constexpr uint32_t kMinSize = 2;
-  constexpr uint32_t kMaxSize = 5;
+// Stops the tokenizer thread, after which the tokenizer belongs to the parser again (can be called more than once).
+static void pipeline_stop(AsmTokenPipeline& pipeline) noexcept {
+  pipeline.stop.store(true, std::memory_order_relaxed);
+  if (pipeline.thread.joinable())
+    pipeline.thread.join();
+  pipeline.finished = true;
+}
 
-  if (size < kMinSize || size > kMaxSize)
+// Replaces the parser's stream by the next batch, returns false if there is no batch, in which case the parser has
+// to continue tokenizing on demand.
+static bool pipeline_receive(AsmParser& parser) noexcept {
+  AsmTokenPipeline& pipeline = *parser._pipeline;
+  if (pipeline.finished)
     return false;
 
-  const uint8_t* sEnd = s + size;
+  uint32_t tail = pipeline.tail.load(std::memory_order_relaxed);
+  while (pipeline.head.load(std::memory_order_acquire) == tail)
+    std::this_thread::yield();
 
-  uint32_t c0 = Support::ascii_to_lower<uint32_t>(s[0]);
-  uint32_t c1 = Support::ascii_to_lower<uint32_t>(s[1]);
-  uint32_t c2 = size > 2 ? Support::ascii_to_lower<uint32_t>(s[2]) : uint32_t(0);
-  uint32_t cn = (c0 << 8) + c1;
+  AsmTokenPipelineSlot& slot = pipeline.slots[tail & (kPipelineSlotCount - 1u)];
+  bool ok = slot.err == Error::kOk;
 
-  RegType rType = RegType::kNone;
-  uint32_t rId = 0;
+  pipeline.finished = is_last_batch(slot);
+  if (ok)
+    parser._stream.swap(slot.stream);
+  else
+    parser._tokenizer._cur = slot.start;
 
-  static const uint8_t gp_letter_to_reg_index[] = {
-    uint8_t(x86::Gp::kIdAx), // a
-    uint8_t(x86::Gp::kIdBx), // b
-    uint8_t(x86::Gp::kIdCx), // c
-    uint8_t(x86::Gp::kIdDx)  // d
-  };
+  pipeline.tail.store(tail + 1u, std::memory_order_release);
+  return ok;
+}
 
-  static const uint8_t sr_letter_to_reg_index[] = {
-    uint8_t(Reg::kIdBad), // a
-    uint8_t(Reg::kIdBad), // b
-    uint8_t(x86::SReg::kIdCs), // c
-    uint8_t(x86::SReg::kIdDs), // d
-    uint8_t(x86::SReg::kIdEs), // e
-    uint8_t(x86::SReg::kIdFs), // f
-    uint8_t(x86::SReg::kIdGs), // g
-    uint8_t(Reg::kIdBad), // h
-    uint8_t(Reg::kIdBad), // i
-    uint8_t(Reg::kIdBad), // j
-    uint8_t(Reg::kIdBad), // k
-    uint8_t(Reg::kIdBad), // l
-    uint8_t(Reg::kIdBad), // m
-    uint8_t(Reg::kIdBad), // n
-    uint8_t(Reg::kIdBad), // o
-    uint8_t(Reg::kIdBad), // p
-    uint8_t(Reg::kIdBad), // q
-    uint8_t(Reg::kIdBad), // r
-    uint8_t(x86::SReg::kIdSs)  // s
-  };
+// ============================================================================
+// [asmtk::AsmParser - Input]
+// ============================================================================
 
-  // [AL|BL|CL|DL]
-  // [AH|BH|CH|DH]
-  // [AX|BX|CX|DX]
-  // [ES|CS|SS|DS|FS|GS]
-  if (size == 2 && Support::is_between<uint32_t>(c0, 'a', 's')) {
-    if (c0 <= 'd') {
-      rId = gp_letter_to_reg_index[c0 - 'a'];
+// Tokenizes the next token of the stream again with `flags`, which differ from the flags the stream applied to it.
+// The rest of the batch is dropped, the next batch starts after the token.
+static AsmTokenType refetch_token(AsmParser& parser, AsmToken* token, ParseFlags flags) noexcept {
+  // The tokenizer belongs to the tokenizer thread of `parse_pipelined()`, which has to be stopped first. The rest
+  // of the input is tokenized by the parser then.
+  if (parser._pipeline) {
+    pipeline_stop(*parser._pipeline);
+    parser._pipeline = nullptr;
+  }
 
-      rType = RegType::kGp8Lo;
-      if (c1 == 'l') goto Done;
+  parser._tokenizer._cur = parser._stream.input() + parser._stream.offsets()[parser._stream_index];
+  parser._stream.clear();
+  parser._stream_index = 0;
+  parser._stream_value_index = 0;
 
-      rType = RegType::kGp8Hi;
-      if (c1 == 'h') goto Done;
+  return parser._tokenizer.next(token, flags);
+}
 
-      rType = RegType::kGp16;
-      if (c1 == 'x') goto Done;
+// Returns the next token of the stream, which is refilled by tokenizing the next batch of lines when consumed.
+static inline AsmTokenType fetch_token(AsmParser& parser, AsmToken* token, ParseFlags flags) noexcept {
+  if (!parser._use_stream)
+    return parser._tokenizer.next(token, flags);
+
+  if (parser._stream_index == parser._stream.size()) {
+    // Tokenize the next batch of lines. The parser never puts back a token that precedes the end of line, which
+    // terminates each batch, so the previous batch can be discarded.
+    parser._stream.clear();
+    parser._stream_index = 0;
+    parser._stream_value_index = 0;
+
+    if (parser._pipeline) {
+      // The batch was tokenized by the tokenizer thread - if it failed or it was the last one, continue on demand
+      // from where the tokenizer thread stopped. The tokenizer belongs to the tokenizer thread until then.
+      if (ASMJIT_UNLIKELY(!pipeline_receive(parser))) {
+        parser._use_stream = false;
+        return parser._tokenizer.next(token, flags);
+      }
+    }
+    else {
+      const uint8_t* cur = parser._tokenizer._cur;
+      if (ASMJIT_UNLIKELY(parser._tokenizer.tokenize_all(parser._stream, AsmParser::kTokenBatchSize) != Error::kOk)) {
+        // Out of memory - continue tokenizing on demand from where the previous batch ended.
+        parser._stream.clear();
+        parser._tokenizer._cur = cur;
+        parser._use_stream = false;
+        return parser._tokenizer.next(token, flags);
+      }
     }
+  }
 
-    if (c1 == 's') {
-      rId = sr_letter_to_reg_index[c0 - 'a'];
-      rType = RegType::kSegment;
+  // The stream applies the same flags as the parser - `ParseFlags::kNone` except tokens that follow `{`.
+  size_t index = parser._stream_index;
+  ParseFlags stream_flags = index > 0 && parser._stream.types()[index - 1u] == AsmTokenType::kLCurl
+    ? ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes
+    : ParseFlags::kNone;
 
-      if (rId != Reg::kIdBad)
-        goto Done;
-    }
+  if (ASMJIT_UNLIKELY(flags != stream_flags))
+    return refetch_token(parser, token, flags);
 
-    rType = RegType::kGp16;
-    goto TrySpBpSiDi;
+  return parser._stream.fetch(parser._stream_index++, parser._stream_value_index, token);
+}
+
+AsmTokenType AsmParser::next_token(AsmToken* token, ParseFlags flags) noexcept {
+#if defined(ASMTK_STATISTICS)
+  // Only fetches that tokenize are timed, which is when the stream is refilled or when it's not used at all.
+  bool tokenizes = !_use_stream || _stream_index == _stream.size();
+  uint64_t start = tokenizes ? stat_now() : uint64_t(0);
+
+  AsmTokenType type = fetch_token(*this, token, flags);
+
+  if (tokenizes)
+    _statistics.tokenize_time += stat_now() - start;
+  _statistics.token_count[uint32_t(type)]++;
+  return type;
+#else
+  return fetch_token(*this, token, flags);
+#endif
+}
+
+void AsmParser::put_token_back(AsmToken* token) noexcept {
+  ASMTK_STAT_INC(*this, put_back_count);
+
+  // The stream is empty after `refetch_token()`, which tokenized `token` by the tokenizer.
+  if (!_use_stream || _stream.is_empty()) {
+    _tokenizer.put_back(token);
+    return;
   }
 
-  // [SP|BP|SI|DI]
-  // [SPL|BPL|SIL|DIL]
-  // [EAX|EBX|ECX|EDX|ESP|EBP|EDI|ESI]
-  // [RAX|RBX|RCX|RDX|RSP|RBP|RDI|RSI]
-  // [RIP]
-  if (size == 3) {
-    if (c2 == 'l') {
-      rType = RegType::kGp8Lo;
-      goto TrySpBpSiDi;
-    }
+  size_t index = token->_index;
+  ASMJIT_ASSERT(index <= _stream_index);
 
-    if (c0 == 'e' || c0 == 'r') {
-      cn = (c1 << 8) | c2;
-      rType = (c0 == 'e') ? RegType::kGp32 : RegType::kGp64;
+  const AsmTokenType* types = _stream.types();
+  for (size_t i = index; i < _stream_index; i++)
+    _stream_value_index -= size_t(AsmTokenStream::has_value(types[i]));
+  _stream_index = index;
+}
 
-      if (c0 == 'r' && cn == COMB_CHAR_2('i', 'p')) {
-        rType = RegType::kPC;
-        goto Done;
-      }
+// Returns the next token like `AsmParser::next_token()`, which is only called if statistics are collected, as it
+// cannot be inlined.
+static inline AsmTokenType read_token(AsmParser& parser, AsmToken* token, ParseFlags flags = ParseFlags::kNone) noexcept {
+#if defined(ASMTK_STATISTICS)
+  return parser.next_token(token, flags);
+#else
+  return fetch_token(parser, token, flags);
+#endif
+}
 
-      if (cn == COMB_CHAR_2('a', 'x')) { rId = x86::Gp::kIdAx; goto Done; }
-      if (cn == COMB_CHAR_2('d', 'x')) { rId = x86::Gp::kIdDx; goto Done; }
-      if (cn == COMB_CHAR_2('b', 'x')) { rId = x86::Gp::kIdBx; goto Done; }
-      if (cn == COMB_CHAR_2('c', 'x')) { rId = x86::Gp::kIdCx; goto Done; }
+// ============================================================================
+// [asmtk::AsmParser - Emit]
+// ============================================================================
 
-TrySpBpSiDi:
-      if (cn == COMB_CHAR_2('s', 'p')) { rId = x86::Gp::kIdSp; goto Done; }
-      if (cn == COMB_CHAR_2('b', 'p')) { rId = x86::Gp::kIdBp; goto Done; }
-      if (cn == COMB_CHAR_2('s', 'i')) { rId = x86::Gp::kIdSi; goto Done; }
-      if (cn == COMB_CHAR_2('d', 'i')) { rId = x86::Gp::kIdDi; goto Done; }
-    }
+// Calls of the emitter of type `EmitterT`. Calls qualified by the type of the emitter are direct calls of the final
+// overriders instead of virtual calls, which is what `BasicAsmParser` is for. `BaseEmitter` is called virtually.
+template<typename EmitterT>
+struct EmitterCalls {
+  static inline Error bind(BaseEmitter* emitter, const Label& label) noexcept {
+    return static_cast<EmitterT*>(emitter)->EmitterT::bind(label);
   }
 
-  // [R?|R?B|R?W|R?D]
-  if (c0 == 'r') {
-    s++;
-    rType = RegType::kGp64;
-
-    // Handle 'b', 'w', and 'd' suffixes.
-    c2 = Support::ascii_to_lower<uint32_t>(sEnd[-1]);
-    if (c2 == 'b')
-      rType = RegType::kGp8Lo;
-    else if (c2 == 'w')
-      rType = RegType::kGp16;
-    else if (c2 == 'd')
-      rType = RegType::kGp32;
-    sEnd -= (rType != RegType::kGp64);
-  }
-  // [XMM?|YMM?|ZMM?]
-  else if (c0 >= 'x' && c0 <= 'z' && c1 == 'm' && c2 == 'm') {
-    s += 3;
-    rType = RegType(uint32_t(RegType::kVec128) + uint32_t(c0 - 'x'));
+  static inline Error align(BaseEmitter* emitter, AlignMode align_mode, uint32_t alignment) noexcept {
+    return static_cast<EmitterT*>(emitter)->EmitterT::align(align_mode, alignment);
   }
-  // [K?]
-  else if (c0 == 'k') {
-    s++;
-    rType = RegType::kMask;
-  }
-  // [ST?|FP?]
-  else if ((c0 == 's' && c1 == 't') | (c0 == 'f' && c1 == 'p')) {
-    s += 2;
-    rType = RegType::kX86_St;
-  }
-  // [MM?]
-  else if (c0 == 'm' && c1 == 'm') {
-    s += 2;
-    rType = RegType::kX86_Mm;
+
+  static inline Error embed(BaseEmitter* emitter, const void* data, size_t size) noexcept {
+    return static_cast<EmitterT*>(emitter)->EmitterT::embed(data, size);
   }
-  // [BND?]
-  else if (c0 == 'b' && c1 == 'n' && c2 == 'd') {
-    s += 3;
-    rType = RegType::kX86_Bnd;
+
+  // The same as `BaseEmitter::emit_op_array()`, which passes operands that follow `count` as none.
+  static inline Error emit(BaseEmitter* emitter, InstId inst_id, Operand_* operands, uint32_t count) noexcept {
+    for (uint32_t i = count; i < Globals::kMaxOpCount; i++)
+      operands[i].reset();
+    return static_cast<EmitterT*>(emitter)->EmitterT::_emit(inst_id, operands[0], operands[1], operands[2], operands + 3);
   }
-  // [TMM?]
-  else if (c0 == 't' && c1 == 'm' && c2 == 'm') {
-    s += 3;
-    rType = RegType::kTile;
+};
+
+template<>
+struct EmitterCalls<BaseEmitter> {
+  static inline Error bind(BaseEmitter* emitter, const Label& label) noexcept {
+    return emitter->bind(label);
   }
-  // [CR?]
-  else if (c0 == 'c' && c1 == 'r') {
-    s += 2;
-    rType = RegType::kControl;
+
+  static inline Error align(BaseEmitter* emitter, AlignMode align_mode, uint32_t alignment) noexcept {
+    return emitter->align(align_mode, alignment);
   }
-  // [DR?]
-  else if (c0 == 'd' && c1 == 'r') {
-    s += 2;
-    rType = RegType::kDebug;
+
+  static inline Error embed(BaseEmitter* emitter, const void* data, size_t size) noexcept {
+    return emitter->embed(data, size);
   }
-  else {
-    return false;
+
+  static inline Error emit(BaseEmitter* emitter, InstId inst_id, Operand_* operands, uint32_t count) noexcept {
+    return emitter->emit_op_array(inst_id, operands, count);
   }
+};
 
-  // Parse the register index.
-  rId = uint32_t(s[0]) - '0';
-  if (rId >= 10)
-    return false;
+// Parsed commands are passed to the emitter by the following functions, or recorded if the parser has a record.
 
-  if (++s < sEnd) {
-    c0 = uint32_t(*s++) - '0';
-    if (c0 >= 10)
-      return false;
-    rId = rId * 10 + c0;
+template<typename EmitterT>
+static Error emit_bind(AsmParser& parser, const Label& label) noexcept {
+  if (parser._record)
+    return parser._record->add_bind(parser._current_command_offset, label.id());
 
-    // Maximum register
-    if (rId >= x86_register_count(parser.emitter()->arch(), rType))
-      return false;
-  }
+  BaseEmitter* emitter = parser._emitter;
+  ASMJIT_PROPAGATE(EmitterCalls<EmitterT>::bind(emitter, label));
+
+  // Must be valid if we passed through handle_symbol() and bind().
+  LabelEntry& le = emitter->code()->label_entry_of(label);
+
+  if (le.label_type() == LabelType::kGlobal)
+    parser._current_global_label_id = label.id();
+
+  return Error::kOk;
+}
+
+template<typename EmitterT>
+static Error emit_align(AsmParser& parser, AlignMode align_mode, uint32_t alignment) noexcept {
+  if (parser._record)
+    return parser._record->add_align(parser._current_command_offset, align_mode, alignment);
+
+#if defined(ASMTK_STATISTICS)
+  size_t offset = stat_emitter_offset(parser);
+  Error err = EmitterCalls<EmitterT>::align(parser._emitter, align_mode, alignment);
+  ASMTK_STAT_ADD(parser, emitted_size, stat_emitter_offset(parser) - offset);
+  return err;
+#else
+  return EmitterCalls<EmitterT>::align(parser._emitter, align_mode, alignment);
+#endif
+}
+
+template<typename EmitterT>
+static Error emit_embed(AsmParser& parser, const void* data, size_t size) noexcept {
+  if (parser._record)
+    return parser._record->add_embed(parser._current_command_offset, data, size);
+
+#if defined(ASMTK_STATISTICS)
+  size_t offset = stat_emitter_offset(parser);
+  Error err = EmitterCalls<EmitterT>::embed(parser._emitter, data, size);
+  ASMTK_STAT_ADD(parser, emitted_size, stat_emitter_offset(parser) - offset);
+  return err;
+#else
+  return EmitterCalls<EmitterT>::embed(parser._emitter, data, size);
+#endif
+}
+
+template<typename EmitterT>
+static Error emit_inst(AsmParser& parser, const BaseInst& inst, Operand_* operands, uint32_t count) noexcept {
+  if (parser._record)
+    return parser._record->add_inst(parser._current_command_offset, inst, operands, count);
+
+  BaseEmitter* emitter = parser._emitter;
+  emitter->set_inst_options(inst.options());
+  emitter->set_extra_reg(inst.extra_reg());
+
+#if defined(ASMTK_STATISTICS)
+  size_t offset = stat_emitter_offset(parser);
+  ASMTK_STAT_TIMER_START(parser, emit_start);
 
-  // Fail if the whole input wasn't parsed.
-  if (s != sEnd)
+  Error err = EmitterCalls<EmitterT>::emit(emitter, inst.inst_id(), operands, count);
+
+  ASMTK_STAT_TIMER_STOP(parser, emit_time, emit_start);
+  ASMTK_STAT_ADD(parser, emitted_size, stat_emitter_offset(parser) - offset);
+  return err;
+#else
+  return EmitterCalls<EmitterT>::emit(emitter, inst.inst_id(), operands, count);
+#endif
+}
+
+// ============================================================================
+// [asmtk::AsmParser - Parse]
+// ============================================================================
+
+static void str_to_lower(uint8_t* dst, const uint8_t* src, size_t size) noexcept{
+  for (size_t i = 0; i < size; i++)
+    dst[i] = Support::ascii_to_lower<uint8_t>(uint8_t(src[i]));
+}
+
+// Functions that depend on the architecture are specialized for X86 and X64 - `kArch` is selected once by
+// `parse_commands()`, see `parse_command_as()`.
+
+template<Arch kArch>
+static bool x86_parse_register(AsmParser& parser, Operand_& op, const uint8_t* s, size_t size) noexcept {
+  const X86Registers::Entry* entry = X86Registers::lookup(s, size);
+  if (!entry) {
+    ASMTK_STAT_INC(parser, register_miss_count);
     return false;
+  }
+
+  RegType reg_type = entry->reg_type();
+  uint32_t reg_id = entry->reg_id();
 
-  // Fail if the register index is greater than allowed.
-  if (rId >= 32)
+  if (entry->has_two_digit_index() && reg_id >= x86_register_count(kArch, reg_type)) {
+    ASMTK_STAT_INC(parser, register_miss_count);
     return false;
+  }
 
-Done:
-  op._init_reg(RegUtils::signature_of(rType), rId);
+  ASMTK_STAT_INC(parser, register_hit_count);
+  op._init_reg(RegUtils::signature_of(reg_type), reg_id);
   return true;
 }
 
@@ -391,72 +676,86 @@ static uint32_t x86_parse_size(const uint8_t* s, size_t size) noexcept {
   return 0;
 }
 
-static Error handle_symbol(AsmParser& parser, Operand_& dst, const uint8_t* name, size_t name_size) noexcept {
+static Error handle_symbol(AsmParser& parser, Operand_& dst, const AsmToken& token) noexcept {
   // Resolve global/local label.
   BaseEmitter* emitter = parser._emitter;
+  CodeHolder* code = emitter->code();
 
-  const uint8_t* local_name = nullptr;
-  size_t local_name_size = 0;
-  size_t parent_name_size = name_size;
-
-  // Don't do anything if the name starts with "..".
-  if (!(name_size >= 2 && name[0] == '.' && name[1] == '.')) {
-    local_name = static_cast<const uint8_t*>(memchr(name, '.', name_size));
-    if (local_name) {
-      parent_name_size = (size_t)(local_name - name);
-      local_name++;
-      local_name_size = (size_t)((name + name_size) - local_name);
-    }
+  const uint8_t* name = token.data();
+  size_t name_size = token.size();
+
+  // When recording, symbols are resolved when the record is replayed, see `AsmRecord`.
+  if (parser._record) {
+    uint32_t symbol_index;
+    ASMJIT_PROPAGATE(parser._record->add_symbol(name, name_size, token.symbol_hash(), token.symbol_dot_index(), &symbol_index));
+
+    dst = Label(symbol_index);
+    return Error::kOk;
   }
 
-  Label parent;
-  Label label;
+  LabelUtils::SymbolName symbol = LabelUtils::split_symbol_name(name, name_size, token.symbol_dot_index());
 
-  if (local_name) {
-    if (name[0] == '.')
-      parent.set_id(parser._current_global_label_id);
-    else
-      parent = emitter->label_by_name(reinterpret_cast<const char*>(name), parent_name_size);
+  // The symbol hash calculated by the tokenizer keys the label cache, which saves hashing the name again by
+  // `label_by_name()` (twice in case of "parent.local"). Names starting with '.' depend on the current global label,
+  // so it's mixed into the hash.
+  uint32_t current_parent_id = symbol.is_relative() ? parser._current_global_label_id : Globals::kInvalidId;
+  uint32_t hash = token.symbol_hash() ^ (current_parent_id * 0x9E3779B9u);
 
-    if (parent.is_valid())
-      label = emitter->label_by_name(reinterpret_cast<const char*>(local_name), local_name_size, parent.id());
-  }
-  else {
-    label = emitter->label_by_name(reinterpret_cast<const char*>(name), name_size, parent.id());
+  if (code) {
+    AsmLabelCache& cache = parser._label_cache;
+    cache.sync(code);
+
+    uint32_t label_id = cache.find(hash, [&](uint32_t candidate_id) noexcept {
+      if (!symbol.has_local_name())
+        return LabelUtils::is_label_named(code, candidate_id, name, name_size, Globals::kInvalidId);
+
+      if (symbol.is_relative())
+        return LabelUtils::is_label_named(code, candidate_id, symbol.local_name, symbol.local_name_size, current_parent_id);
+
+      if (candidate_id >= code->label_count())
+        return false;
+
+      uint32_t parent_id = code->label_entry_of(candidate_id).parent_id();
+      return LabelUtils::is_label_named(code, candidate_id, symbol.local_name, symbol.local_name_size, parent_id) &&
+             LabelUtils::is_label_named(code, parent_id, name, symbol.parent_name_size, Globals::kInvalidId);
+    });
+
+    if (label_id != Globals::kInvalidId) {
+      ASMTK_STAT_INC(parser, label_hit_count);
+      dst = Label(label_id);
+      return Error::kOk;
+    }
   }
 
+  ASMTK_STAT_INC(parser, label_miss_count);
+
+  Label parent;
+  Label label = LabelUtils::find_label(emitter, symbol, parser._current_global_label_id, &parent);
+
   if (!label.is_valid()) {
     if (parser._unknown_symbol_handler) {
       dst.reset();
+      ASMTK_STAT_INC(parser, unknown_symbol_handler_count);
       ASMJIT_PROPAGATE(parser._unknown_symbol_handler(&parser, static_cast<Operand*>(&dst), reinterpret_cast<const char*>(name), name_size));
       if (!dst.is_none())
         return Error::kOk;
     }
 
-    if (local_name) {
-      if (!parent.is_valid()) {
-        if (!parent_name_size)
-          return make_error(Error::kInvalidParentLabel);
+    ASMJIT_PROPAGATE(LabelUtils::new_label(emitter, symbol, parent, &label));
+  }
 
-        parent = emitter->new_named_label(reinterpret_cast<const char*>(name), parent_name_size, LabelType::kGlobal);
-        if (!parent.is_valid())
-          return make_error(Error::kOutOfMemory);
-      }
-      label = emitter->new_named_label(reinterpret_cast<const char*>(local_name), local_name_size, LabelType::kLocal, parent.id());
-      if (!label.is_valid())
-        return make_error(Error::kOutOfMemory);
-    }
-    else {
-      label = emitter->new_named_label(reinterpret_cast<const char*>(name), name_size, LabelType::kGlobal);
-      if (!label.is_valid())
-        return make_error(Error::kOutOfMemory);
-    }
+  if (code) {
+    AsmLabelCache& cache = parser._label_cache;
+    // The label is already resolved, the cache is only an optimization, so a failed insert is ignored.
+    (void)cache.insert(hash, label.id());
+    cache.sync(code);
   }
 
   dst = label;
   return Error::kOk;
 }
 
+template<Arch kArch>
 static Error x86_parse_operand(AsmParser& parser, Operand_& dst, AsmToken* token) noexcept {
   AsmTokenType type = token->type();
   uint32_t mem_size = 0;
@@ -465,15 +764,15 @@ static Error x86_parse_operand(AsmParser& parser, Operand_& dst, AsmToken* token
   // Symbol, could be register, memory operand size, or label.
   if (type == AsmTokenType::kSym) {
     // Try register.
-    if (x86_parse_register(parser, dst, token->data(), token->size())) {
+    if (x86_parse_register<kArch>(parser, dst, token->data(), token->size())) {
       if (!dst.as<Reg>().is_segment_reg())
         return Error::kOk;
 
       // A segment register followed by a colon (':') describes a segment of a
       // memory operand - in such case we store the segment and jump to MemOp.
       AsmToken tTmp;
-      if (parser.next_token(token) == AsmTokenType::kColon &&
-          parser.next_token(&tTmp) == AsmTokenType::kLBracket) {
+      if (read_token(parser, token) == AsmTokenType::kColon &&
+          read_token(parser, &tTmp) == AsmTokenType::kLBracket) {
         seg = dst;
         goto MemOp;
       }
@@ -484,7 +783,7 @@ static Error x86_parse_operand(AsmParser& parser, Operand_& dst, AsmToken* token
     // Try memory size specifier.
     mem_size = x86_parse_size(token->data(), token->size());
     if (mem_size) {
-      type = parser.next_token(token);
+      type = read_token(parser, token);
 
       // The specifier may be followed by 'ptr', skip it in such case.
       if (type == AsmTokenType::kSym &&
@@ -492,7 +791,7 @@ static Error x86_parse_operand(AsmParser& parser, Operand_& dst, AsmToken* token
           Support::ascii_to_lower<uint32_t>(token->data_at(0)) == 'p' &&
           Support::ascii_to_lower<uint32_t>(token->data_at(1)) == 't' &&
           Support::ascii_to_lower<uint32_t>(token->data_at(2)) == 'r') {
-        type = parser.next_token(token);
+        type = read_token(parser, token);
       }
 
       // Jump to memory operand if we encountered '['.
@@ -502,14 +801,14 @@ static Error x86_parse_operand(AsmParser& parser, Operand_& dst, AsmToken* token
       // Parse segment prefix otherwise.
       if (type == AsmTokenType::kSym) {
         // Segment register.
-        if (!x86_parse_register(parser, seg, token->data(), token->size()) || !seg.as<Reg>().is_segment_reg())
+        if (!x86_parse_register<kArch>(parser, seg, token->data(), token->size()) || !seg.as<Reg>().is_segment_reg())
           return make_error(Error::kInvalidAddress);
 
-        type = parser.next_token(token);
+        type = read_token(parser, token);
         if (type != AsmTokenType::kColon)
           return make_error(Error::kInvalidAddress);
 
-        type = parser.next_token(token);
+        type = read_token(parser, token);
         if (type == AsmTokenType::kLBracket)
           goto MemOp;
       }
@@ -518,7 +817,7 @@ static Error x86_parse_operand(AsmParser& parser, Operand_& dst, AsmToken* token
     }
 
     // Must be label/symbol.
-    return handle_symbol(parser, dst, token->data(), token->size());
+    return handle_symbol(parser, dst, *token);
   }
 
   // Memory address - parse opening '['.
@@ -532,7 +831,7 @@ MemOp:
     OperandSignature signature{0};
 
     // Parse address prefix - 'abs'.
-    type = parser.next_token(token);
+    type = read_token(parser, token);
     if (type == AsmTokenType::kSym) {
       if (token->size() == 3) {
         ParserUtils::WordParser addr_mode;
@@ -542,11 +841,11 @@ MemOp:
 
         if (addr_mode.test('a', 'b', 's')) {
           signature |= OperandSignature::from_value<x86::Mem::kSignatureMemAddrTypeMask>(x86::Mem::AddrType::kAbs);
-          type = parser.next_token(token);
+          type = read_token(parser, token);
         }
         else if (addr_mode.test('r', 'e', 'l')) {
           signature |= OperandSignature::from_value<x86::Mem::kSignatureMemAddrTypeMask>(x86::Mem::AddrType::kRel);
-          type = parser.next_token(token);
+          type = read_token(parser, token);
         }
       }
     }
@@ -561,15 +860,15 @@ MemOp:
           return make_error(Error::kInvalidAddress);
 
         Operand op;
-        if (!x86_parse_register(parser, op, token->data(), token->size())) {
+        if (!x86_parse_register<kArch>(parser, op, token->data(), token->size())) {
           // No label after 'base' is allowed.
           if (!base.is_none())
             return make_error(Error::kInvalidAddress);
 
-          ASMJIT_PROPAGATE(handle_symbol(parser, op, token->data(), token->size()));
+          ASMJIT_PROPAGATE(handle_symbol(parser, op, *token));
         }
 
-        type = parser.next_token(token);
+        type = read_token(parser, token);
         op_type = AsmTokenType::kInvalid;
 
         if (type != AsmTokenType::kMul) {
@@ -588,7 +887,7 @@ MemOp:
             return make_error(Error::kInvalidAddress);
 
           index = op;
-          type = parser.next_token(token);
+          type = read_token(parser, token);
           if (type != AsmTokenType::kU64)
             return make_error(Error::kInvalidAddressScale);
 
@@ -680,7 +979,7 @@ MemOp:
         return make_error(Error::kInvalidAddress);
       }
 
-      type = parser.next_token(token);
+      type = read_token(parser, token);
     }
   }
 
@@ -688,7 +987,7 @@ MemOp:
   if (type == AsmTokenType::kU64 || type == AsmTokenType::kSub) {
     bool negative = (type == AsmTokenType::kSub);
     if (negative) {
-      type = parser.next_token(token);
+      type = read_token(parser, token);
       if (type != AsmTokenType::kU64)
         return make_error(Error::kInvalidState);
     }
@@ -700,71 +999,6 @@ MemOp:
   return make_error(Error::kInvalidState);
 }
 
-static InstOptions x86_parse_inst_option(const uint8_t* s, size_t size) noexcept {
-  constexpr uint32_t kMinSize = 3;
-  constexpr uint32_t kMaxSize = 8;
-
-  if (size < kMinSize || size > kMaxSize)
-    return InstOptions::kNone;
-
-  ParserUtils::WordParser word;
-
-  // Options of length '3':
-  word.add_lowercased_char(s, 0);
-  word.add_lowercased_char(s, 1);
-  word.add_lowercased_char(s, 2);
-
-  if (size == 3) {
-    if (word.test('b', 'n', 'd')) return InstOptions::kX86_Repne;
-    if (word.test('r', 'e', 'p')) return InstOptions::kX86_Rep;
-    if (word.test('r', 'e', 'x')) return InstOptions::kX86_Rex;
-    if (word.test('v', 'e', 'x')) return InstOptions::kX86_Vex;
-
-    return InstOptions::kNone;
-  }
-
-  // Options of length '4':
-  word.add_lowercased_char(s, 3);
-
-  if (size == 4) {
-    if (word.test('e', 'v', 'e', 'x')) return InstOptions::kX86_Evex;
-    if (word.test('l', 'o', 'c', 'k')) return InstOptions::kX86_Lock;
-    if (word.test('l', 'o', 'n', 'g')) return InstOptions::kLongForm;
-    if (word.test('r', 'e', 'p', 'e')) return InstOptions::kX86_Rep;
-    if (word.test('r', 'e', 'p', 'z')) return InstOptions::kX86_Rep;
-    if (word.test('v', 'e', 'x', '3')) return InstOptions::kX86_Vex3;
-
-    return InstOptions::kNone;
-  }
-
-  // Options of length '5':
-  word.add_lowercased_char(s, 4);
-
-  if (size == 5) {
-    if (word.test('m', 'o', 'd', 'r', 'm')) return InstOptions::kX86_ModRM;
-    if (word.test('m', 'o', 'd', 'm', 'r')) return InstOptions::kX86_ModMR;
-    if (word.test('r', 'e', 'p', 'n', 'e')) return InstOptions::kX86_Repne;
-    if (word.test('r', 'e', 'p', 'n', 'z')) return InstOptions::kX86_Repne;
-    if (word.test('s', 'h', 'o', 'r', 't')) return InstOptions::kShortForm;
-
-    return InstOptions::kNone;
-  }
-
-  // Options of length '8':
-  word.add_lowercased_char(s, 5);
-  word.add_lowercased_char(s, 6);
-  word.add_lowercased_char(s, 7);
-
-  if (size == 8) {
-    if (word.test('x', 'a', 'c', 'q', 'u', 'i', 'r', 'e')) return InstOptions::kX86_XAcquire;
-    if (word.test('x', 'r', 'e', 'l', 'e', 'a', 's', 'e')) return InstOptions::kX86_XRelease;
-
-    return InstOptions::kNone;
-  }
-
-  return InstOptions::kNone;
-}
-
 static InstOptions x86_parse_avx512_option(const uint8_t* s, size_t size) noexcept {
   constexpr uint32_t kMinSize = 3;
   constexpr uint32_t kMaxSize = 6;
@@ -858,100 +1092,209 @@ static uint32_t x86_parse_directive(const uint8_t* s, size_t size) noexcept {
     return 0;
   }
 
-  if (size < 5)
+  if (size < 4)
     return 0;
 
   word.add_lowercased_char(s, 2);
   word.add_lowercased_char(s, 3);
+  if (size == 4) {
+    if (word.test('h', 'a', 'l', 'f')) return kX86DirectiveHalf;
+    return 0;
+  }
+
   word.add_lowercased_char(s, 4);
   if (size == 5) {
     if (word.test('a', 'l', 'i', 'g', 'n')) return kX86DirectiveAlign;
+    if (word.test('f', 'l', 'o', 'a', 't')) return kX86DirectiveFloat;
+    return 0;
+  }
+
+  word.add_lowercased_char(s, 5);
+  if (size == 6) {
+    if (word.test('d', 'o', 'u', 'b', 'l', 'e')) return kX86DirectiveDouble;
+    if (word.test('i', 'n', 'c', 'b', 'i', 'n')) return kX86DirectiveIncbin;
     return 0;
   }
 
   return 0;
 }
 
-static uint32_t x86_parse_alias(const uint8_t* s, size_t size) noexcept {
-  if (size < 3)
-    return x86::Inst::kIdNone;
+// Converts a numeric token to the binary representation of the given floating point `format`. Floating point
+// literals are converted from their text (and not from the already parsed double) so the result is correctly
+// rounded to the target format, integers are converted from their value as they can use any base.
+static Error x86_parse_float_data(const AsmToken& token, AsmTokenType type, FloatFormat format, uint64_t* out) noexcept {
+  bool overflow = false;
 
-  ParserUtils::WordParser word;
-  word.add_lowercased_char(s, 0);
-  word.add_lowercased_char(s, 1);
-  word.add_lowercased_char(s, 2);
-  if (size == 3) {
-    if (word.test('s', 'a', 'l')) return x86::Inst::kIdShl;
-    return x86::Inst::kIdNone;
+  if (type == AsmTokenType::kF64) {
+    if (format == FloatFormat::kF64) {
+      double value = token.f64_value();
+      memcpy(out, &value, sizeof(double));
+      return Error::kOk;
+    }
+
+    StrToD::parse(token.data(), token.size(), format, out, &overflow);
   }
+  else if (type == AsmTokenType::kU64) {
+    uint8_t buf[24];
+    size_t i = sizeof(buf);
+    uint64_t value = token.u64_value();
 
-  word.add_lowercased_char(s, 3);
-  if (size == 4) {
-    if (word.test('i', 'n', 's', 'b')) return kX86AliasInsb;
-    if (word.test('i', 'n', 's', 'w')) return kX86AliasInsw;
-    if (word.test('i', 'n', 's', 'd')) return kX86AliasInsd;
-    return x86::Inst::kIdNone;
+    do {
+      buf[--i] = uint8_t('0' + uint32_t(value % 10u));
+      value /= 10u;
+    } while (value);
+
+    StrToD::parse(buf + i, sizeof(buf) - i, format, out, &overflow);
+  }
+  else if (type == AsmTokenType::kInvalid && StrToD::parse(token.data(), token.size(), format, out) == token.size()) {
+    // A literal that doesn't fit a double (or an integer that doesn't fit 64 bits) is an invalid token.
+    return make_error(Error::kInvalidImmediate);
+  }
+  else {
+    return make_error(Error::kInvalidState);
   }
 
-  word.add_lowercased_char(s, 4);
-  if (size == 5) {
-    if (word.test('c', 'm', 'p', 's', 'b')) return kX86AliasCmpsb;
-    if (word.test('c', 'm', 'p', 's', 'w')) return kX86AliasCmpsw;
-    if (word.test('c', 'm', 'p', 's', 'd')) return kX86AliasCmpsd;
-    if (word.test('c', 'm', 'p', 's', 'q')) return kX86AliasCmpsq;
-
-    if (word.test('l', 'o', 'd', 's', 'b')) return kX86AliasLodsb;
-    if (word.test('l', 'o', 'd', 's', 'w')) return kX86AliasLodsw;
-    if (word.test('l', 'o', 'd', 's', 'd')) return kX86AliasLodsd;
-    if (word.test('l', 'o', 'd', 's', 'q')) return kX86AliasLodsq;
-
-    if (word.test('m', 'o', 'v', 's', 'b')) return kX86AliasMovsb;
-    if (word.test('m', 'o', 'v', 's', 'w')) return kX86AliasMovsw;
-    if (word.test('m', 'o', 'v', 's', 'd')) return kX86AliasMovsd;
-    if (word.test('m', 'o', 'v', 's', 'q')) return kX86AliasMovsq;
-
-    if (word.test('s', 'c', 'a', 's', 'b')) return kX86AliasScasb;
-    if (word.test('s', 'c', 'a', 's', 'w')) return kX86AliasScasw;
-    if (word.test('s', 'c', 'a', 's', 'd')) return kX86AliasScasd;
-    if (word.test('s', 'c', 'a', 's', 'q')) return kX86AliasScasq;
-
-    if (word.test('s', 't', 'o', 's', 'b')) return kX86AliasStosb;
-    if (word.test('s', 't', 'o', 's', 'w')) return kX86AliasStosw;
-    if (word.test('s', 't', 'o', 's', 'd')) return kX86AliasStosd;
-    if (word.test('s', 't', 'o', 's', 'q')) return kX86AliasStosq;
-
-    if (word.test('o', 'u', 't', 's', 'b')) return kX86AliasOutsb;
-    if (word.test('o', 'u', 't', 's', 'w')) return kX86AliasOutsw;
-    if (word.test('o', 'u', 't', 's', 'd')) return kX86AliasOutsd;
-
-    if (word.test('j', 'r', 'c', 'x', 'z')) return kX86AliasJrcxz;
-
-    return x86::Inst::kIdNone;
+  if (overflow)
+    return make_error(Error::kInvalidImmediate);
+
+  return Error::kOk;
+}
+
+//! Length of `.incbin` that embeds the file from the offset to its end.
+static constexpr uint64_t kIncbinRestOfFile = ~uint64_t(0);
+
+static inline bool is_path_separator(char c) noexcept {
+  return c == '/' || c == '\\';
+}
+
+// Tests whether `path` stays within the directory it's relative to - it must not be absolute (on any host, so the
+// same input is rejected everywhere), must not contain a drive or a null character, and must not have `..` components.
+static bool is_contained_path(const char* path, size_t size) noexcept {
+  if (is_path_separator(path[0]))
+    return false;
+
+  size_t component = 0;
+  for (size_t i = 0; i <= size; i++) {
+    if (i == size || is_path_separator(path[i])) {
+      if (i - component == 2 && path[component] == '.' && path[component + 1] == '.')
+        return false;
+      component = i + 1;
+    }
+    else if (path[i] == ':' || path[i] == '\0') {
+      return false;
+    }
   }
 
-  return x86::Inst::kIdNone;
+  return true;
 }
 
+// Embeds `length` bytes at `offset` of a file `path` (without quotes), or the rest of the file if `length` is
+// `kIncbinRestOfFile`. The file is mapped and embedded from the mapping. Including files must be enabled by
+// `AsmParser::set_include_dir()` and `path` must be relative to the include directory without leaving it.
+template<typename EmitterT>
+static Error embed_file(AsmParser& parser, const char* path, size_t path_size, uint64_t offset, uint64_t length) noexcept {
+  const char* include_dir = parser._include_dir;
+  if (ASMJIT_UNLIKELY(!include_dir || !include_dir[0]))
+    return make_error(Error::kInvalidDirective);
+
+  if (ASMJIT_UNLIKELY(!path_size || !is_contained_path(path, path_size)))
+    return make_error(Error::kInvalidArgument);
+
+  StringTmp<256> resolved;
+  ASMJIT_PROPAGATE(resolved.append(include_dir));
+  if (!is_path_separator(resolved.data()[resolved.size() - 1]))
+    ASMJIT_PROPAGATE(resolved.append('/'));
+  ASMJIT_PROPAGATE(resolved.append(path, path_size));
+
+  MappedFile file;
+  ASMJIT_PROPAGATE(file.open(resolved.data()));
+
+  if (ASMJIT_UNLIKELY(offset > file.size()))
+    return make_error(Error::kInvalidArgument);
+
+  size_t available = file.size() - size_t(offset);
+  if (length == kIncbinRestOfFile)
+    length = available;
+  else if (ASMJIT_UNLIKELY(length > available))
+    return make_error(Error::kInvalidArgument);
+
+  parser._has_included_files = true;
+
+  if (!length)
+    return Error::kOk;
+  return emit_embed<EmitterT>(parser, file.data() + size_t(offset), size_t(length));
+}
+
+template<uint32_t kSize>
+static inline void copy_data_values(char* dst, const uint64_t* values, size_t count) noexcept {
+  for (size_t i = 0; i < count; i++)
+    memcpy(dst + i * kSize, values + i, kSize);
+}
+
+// Appends values of a data directive that follow in the token stream as `, value` pairs to `data`, which is reserved
+// once for all of them. The directive continues with the first token that doesn't continue the list, or with a value
+// that doesn't fit, which is then reported as usual.
+static Error append_data_values(AsmParser& parser, uint32_t n_bytes, uint64_t max_value, String& data) noexcept {
+  if (!parser._use_stream)
+    return Error::kOk;
+
+  const AsmTokenStream& stream = parser._stream;
+  const AsmTokenType* types = stream.types();
+  const uint64_t* values = stream.values() + parser._stream_value_index;
+
+  size_t index = parser._stream_index;
+  size_t size = stream.size();
+  size_t count = 0;
+
+  while (size - index >= 2u && types[index] == AsmTokenType::kComma && types[index + 1] == AsmTokenType::kU64 && values[count] <= max_value) {
+    index += 2;
+    count++;
+  }
+
+  if (!count)
+    return Error::kOk;
+
+  char* dst = data.prepare(String::ModifyOp::kAppend, count * n_bytes);
+  if (ASMJIT_UNLIKELY(!dst))
+    return make_error(Error::kOutOfMemory);
+
+  switch (n_bytes) {
+    case 1: copy_data_values<1>(dst, values, count); break;
+    case 2: copy_data_values<2>(dst, values, count); break;
+    case 4: copy_data_values<4>(dst, values, count); break;
+    default: copy_data_values<8>(dst, values, count); break;
+  }
+
+  parser._stream_index = index;
+  parser._stream_value_index += count;
+
+  ASMTK_STAT_ADD(parser, token_count[uint32_t(AsmTokenType::kComma)], count);
+  ASMTK_STAT_ADD(parser, token_count[uint32_t(AsmTokenType::kU64)], count);
+  return Error::kOk;
+}
+
+template<Arch kArch>
 static Error x86_parse_instruction(AsmParser& parser, InstId& inst_id, InstOptions& options, AsmToken* token) noexcept {
   for (;;) {
     size_t size = token->size();
-    uint8_t lower[32];
-
-    if (size > ASMJIT_ARRAY_SIZE(lower))
-      return make_error(Error::kInvalidInstruction);
-
-    str_to_lower(lower, token->data(), size);
+    const X86Mnemonics::Entry* entry = X86Mnemonics::lookup(token->data(), size);
+    ASMTK_STAT_ADD(parser, mnemonic_hit_count, entry != nullptr);
+    ASMTK_STAT_ADD(parser, mnemonic_miss_count, entry == nullptr);
+
+    inst_id = entry ? entry->inst_id : uint32_t(x86::Inst::kIdNone);
+    if (!entry && size > X86Mnemonics::kMaxNameSize) {
+      // Words that don't fit into the table are looked up by AsmJit.
+      uint8_t lower[32];
+      if (size > ASMJIT_ARRAY_SIZE(lower))
+        return make_error(Error::kInvalidInstruction);
 
-    // Try to match instruction alias, as there are some tricky ones.
-    inst_id = x86_parse_alias(lower, size);
-    if (inst_id == x86::Inst::kIdNone) {
-      // If that didn't work out, try to match instruction as defined by AsmJit.
-      inst_id = InstAPI::string_to_inst_id(parser.emitter()->arch(), reinterpret_cast<char*>(lower), size);
+      str_to_lower(lower, token->data(), size);
+      inst_id = InstAPI::string_to_inst_id(kArch, reinterpret_cast<char*>(lower), size);
     }
 
     if (inst_id == x86::Inst::kIdNone) {
       // Maybe it's an option / prefix?
-      InstOptions option = x86_parse_inst_option(lower, size);
+      InstOptions option = entry ? entry->options : InstOptions::kNone;
       if (option == InstOptions::kNone)
         return make_error(Error::kInvalidInstruction);
 
@@ -960,22 +1303,18 @@ static Error x86_parse_instruction(AsmParser& parser, InstId& inst_id, InstOptio
         return make_error(Error::kOptionAlreadyDefined);
 
       options |= option;
-      if (parser.next_token(token) != AsmTokenType::kSym)
+      if (read_token(parser, token) != AsmTokenType::kSym)
         return make_error(Error::kInvalidInstruction);
     }
     else {
       // Ok, we have an instruction. Now let's parse the next token and decide if it belongs to the instruction or not.
       // This is required to parse things such "jmp short" although we prefer "short jmp" (but the former is valid in
       // other assemblers).
-      if (parser.next_token(token) == AsmTokenType::kSym) {
-        size = token->size();
-        if (size <= ASMJIT_ARRAY_SIZE(lower)) {
-          str_to_lower(lower, token->data(), size);
-          InstOptions option = x86_parse_inst_option(lower, size);
-          if (option == InstOptions::kShortForm) {
-            options |= option;
-            return Error::kOk;
-          }
+      if (read_token(parser, token) == AsmTokenType::kSym) {
+        entry = X86Mnemonics::lookup(token->data(), token->size());
+        if (entry && entry->options == InstOptions::kShortForm) {
+          options |= InstOptions::kShortForm;
+          return Error::kOk;
         }
       }
 
@@ -985,13 +1324,96 @@ static Error x86_parse_instruction(AsmParser& parser, InstId& inst_id, InstOptio
   }
 }
 
-static Error x86_fixup_instruction(AsmParser& parser, BaseInst& inst, Operand_* operands, uint32_t& count) noexcept {
+// Immediates and displacements are keyed by the ranges their value fits in, which is all validation checks about them.
+static inline uint32_t validation_value_class(int64_t value) noexcept {
+  uint64_t u = uint64_t(value);
+  return (uint32_t(value >= -8 && value <= 7)                         << 0) |
+         (uint32_t(u <= 0xFu)                                         << 1) |
+         (uint32_t(value >= -128 && value <= 127)                     << 2) |
+         (uint32_t(u <= 0xFFu)                                        << 3) |
+         (uint32_t(value >= -32768 && value <= 32767)                 << 4) |
+         (uint32_t(u <= 0xFFFFu)                                      << 5) |
+         (uint32_t(value >= INT64_C(-2147483648) && value <= 2147483647) << 6) |
+         (uint32_t(u <= 0xFFFFFFFFu)                                  << 7);
+}
+
+static inline void make_validation_key(Arch arch, const BaseInst& inst, const Operand_* operands, uint32_t count, AsmValidationCache::Key& key) noexcept {
+  ASMJIT_ASSERT(count <= AsmValidationCache::kMaxOpCount);
+  memset(&key, 0, sizeof(key));
+
+  key.words[0] = 0x80000000u | (uint32_t(arch) << 8) | count;
+  key.words[1] = inst.inst_id();
+  key.words[2] = uint32_t(inst.options());
+  key.words[3] = uint32_t(inst.extra_reg().type());
+  key.words[4] = inst.extra_reg().id();
+
+  for (uint32_t i = 0; i < count; i++) {
+    const Operand_& op = operands[i];
+    uint32_t* w = key.words + 5 + i * 3;
+
+    w[0] = op.signature().bits();
+    if (op.is_reg()) {
+      w[1] = op.id();
+    }
+    else if (op.is_mem()) {
+      // Labels are only keyed by their presence (in the signature), registers by their ids.
+      const BaseMem& mem = op.as<BaseMem>();
+      w[1] = mem.has_base_label() ? 0u : mem.base_id();
+      w[2] = mem.index_id() | (validation_value_class(mem.offset()) << 16);
+    }
+    else if (op.is_imm()) {
+      w[1] = validation_value_class(op.as<Imm>().value());
+    }
+  }
+}
+
+// Validates an instruction, the result is looked up in the validation cache first.
+template<Arch kArch>
+static Error validate_instruction(AsmParser& parser, const BaseInst& inst, const Operand_* operands, uint32_t count) noexcept {
+  Arch arch = kArch;
+
+  AsmValidationCache::Key key;
+  make_validation_key(arch, inst, operands, count, key);
+
+  Error err;
+  if (parser._validation_cache.find(key, &err)) {
+    ASMTK_STAT_INC(parser, validation_cache_hit_count);
+    return err;
+  }
+
+  err = InstAPI::validate(arch, inst, operands, count);
+  parser._validation_cache.insert(key, err);
+  return err;
+}
+
+// Tests whether the parser has to validate the instruction it's about to emit, see `AsmValidation`.
+static inline bool should_validate(AsmParser& parser) noexcept {
+  switch (parser._validation) {
+    // Validated even if the emitter validates as well, so invalid input is reported by the parser and doesn't reach
+    // the emitter's `ErrorHandler`.
+    case AsmValidation::kAlways:
+      return true;
+
+    case AsmValidation::kSampled:
+      if (parser._validation_counter == 0) {
+        parser._validation_counter = parser._validation_interval - 1u;
+        return true;
+      }
+      parser._validation_counter--;
+      return false;
+
+    default:
+      return false;
+  }
+}
+
+template<Arch kArch>
+static Error x86_fixup_instruction(BaseInst& inst, Operand_* operands, uint32_t& count) noexcept {
   uint32_t i;
 
   InstId& inst_id = inst._inst_id;
 
   if (inst_id >= kX86AliasStart) {
-    x86::Emitter* emitter = static_cast<x86::Emitter*>(parser._emitter);
     uint32_t mem_size = 0;
     bool is_str = false;
 
@@ -1049,13 +1471,16 @@ static Error x86_fixup_instruction(AsmParser& parser, BaseInst& inst, Operand_*
         };
 
         // String instructions aliases.
+        x86::Mem ptr_zsi = x86::ptr(kArch == Arch::kX86 ? x86::esi : x86::rsi);
+        x86::Mem ptr_zdi = x86::ptr(kArch == Arch::kX86 ? x86::edi : x86::rdi);
+
         count = 2;
         switch (inst_id) {
-          case x86::Inst::kIdCmps: operands[0] = emitter->ptr_zsi(); operands[1] = emitter->ptr_zdi(); break;
-          case x86::Inst::kIdMovs: operands[0] = emitter->ptr_zdi(); operands[1] = emitter->ptr_zsi(); break;
+          case x86::Inst::kIdCmps: operands[0] = ptr_zsi; operands[1] = ptr_zdi; break;
+          case x86::Inst::kIdMovs: operands[0] = ptr_zdi; operands[1] = ptr_zsi; break;
           case x86::Inst::kIdLods:
-          case x86::Inst::kIdScas: operands[0] = Reg(reg_signature, x86::Gp::kIdAx); operands[1] = emitter->ptr_zdi(); break;
-          case x86::Inst::kIdStos: operands[0] = emitter->ptr_zdi(); operands[1] = Reg(reg_signature, x86::Gp::kIdAx); break;
+          case x86::Inst::kIdScas: operands[0] = Reg(reg_signature, x86::Gp::kIdAx); operands[1] = ptr_zdi; break;
+          case x86::Inst::kIdStos: operands[0] = ptr_zdi; operands[1] = Reg(reg_signature, x86::Gp::kIdAx); break;
         }
       }
 
@@ -1099,36 +1524,211 @@ static Error x86_fixup_instruction(AsmParser& parser, BaseInst& inst, Operand_*
   return Error::kOk;
 }
 
-Error AsmParser::parse(const char* input, size_t size) noexcept {
-  set_input(input, size);
-  while (!is_end_of_input())
-    ASMJIT_PROPAGATE(parse_command());
+// Detaches the parser from an input that is about to become invalid. The offset of the last command is kept so it
+// can be used to report an error.
+static void release_input(AsmParser& parser) noexcept {
+  size_t command_offset = parser._current_command_offset;
+  parser.set_input("", 0);
+  parser._current_command_offset = command_offset;
+}
+
+// Adds the failed command to the diagnostics and skips the rest of the line it starts at, which includes tokens
+// that were already tokenized ahead.
+static Error recover_from_error(AsmParser& parser, Error err) noexcept {
+  // Errors not caused by the input cannot be recovered from.
+  if (err == Error::kOutOfMemory)
+    return err;
+
+  const uint8_t* start = parser._tokenizer._input + (parser._current_command_offset - parser._input_offset);
+  const uint8_t* end = parser._tokenizer._end;
+  const uint8_t* line_end = ScanUtils::find_newline(start, end);
+
+  ASMJIT_PROPAGATE(parser._diagnostics->add(parser._current_command_offset, (size_t)(line_end - start), err));
+
+  parser._tokenizer._cur = line_end + size_t(line_end != end);
+  parser._stream.clear();
+  parser._stream_index = 0;
+  parser._stream_value_index = 0;
+  parser._end_of_input = line_end == end;
+
+  return Error::kOk;
+}
+
+template<typename EmitterT, Arch kArch>
+static Error parse_command_as(AsmParser& parser) noexcept;
+
+// Parses commands until the end of the input. In recovery mode only errors that cannot be recovered from are
+// returned, the others are in the diagnostics.
+template<typename EmitterT, Arch kArch>
+static Error parse_commands_as(AsmParser& parser) noexcept {
+  if (!parser._diagnostics) {
+    while (!parser.is_end_of_input())
+      ASMJIT_PROPAGATE(parse_command_as<EmitterT, kArch>(parser));
+    return Error::kOk;
+  }
+
+  while (!parser.is_end_of_input()) {
+    Error err = parse_command_as<EmitterT, kArch>(parser);
+    if (ASMJIT_UNLIKELY(err != Error::kOk))
+      ASMJIT_PROPAGATE(recover_from_error(parser, err));
+  }
   return Error::kOk;
 }
 
+template<typename EmitterT>
+static Error parse_commands(AsmParser& parser) noexcept {
+  if (parser._emitter->arch() == Arch::kX86)
+    return parse_commands_as<EmitterT, Arch::kX86>(parser);
+  else
+    return parse_commands_as<EmitterT, Arch::kX64>(parser);
+}
+
+// Returns the error of the first diagnostic added since there were `count` diagnostics.
+static Error first_error_since(const AsmParser& parser, size_t count) noexcept {
+  const AsmDiagnostics* diagnostics = parser._diagnostics;
+  if (!diagnostics || diagnostics->size() <= count)
+    return Error::kOk;
+  return diagnostics->diagnostic_at(count).err;
+}
+
+template<typename EmitterT>
+static Error parse_input(AsmParser& parser, const char* input, size_t size) noexcept {
+  parser.set_input(input, size);
+
+  if (parser._diagnostics) {
+    parser._diagnostics->clear();
+    parser._diagnostics->set_source(input, (size_t)(parser._tokenizer._end - parser._tokenizer._input));
+  }
+
+  ASMJIT_PROPAGATE(parse_commands<EmitterT>(parser));
+  return first_error_since(parser, 0);
+}
+
+template<typename EmitterT>
+static Error parse_cached(AsmParser& parser, const char* input, size_t size) noexcept {
+  AsmCache& cache = *parser._cache;
+  BaseEmitter* emitter = parser._emitter;
+
+  // The key doesn't include the validation, so only results of validated input are cached (and served).
+  if (parser._record || parser._unknown_symbol_handler || parser._validation != AsmValidation::kAlways ||
+      !AsmCache::is_cacheable(emitter)) {
+    cache._stats.bypass_count++;
+    return parse_input<EmitterT>(parser, input, size);
+  }
+
+  if (size == SIZE_MAX)
+    size = strlen(input);
+
+  AsmCache::Key key = AsmCache::make_key(emitter, input, size);
+
+  bool hit;
+  ASMJIT_PROPAGATE(cache.load(emitter, key, &parser._current_global_label_id, &hit));
+
+  if (hit) {
+    // The same state as if the input was parsed.
+    parser.set_input(input + size, 0);
+    if (parser._diagnostics)
+      parser._diagnostics->clear();
+    return Error::kOk;
+  }
+
+  parser._has_included_files = false;
+  ASMJIT_PROPAGATE(parse_input<EmitterT>(parser, input, size));
+
+  // The content of included files is not part of the key.
+  if (parser._has_included_files) {
+    cache._stats.bypass_count++;
+    return Error::kOk;
+  }
+
+  cache.store(emitter, key, parser._current_global_label_id);
+  return Error::kOk;
+}
+
+template<typename EmitterT>
+Error AsmParser::_parse(const char* input, size_t size) noexcept {
+  if (_cache)
+    return parse_cached<EmitterT>(*this, input, size);
+  else
+    return parse_input<EmitterT>(*this, input, size);
+}
+
+Error AsmParser::parse(const char* input, size_t size) noexcept {
+  return _parse<BaseEmitter>(input, size);
+}
+
+Error AsmParser::record(AsmRecord& record, const char* input, size_t size) noexcept {
+  // Symbols are only resolved when the record is replayed, which doesn't know the handler.
+  if (ASMJIT_UNLIKELY(_unknown_symbol_handler))
+    return make_error(Error::kInvalidState);
+
+  Arch arch = _emitter->arch();
+  if (ASMJIT_UNLIKELY(!record.is_empty() && record.arch() != arch))
+    return make_error(Error::kInvalidArch);
+
+  record.set_arch(arch);
+
+  AsmRecord* prev_record = _record;
+  _record = &record;
+
+  Error err = parse(input, size);
+
+  _record = prev_record;
+  return err;
+}
+
+template<typename EmitterT>
+Error AsmParser::_parse_file(const char* path) noexcept {
+  MappedFile file;
+  ASMJIT_PROPAGATE(file.open(path));
+
+  Error err = _parse<EmitterT>(reinterpret_cast<const char*>(file.data()), file.size());
+
+  // Don't keep pointing to the mapping, which is released when the function returns. Diagnostics need the file to
+  // map offsets to lines, so it's indexed now, but only if there is something to report.
+  if (_diagnostics) {
+    if (!_diagnostics->is_empty())
+      _diagnostics->build_newline_index();
+    _diagnostics->_source = nullptr;
+    _diagnostics->_source_size = 0;
+  }
+
+  release_input(*this);
+  return err;
+}
+
+Error AsmParser::parse_file(const char* path) noexcept {
+  return _parse_file<BaseEmitter>(path);
+}
+
 Error AsmParser::parse_command() noexcept {
+  return _parse_command<BaseEmitter>();
+}
+
+template<typename EmitterT>
+Error AsmParser::_parse_command() noexcept {
+  if (_emitter->arch() == Arch::kX86)
+    return parse_command_as<EmitterT, Arch::kX86>(*this);
+  else
+    return parse_command_as<EmitterT, Arch::kX64>(*this);
+}
+
+template<typename EmitterT, Arch kArch>
+static Error parse_command_as(AsmParser& parser) noexcept {
   AsmToken token;
-  AsmTokenType token_type = next_token(&token);
+  AsmTokenType token_type = read_token(parser, &token);
 
-  _current_command_offset = (size_t)(reinterpret_cast<const char*>(token.data()) - input());
+  parser._current_command_offset = parser._input_offset + (size_t)(reinterpret_cast<const char*>(token.data()) - parser.input());
 
   if (token_type == AsmTokenType::kSym) {
     AsmToken tmp;
 
-    token_type = next_token(&tmp);
+    token_type = read_token(parser, &tmp);
     if (token_type == AsmTokenType::kColon) {
       // Parse label.
       Label label;
-      ASMJIT_PROPAGATE(handle_symbol(*this, label, token.data(), token.size()));
-      ASMJIT_PROPAGATE(_emitter->bind(label));
-
-      // Must be valid if we passed through handle_symbol() and bind().
-      LabelEntry& le = _emitter->code()->label_entry_of(label);
-
-      if (le.label_type() == LabelType::kGlobal)
-        _current_global_label_id = label.id();
-
-      return Error::kOk;
+      ASMJIT_PROPAGATE(handle_symbol(parser, label, token));
+      return emit_bind<EmitterT>(parser, label);
     }
 
     if (token.data_at(0) == '.') {
@@ -1142,9 +1742,9 @@ Error AsmParser::parse_command() noexcept {
         if (tmp.u64_value() > std::numeric_limits<uint32_t>::max() || !Support::is_power_of_2(tmp.u64_value()))
           return make_error(Error::kInvalidState);
 
-        ASMJIT_PROPAGATE(_emitter->align(AlignMode::kCode, uint32_t(tmp.u64_value())));
+        ASMJIT_PROPAGATE(emit_align<EmitterT>(parser, AlignMode::kCode, uint32_t(tmp.u64_value())));
 
-        token_type = next_token(&token);
+        token_type = read_token(parser, &token);
         // Fall through as we would like to see EOL or EOF.
       }
       else if (directive >= kX86DirectiveDB && directive <= kX86DirectiveDQ) {
@@ -1165,15 +1765,72 @@ Error AsmParser::parse_command() noexcept {
             return make_error(Error::kInvalidImmediate);
 
           db.append(tmp.value_chars(), n_bytes);
+          ASMJIT_PROPAGATE(append_data_values(parser, n_bytes, max_value, db));
+
+          token_type = read_token(parser, &tmp);
+          if (token_type != AsmTokenType::kComma)
+            break;
+
+          token_type = read_token(parser, &tmp);
+        }
+
+        ASMJIT_PROPAGATE(emit_embed<EmitterT>(parser, db.data(), db.size()));
+      }
+      else if (directive >= kX86DirectiveHalf && directive <= kX86DirectiveDouble) {
+        FloatFormat format   = (directive == kX86DirectiveHalf ) ? FloatFormat::kF16 :
+                               (directive == kX86DirectiveFloat) ? FloatFormat::kF32 : FloatFormat::kF64;
+        uint32_t n_bytes     = (directive == kX86DirectiveHalf ) ? 2 :
+                               (directive == kX86DirectiveFloat) ? 4 : 8;
+        uint64_t sign_bit    = uint64_t(1) << (n_bytes * 8 - 1);
+
+        // All values of a single directive are collected and embedded at once.
+        StringTmp<512> db;
+        for (;;) {
+          uint64_t negate = 0;
+          if (token_type == AsmTokenType::kSub) {
+            negate = sign_bit;
+            token_type = read_token(parser, &tmp);
+          }
+
+          uint64_t bits;
+          ASMJIT_PROPAGATE(x86_parse_float_data(tmp, token_type, format, &bits));
 
-          token_type = next_token(&tmp);
+          bits ^= negate;
+          uint8_t bytes[8];
+          for (uint32_t i = 0; i < n_bytes; i++)
+            bytes[i] = uint8_t(bits >> (i * 8));
+          db.append(reinterpret_cast<const char*>(bytes), n_bytes);
+
+          token_type = read_token(parser, &tmp);
           if (token_type != AsmTokenType::kComma)
             break;
 
-          token_type = next_token(&tmp);
+          token_type = read_token(parser, &tmp);
         }
 
-        ASMJIT_PROPAGATE(_emitter->embed(db.data(), db.size()));
+        ASMJIT_PROPAGATE(emit_embed<EmitterT>(parser, db.data(), db.size()));
+      }
+      else if (directive == kX86DirectiveIncbin) {
+        // .incbin "path"[, offset[, length]]
+        if (token_type != AsmTokenType::kString)
+          return make_error(Error::kInvalidState);
+
+        const char* path = reinterpret_cast<const char*>(tmp.data()) + 1;
+        size_t path_size = tmp.size() - 2u;
+
+        uint64_t args[2] = { 0, kIncbinRestOfFile };
+        token_type = read_token(parser, &token);
+
+        for (uint32_t i = 0; i < 2 && token_type == AsmTokenType::kComma; i++) {
+          if (read_token(parser, &token) != AsmTokenType::kU64)
+            return make_error(Error::kInvalidState);
+
+          args[i] = token.u64_value();
+          token_type = read_token(parser, &token);
+        }
+
+        ASMJIT_PROPAGATE(embed_file<EmitterT>(parser, path, path_size, args[0], args[1]));
+        // Fall through as we would like to see EOL or EOF.
       }
       else {
         return make_error(Error::kInvalidDirective);
@@ -1181,18 +1838,20 @@ Error AsmParser::parse_command() noexcept {
     }
     else {
       // Parse instruction.
-      put_token_back(&tmp);
+      parser.put_token_back(&tmp);
 
       BaseInst inst;
-      ASMJIT_PROPAGATE(x86_parse_instruction(*this, inst._inst_id, inst._options, &token));
+      ASMJIT_PROPAGATE(x86_parse_instruction<kArch>(parser, inst._inst_id, inst._options, &token));
 
       // Parse operands.
       uint32_t count = 0;
       Operand_ operands[6];
       x86::Mem* mem_op = nullptr;
 
+      ASMTK_STAT_TIMER_START(parser, operand_start);
+
       for (;;) {
-        token_type = next_token(&token);
+        token_type = read_token(parser, &token);
 
         // Instruction without operands...
         if ((token_type == AsmTokenType::kNL || token_type == AsmTokenType::kEnd) && count == 0)
@@ -1208,11 +1867,11 @@ Error AsmParser::parse_command() noexcept {
             InstOptions::kX86_RU_SAE |
             InstOptions::kX86_RZ_SAE ;
 
-          token_type = next_token(&tmp, ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes);
+          token_type = read_token(parser, &tmp, ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes);
           if (token_type != AsmTokenType::kSym && token_type != AsmTokenType::kNSym)
             return make_error(Error::kInvalidState);
 
-          token_type = next_token(&token);
+          token_type = read_token(parser, &token);
           if (token_type != AsmTokenType::kRCurl)
             return make_error(Error::kInvalidState);
 
@@ -1224,27 +1883,27 @@ Error AsmParser::parse_command() noexcept {
             return make_error(Error::kOptionAlreadyDefined);
 
           inst.add_options(option);
-          token_type = next_token(&token);
+          token_type = read_token(parser, &token);
         }
         else {
           if (count == ASMJIT_ARRAY_SIZE(operands))
             return make_error(Error::kInvalidInstruction);
 
           // Parse operand.
-          ASMJIT_PROPAGATE(x86_parse_operand(*this, operands[count], &token));
+          ASMJIT_PROPAGATE(x86_parse_operand<kArch>(parser, operands[count], &token));
 
           if (operands[count].is_mem())
             mem_op = static_cast<x86::Mem*>(&operands[count]);
 
           // Parse {AVX-512} option(s) immediately next to the operand.
-          token_type = next_token(&token);
+          token_type = read_token(parser, &token);
           if (token_type == AsmTokenType::kLCurl) {
             do {
-              token_type = next_token(&tmp, ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes);
+              token_type = read_token(parser, &tmp, ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes);
               if (token_type != AsmTokenType::kSym && token_type != AsmTokenType::kNSym)
                 return make_error(Error::kInvalidState);
 
-              token_type = next_token(&token);
+              token_type = read_token(parser, &token);
               if (token_type != AsmTokenType::kRCurl)
                 return make_error(Error::kInvalidState);
 
@@ -1290,7 +1949,7 @@ Error AsmParser::parse_command() noexcept {
                 }
               }
 
-              token_type = next_token(&token);
+              token_type = read_token(parser, &token);
             } while (token_type == AsmTokenType::kLCurl);
           }
 
@@ -1306,12 +1965,17 @@ Error AsmParser::parse_command() noexcept {
         return make_error(Error::kInvalidState);
       }
 
-      ASMJIT_PROPAGATE(x86_fixup_instruction(*this, inst, operands, count));
-      ASMJIT_PROPAGATE(InstAPI::validate(_emitter->arch(), inst, operands, count));
+      ASMTK_STAT_TIMER_STOP(parser, operand_time, operand_start);
+      ASMJIT_PROPAGATE(x86_fixup_instruction<kArch>(inst, operands, count));
 
-      _emitter->set_inst_options(inst.options());
-      _emitter->set_extra_reg(inst.extra_reg());
-      ASMJIT_PROPAGATE(_emitter->emit_op_array(inst.inst_id(), operands, count));
+      if (should_validate(parser)) {
+        ASMTK_STAT_INC(parser, validate_count);
+        ASMTK_STAT_TIMER_START(parser, validate_start);
+        ASMJIT_PROPAGATE(validate_instruction<kArch>(parser, inst, operands, count));
+        ASMTK_STAT_TIMER_STOP(parser, validate_time, validate_start);
+      }
+
+      ASMJIT_PROPAGATE(emit_inst<EmitterT>(parser, inst, operands, count));
     }
   }
 
@@ -1319,11 +1983,301 @@ Error AsmParser::parse_command() noexcept {
     return Error::kOk;
 
   if (token_type == AsmTokenType::kEnd) {
-    _end_of_input = true;
+    parser._end_of_input = true;
     return Error::kOk;
   }
 
   return make_error(Error::kInvalidState);
 }
 
+// Emitters supported by `BasicAsmParser`.
+template Error AsmParser::_parse<x86::Assembler>(const char* input, size_t size) noexcept;
+template Error AsmParser::_parse_file<x86::Assembler>(const char* path) noexcept;
+template Error AsmParser::_parse_command<x86::Assembler>() noexcept;
+
+#ifndef ASMJIT_NO_BUILDER
+template Error AsmParser::_parse<x86::Builder>(const char* input, size_t size) noexcept;
+template Error AsmParser::_parse_file<x86::Builder>(const char* path) noexcept;
+template Error AsmParser::_parse_command<x86::Builder>() noexcept;
+#endif
+
+// ============================================================================
+// [asmtk::AsmParser - Feed]
+// ============================================================================
+
+// Parses `size` bytes of complete lines at `offset` of the fed input.
+static Error parse_fed_lines(AsmParser& parser, const char* input, size_t size, size_t offset) noexcept {
+  parser.set_input(input, size);
+  parser._input_offset = offset;
+
+  return parse_commands<BaseEmitter>(parser);
+}
+
+static Error append_fed_input(AsmParser& parser, const char* input, size_t size) noexcept {
+  size_t required = parser._feed_size + size;
+
+  if (required > parser._feed_capacity) {
+    size_t new_capacity = std::max<size_t>(parser._feed_capacity * 2u, std::max<size_t>(required, 256u));
+    char* new_buffer = static_cast<char*>(::realloc(parser._feed_buffer, new_capacity));
+
+    if (ASMJIT_UNLIKELY(!new_buffer))
+      return make_error(Error::kOutOfMemory);
+
+    parser._feed_buffer = new_buffer;
+    parser._feed_capacity = new_capacity;
+  }
+
+  memcpy(parser._feed_buffer + parser._feed_size, input, size);
+  parser._feed_size = required;
+  return Error::kOk;
+}
+
+static void reset_fed_input(AsmParser& parser) noexcept {
+  parser._feed_size = 0;
+  parser._feed_offset = 0;
+
+  // Don't keep pointing to the caller's chunk, which is only valid during `feed()`.
+  release_input(parser);
+}
+
+Error AsmParser::feed(const char* input, size_t size) noexcept {
+  size_t diagnostic_count = _diagnostics ? _diagnostics->size() : size_t(0);
+
+  // Find the end of the last complete line, everything after it is carried over to the next call.
+  size_t complete_size = size;
+  while (complete_size && input[complete_size - 1] != '\n')
+    complete_size--;
+
+  Error err = Error::kOk;
+  size_t start = 0;
+
+  if (complete_size) {
+    if (_feed_size) {
+      // Complete the carried over line by the first line of this chunk and parse it.
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(input);
+      start = (size_t)(ScanUtils::find_newline(p, p + complete_size) - p) + 1u;
+
+      err = append_fed_input(*this, input, start);
+      if (err == Error::kOk)
+        err = parse_fed_lines(*this, _feed_buffer, _feed_size, _feed_offset);
+
+      _feed_offset += _feed_size;
+      _feed_size = 0;
+    }
+
+    // Parse the remaining complete lines in place.
+    if (err == Error::kOk && start < complete_size) {
+      err = parse_fed_lines(*this, input + start, complete_size - start, _feed_offset);
+      _feed_offset += complete_size - start;
+    }
+  }
+
+  if (err == Error::kOk)
+    err = append_fed_input(*this, input + complete_size, size - complete_size);
+
+  if (ASMJIT_UNLIKELY(err != Error::kOk)) {
+    reset_fed_input(*this);
+    return err;
+  }
+
+  release_input(*this);
+  return first_error_since(*this, diagnostic_count);
+}
+
+Error AsmParser::finish() noexcept {
+  size_t diagnostic_count = _diagnostics ? _diagnostics->size() : size_t(0);
+  Error err = Error::kOk;
+
+  if (_feed_size)
+    err = parse_fed_lines(*this, _feed_buffer, _feed_size, _feed_offset);
+
+  reset_fed_input(*this);
+  return err != Error::kOk ? err : first_error_since(*this, diagnostic_count);
+}
+
+// ============================================================================
+// [asmtk::AsmParser - Pipeline]
+// ============================================================================
+
+Error AsmParser::parse_pipelined(const char* input, size_t size) noexcept {
+  if (size == SIZE_MAX)
+    size = strlen(input);
+
+  if (size < kPipelineMinInputSize || uint64_t(size) > uint64_t(UINT32_MAX) || _pipeline || _diagnostics)
+    return parse(input, size);
+
+  set_input(input, size);
+
+  AsmTokenPipeline pipeline;
+  if (ASMJIT_UNLIKELY(!ThreadUtils::start_thread(pipeline.thread, pipeline_produce, &pipeline, &_tokenizer)))
+    return parse(input, size);
+  _pipeline = &pipeline;
+
+  Error err = parse_commands<BaseEmitter>(*this);
+
+  pipeline_stop(pipeline);
+  _pipeline = nullptr;
+
+  // The tokenizer thread could be ahead of the failed command, don't leave the parser in between.
+  release_input(*this);
+  return err;
+}
+
+// ============================================================================
+// [asmtk::AsmParser - Parallel]
+// ============================================================================
+
+//! Maximum number of threads used by `parse_parallel()`.
+static constexpr uint32_t kParallelMaxThreads = 64;
+//! Number of regions per thread - more regions than threads balance regions that take longer to parse.
+static constexpr uint32_t kParallelRegionsPerThread = 4;
+//! Minimum size of a region, smaller inputs are not worth the threads.
+static constexpr size_t kParallelMinRegionSize = 64 * 1024;
+
+struct ParallelRegion {
+  const char* input;
+  size_t size;
+  size_t offset;
+  Error err;
+  size_t error_offset;
+  AsmRecord record;
+#if defined(ASMTK_STATISTICS)
+  AsmParserStatistics statistics;
+#endif
+};
+
+static void parse_parallel_region(const AsmParser& parser, ParallelRegion& region) noexcept {
+  BaseEmitter* emitter = parser._emitter;
+
+  AsmParser worker(emitter);
+  worker.set_validation(parser._validation, parser._validation_interval);
+  worker.set_include_dir(parser._include_dir);
+  worker._record = &region.record;
+  worker._record->set_arch(emitter->arch());
+  worker.set_input(region.input, region.size);
+  worker._input_offset = region.offset;
+
+  Error err = parse_commands<BaseEmitter>(worker);
+  if (err != Error::kOk) {
+    region.err = err;
+    region.error_offset = worker.current_command_offset();
+  }
+
+#if defined(ASMTK_STATISTICS)
+  region.statistics = worker._statistics;
+#endif
+}
+
+Error AsmParser::parse_parallel(const char* input, size_t size, uint32_t thread_count) noexcept {
+  if (size == SIZE_MAX)
+    size = strlen(input);
+
+  if (thread_count == 0)
+    thread_count = std::thread::hardware_concurrency();
+  thread_count = std::min(thread_count, kParallelMaxThreads);
+
+  uint32_t region_count = uint32_t(std::min<size_t>(size / kParallelMinRegionSize, thread_count * kParallelRegionsPerThread));
+  if (thread_count <= 1 || region_count <= 1 || _unknown_symbol_handler || _record || _diagnostics || !_emitter->code())
+    return parse(input, size);
+
+  ParallelRegion* regions = static_cast<ParallelRegion*>(::malloc(region_count * sizeof(ParallelRegion)));
+  if (ASMJIT_UNLIKELY(!regions))
+    return make_error(Error::kOutOfMemory);
+
+  // Split the input into regions of complete lines of roughly the same size - commands never span lines. Regions
+  // don't have to start at a global label, because symbols are only resolved when the records are replayed in order.
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(input);
+  const uint8_t* end = begin + size;
+  const uint8_t* region_start = begin;
+
+  for (uint32_t i = 0; i < region_count; i++) {
+    const uint8_t* region_end = end;
+
+    if (i + 1u < region_count) {
+      const uint8_t* split = std::max(region_start, begin + size / region_count * (i + 1u));
+      region_end = ScanUtils::find_newline(split, end);
+      if (region_end != end)
+        region_end++;
+    }
+
+    ParallelRegion* region = new(&regions[i]) ParallelRegion();
+    region->input = reinterpret_cast<const char*>(region_start);
+    region->size = (size_t)(region_end - region_start);
+    region->offset = (size_t)(region_start - begin);
+    region->err = Error::kOk;
+    region->error_offset = 0;
+
+    region_start = region_end;
+  }
+
+  std::atomic<uint32_t> next_region { 0 };
+  auto work = [&]() noexcept {
+    for (;;) {
+      uint32_t i = next_region.fetch_add(1, std::memory_order_relaxed);
+      if (i >= region_count)
+        break;
+      parse_parallel_region(*this, regions[i]);
+    }
+  };
+
+  // The calling thread parses regions as well. If threads cannot be created the regions are parsed by the threads
+  // that could, and if there are none the input is parsed serially.
+  uint32_t worker_count = std::min(thread_count, region_count) - 1u;
+  std::thread workers[kParallelMaxThreads];
+
+  for (uint32_t i = 0; i < worker_count; i++) {
+    if (!ThreadUtils::start_thread(workers[i], work)) {
+      worker_count = i;
+      break;
+    }
+  }
+
+  if (!worker_count) {
+    for (uint32_t i = 0; i < region_count; i++)
+      regions[i].~ParallelRegion();
+    ::free(regions);
+    return parse(input, size);
+  }
+
+  work();
+
+  for (uint32_t i = 0; i < worker_count; i++)
+    workers[i].join();
+
+#if defined(ASMTK_STATISTICS)
+  for (uint32_t i = 0; i < region_count; i++)
+    _statistics.add(regions[i].statistics);
+  size_t replay_offset = stat_emitter_offset(*this);
+#endif
+
+  // The current global label carries over from one region to the next one.
+  AsmRecord::ReplayState state;
+  state.current_global_label_id = _current_global_label_id;
+
+  Error err = Error::kOk;
+  for (uint32_t i = 0; i < region_count; i++) {
+    err = regions[i].record.replay(_emitter, &state);
+    if (err != Error::kOk) {
+      _current_command_offset = state.command_offset;
+      break;
+    }
+
+    if (regions[i].err != Error::kOk) {
+      err = regions[i].err;
+      _current_command_offset = regions[i].error_offset;
+      break;
+    }
+  }
+
+  _current_global_label_id = state.current_global_label_id;
+  ASMTK_STAT_ADD(*this, emitted_size, stat_emitter_offset(*this) - replay_offset);
+
+  for (uint32_t i = 0; i < region_count; i++)
+    regions[i].~ParallelRegion();
+  ::free(regions);
+
+  release_input(*this);
+  return err;
+}
+
 } // {asmtk}
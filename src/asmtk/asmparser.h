@@ -7,11 +7,288 @@
 #ifndef _ASMTK_ASMPARSER_H
 #define _ASMTK_ASMPARSER_H
 
+#include <asmjit/x86.h>
+#include <type_traits>
+
 #include "./strtod.h"
+#include "./asmcache.h"
+#include "./asmdiagnostics.h"
+#include "./asmrecord.h"
 #include "./asmtokenizer.h"
 
 namespace asmtk {
 
+struct AsmTokenPipeline;
+
+// ============================================================================
+// [asmtk::AsmLabelCache]
+// ============================================================================
+
+//! Label cache - open addressing hash table that maps symbols to ids of labels they resolve to.
+//!
+//! Entries are keyed by the symbol hash calculated by the tokenizer (see `AsmToken::symbol_hash()`), combined with
+//! the id of the current global label in case of ".local" symbols. Entries don't store names - a candidate is always
+//! verified against the `LabelEntry` in `CodeHolder`, which makes the cache safe to outlive the labels it refers to.
+//! The cache is bound to a single `CodeHolder` and discarded when a different one is used or when the current one
+//! was reset, see `sync()`.
+class AsmLabelCache {
+public:
+  //! Cache entry.
+  struct Entry {
+    uint32_t hash;
+    uint32_t label_id;
+  };
+
+  //! Initial capacity (power of 2).
+  static constexpr uint32_t kInitialCapacity = 1024;
+
+  //! \name Members
+  //! \{
+
+  //! Entries, empty entries have `label_id` set to `Globals::kInvalidId`.
+  Entry* _entries;
+  //! Number of entries (power of 2), zero if not allocated yet.
+  uint32_t _capacity;
+  //! Number of used entries.
+  uint32_t _size;
+  //! CodeHolder the entries refer to.
+  const asmjit::CodeHolder* _code;
+  //! Number of labels `_code` had when it was last synced, used to detect a reset.
+  size_t _label_count;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmLabelCache() noexcept;
+  ASMTK_API ~AsmLabelCache() noexcept;
+
+  AsmLabelCache(const AsmLabelCache& other) = delete;
+  AsmLabelCache& operator=(const AsmLabelCache& other) = delete;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  inline bool is_empty() const noexcept { return _size == 0; }
+  inline uint32_t size() const noexcept { return _size; }
+  inline uint32_t capacity() const noexcept { return _capacity; }
+
+  //! \}
+
+  //! \name Cache Operations
+  //! \{
+
+  static inline uint32_t index_of(uint32_t hash, uint32_t capacity) noexcept {
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    return hash & (capacity - 1u);
+  }
+
+  //! Binds the cache to `code`, all entries are discarded if `code` is not the CodeHolder the cache was bound to, or
+  //! if it has less labels than when it was synced last time, which means that it was reset.
+  inline void sync(const asmjit::CodeHolder* code) noexcept {
+    size_t label_count = code->label_count();
+    if (ASMJIT_UNLIKELY(_code != code || label_count < _label_count)) {
+      clear();
+      _code = code;
+    }
+    _label_count = label_count;
+  }
+
+  //! Returns an id of a label of the given `hash` accepted by `verify(label_id)`, or `Globals::kInvalidId` if there
+  //! is no such label in the cache.
+  template<typename Verify>
+  inline uint32_t find(uint32_t hash, Verify&& verify) const noexcept {
+    if (!_capacity)
+      return asmjit::Globals::kInvalidId;
+
+    uint32_t mask = _capacity - 1u;
+    uint32_t index = index_of(hash, _capacity);
+
+    for (;;) {
+      const Entry& entry = _entries[index];
+      if (entry.label_id == asmjit::Globals::kInvalidId)
+        return asmjit::Globals::kInvalidId;
+
+      if (entry.hash == hash && verify(entry.label_id))
+        return entry.label_id;
+
+      index = (index + 1u) & mask;
+    }
+  }
+
+  //! Inserts a label of the given `hash` to the cache (the caller must make sure it's not there).
+  ASMTK_API Error insert(uint32_t hash, uint32_t label_id) noexcept;
+
+  //! Discards all entries, but keeps the allocated storage.
+  ASMTK_API void clear() noexcept;
+
+  //! Discards all entries and releases the allocated storage.
+  ASMTK_API void reset() noexcept;
+
+  //! \}
+};
+
+// ============================================================================
+// [asmtk::AsmValidationCache]
+// ============================================================================
+
+//! Validation cache - direct-mapped cache of `InstAPI::validate()` results keyed by the shape of an instruction.
+//!
+//! The key consists of everything validation depends on - the architecture, instruction id, options, extra register,
+//! and for each operand its signature and registers, a label instead of its id, and a class of the immediate value
+//! or memory displacement (the ranges it fits in) instead of the value itself. Instructions of the same shape are
+//! either all valid or all invalid in the same way, so the cached error is returned instead of validating again.
+//! Keys are compared as a whole, a collision only replaces the entry.
+class AsmValidationCache {
+public:
+  //! Number of entries (power of 2).
+  static constexpr uint32_t kCapacity = 512;
+  //! Maximum number of operands of a cached instruction.
+  static constexpr uint32_t kMaxOpCount = 6;
+  //! Size of the key in 32-bit words - a header, instruction id, options, extra register, and 3 words per operand.
+  static constexpr uint32_t kKeyWordCount = 5 + kMaxOpCount * 3;
+
+  struct Key {
+    uint32_t words[kKeyWordCount];
+  };
+
+  //! Cache entry, empty entries have a zero key (a valid key has a non-zero header).
+  struct Entry {
+    Key key;
+    Error err;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Entries, allocated by the first `insert()`.
+  Entry* _entries;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmValidationCache() noexcept;
+  ASMTK_API ~AsmValidationCache() noexcept;
+
+  AsmValidationCache(const AsmValidationCache& other) = delete;
+  AsmValidationCache& operator=(const AsmValidationCache& other) = delete;
+
+  //! \}
+
+  //! \name Cache Operations
+  //! \{
+
+  static inline uint32_t index_of(const Key& key) noexcept {
+    uint32_t hash = 0;
+    for (uint32_t i = 0; i < kKeyWordCount; i++)
+      hash = (hash ^ key.words[i]) * 0x9E3779B1u;
+    return (hash >> 16) & (kCapacity - 1u);
+  }
+
+  //! Returns the cached validation result of `key` in `err_out`, returns false if it's not cached.
+  inline bool find(const Key& key, Error* err_out) const noexcept {
+    if (!_entries)
+      return false;
+
+    const Entry& entry = _entries[index_of(key)];
+    if (memcmp(&entry.key, &key, sizeof(Key)) != 0)
+      return false;
+
+    *err_out = entry.err;
+    return true;
+  }
+
+  //! Caches a validation result `err` of `key`, replacing a colliding entry. Does nothing if the entries cannot be
+  //! allocated, as the cache is only an optimization.
+  ASMTK_API void insert(const Key& key, Error err) noexcept;
+
+  //! Discards all entries and releases the allocated storage.
+  ASMTK_API void reset() noexcept;
+
+  //! \}
+};
+
+#if defined(ASMTK_STATISTICS)
+// ============================================================================
+// [asmtk::AsmParserStatistics]
+// ============================================================================
+
+//! Statistics collected by `AsmParser`, only available if AsmTK was compiled with `ASMTK_STATISTICS`.
+//!
+//! Times are in nanoseconds and don't overlap - tokenizing that happens while parsing operands is only accounted
+//! as tokenizing. The time of `parse_pipelined()` spent by waiting for the tokenizer thread is accounted as
+//! tokenizing as well.
+struct AsmParserStatistics {
+  //! Number of tokens returned by `AsmParser::next_token()` per `AsmTokenType` (a token put back is counted again).
+  uint64_t token_count[uint32_t(AsmTokenType::kInvalid) + 1];
+  //! Number of tokens put back by `AsmParser::put_token_back()`.
+  uint64_t put_back_count;
+
+  //! Number of mnemonics and prefixes found in the mnemonic table.
+  uint64_t mnemonic_hit_count;
+  //! Number of words not found in the mnemonic table (looked up by AsmJit if they are too long for the table).
+  uint64_t mnemonic_miss_count;
+  //! Number of symbols recognized as registers.
+  uint64_t register_hit_count;
+  //! Number of symbols that are not registers (labels, operand sizes, etc...).
+  uint64_t register_miss_count;
+  //! Number of symbols resolved to labels by the label cache.
+  uint64_t label_hit_count;
+  //! Number of symbols the label cache didn't resolve, which were looked up in `CodeHolder` or created.
+  uint64_t label_miss_count;
+  //! Number of calls of the unknown symbol handler.
+  uint64_t unknown_symbol_handler_count;
+
+  //! Number of instructions validated.
+  uint64_t validate_count;
+  //! Number of instructions validated by the validation cache (counted in `validate_count` as well).
+  uint64_t validation_cache_hit_count;
+  //! Number of bytes emitted (only counted when emitting to an assembler).
+  uint64_t emitted_size;
+
+  //! Time spent by tokenizing.
+  uint64_t tokenize_time;
+  //! Time spent by parsing operands.
+  uint64_t operand_time;
+  //! Time spent by `InstAPI::validate()`.
+  uint64_t validate_time;
+  //! Time spent by emitting instructions (`BaseEmitter::emit_op_array()`).
+  uint64_t emit_time;
+
+  inline void reset() noexcept { *this = AsmParserStatistics{}; }
+
+  //! Adds `other` to these statistics.
+  inline void add(const AsmParserStatistics& other) noexcept {
+    const uint64_t* src = reinterpret_cast<const uint64_t*>(&other);
+    uint64_t* dst = reinterpret_cast<uint64_t*>(this);
+
+    for (size_t i = 0; i < sizeof(AsmParserStatistics) / sizeof(uint64_t); i++)
+      dst[i] += src[i];
+  }
+};
+#endif
+
+// ============================================================================
+// [asmtk::AsmValidation]
+// ============================================================================
+
+//! Validation of parsed instructions by `AsmParser`, see `AsmParser::set_validation()`.
+enum class AsmValidation : uint32_t {
+  //! Each instruction is validated by `InstAPI::validate()` before it's emitted (default).
+  kAlways = 0,
+  //! Only every N-th instruction is validated, which catches a generator that went wrong at a fraction of the cost.
+  kSampled = 1,
+  //! Instructions are not validated by the parser - only for trusted input.
+  kNever = 2
+};
+
 // ============================================================================
 // [asmtk::AsmParser]
 // ============================================================================
@@ -22,9 +299,17 @@ public:
   typedef Error (ASMJIT_CDECL* UnknownSymbolHandler)(
     AsmParser* parser, asmjit::Operand* out, const char* name, size_t size);
 
+  //! Number of tokens the parser tokenizes ahead (the tokenizer always stops at the end of a line).
+  static constexpr size_t kTokenBatchSize = 4096;
+
   asmjit::BaseEmitter* _emitter;
   AsmTokenizer _tokenizer;
 
+  AsmTokenStream _stream;
+  size_t _stream_index;
+  size_t _stream_value_index;
+  bool _use_stream;
+
   size_t _current_command_offset;
   uint32_t _current_global_label_id;
   bool _end_of_input;
@@ -32,6 +317,44 @@ public:
   UnknownSymbolHandler _unknown_symbol_handler;
   void* _unknown_symbol_handler_data;
 
+  AsmLabelCache _label_cache;
+
+  //! Incomplete line carried over between `feed()` calls.
+  char* _feed_buffer;
+  size_t _feed_size;
+  size_t _feed_capacity;
+  //! Offset of `_feed_buffer` in the fed input.
+  size_t _feed_offset;
+  //! Offset of the current input in the fed input, added to `current_command_offset()`.
+  size_t _input_offset;
+
+  //! Record that receives parsed commands instead of the emitter, see `record()` and `parse_parallel()`.
+  AsmRecord* _record;
+  //! Tokenizer thread that provides token batches, see `parse_pipelined()`.
+  AsmTokenPipeline* _pipeline;
+  //! Cache of parsed inputs, see `set_cache()`.
+  AsmCache* _cache;
+  //! Diagnostics collected in recovery mode, see `set_diagnostics()`.
+  AsmDiagnostics* _diagnostics;
+  //! Directory of files included by `.incbin`, see `set_include_dir()`.
+  const char* _include_dir;
+  //! Set when `.incbin` included a file, the result then depends on more than the input.
+  bool _has_included_files;
+
+  //! Validation of instructions, see `set_validation()`.
+  AsmValidation _validation;
+  //! Results of validation, see `AsmValidationCache`.
+  AsmValidationCache _validation_cache;
+  //! Validation interval of `AsmValidation::kSampled`.
+  uint32_t _validation_interval;
+  //! Number of instructions not validated since the last validated one.
+  uint32_t _validation_counter;
+
+#if defined(ASMTK_STATISTICS)
+  //! Statistics, see `statistics()`.
+  AsmParserStatistics _statistics {};
+#endif
+
   //! \name Construction & Destruction
   //! \{
 
@@ -40,6 +363,20 @@ public:
 
   //! \}
 
+  //! \name Reset & Attach
+  //! \{
+
+  //! Resets the parser to the state of a newly constructed parser (the current global label, the input, the fed
+  //! input, the unknown symbol handler, the cache, the diagnostics, the include directory, and the validation), but
+  //! keeps all allocated storage (the token stream, the label cache, and the feed buffer), so a single parser can be
+  //! reused for any number of inputs without allocating.
+  ASMTK_API void reset() noexcept;
+
+  //! Attaches the parser to `emitter` and resets it, see `reset()`.
+  ASMTK_API void attach(asmjit::BaseEmitter* emitter) noexcept;
+
+  //! \}
+
   //! \name Accessors
   //! \{
 
@@ -59,16 +396,31 @@ public:
       size = strlen(input);
 
     _tokenizer.set_input(reinterpret_cast<const uint8_t*>(input), size);
+    _stream.clear();
+    _stream_index = 0;
+    _stream_value_index = 0;
+    _use_stream = uint64_t(size) <= uint64_t(UINT32_MAX);
+
     _current_command_offset = 0;
+    _input_offset = 0;
     _end_of_input = (size == 0);
 
     return _end_of_input;
   }
 
   inline bool is_end_of_input() const noexcept { return _end_of_input; }
+
+  //! Returns the offset of the command being parsed, relative to the beginning of the input (or the beginning of
+  //! the fed input when the input is provided by `feed()`).
   inline size_t current_command_offset() const noexcept { return _current_command_offset; }
 
+  //! Returns the next token.
+  //!
+  //! The parser tokenizes the input ahead in batches of complete lines into `AsmTokenStream` and then consumes tokens
+  //! from it. If `flags` differ from the flags the token was tokenized with, the token is tokenized again with `flags`
+  //! and the rest of the batch is dropped, which makes such calls (for example from an unknown symbol handler) slow.
   ASMTK_API AsmTokenType next_token(AsmToken* token, ParseFlags flags = ParseFlags::kNone) noexcept;
+  //! Puts `token` back so the next call to `next_token()` returns it again.
   ASMTK_API void put_token_back(AsmToken* token) noexcept;
 
   //! \}
@@ -90,6 +442,92 @@ public:
 
   //! \}
 
+  //! \name Cache
+  //! \{
+
+  inline AsmCache* cache() const noexcept { return _cache; }
+
+  //! Sets a cache used by `parse()` (and `parse_file()`), null disables caching (the default).
+  //!
+  //! Before parsing, the parser looks up the input in the cache and, if found, emits the cached machine code and
+  //! labels instead of parsing. Otherwise the input is parsed and the result is stored in the cache. See `AsmCache`
+  //! for the inputs that are cached. Inputs parsed by other functions, when an unknown symbol handler is set, or when
+  //! the validation is not `AsmValidation::kAlways` (see `set_validation()`) are never cached.
+  inline void set_cache(AsmCache* cache) noexcept { _cache = cache; }
+
+  //! \}
+
+  //! \name Included Files
+  //! \{
+
+  inline const char* include_dir() const noexcept { return _include_dir; }
+
+  //! Sets the directory files included by `.incbin "path"[, offset[, length]]` are read from, which enables the
+  //! directive - `.incbin` fails with `Error::kInvalidDirective` if no directory is set (the default), so input that
+  //! is not trusted cannot read files unless the application allows it. The string is not copied and must outlive
+  //! parsing.
+  //!
+  //! The path must be relative and must not leave the directory - absolute paths, drives, and `..` components are
+  //! rejected by `Error::kInvalidArgument` (symbolic links within the directory are followed). `.incbin` maps the file
+  //! and embeds `length` bytes at `offset` (the rest of the file by default) directly from the mapping. Inputs that
+  //! include files are never cached by `AsmCache`, as the cache only knows the input.
+  inline void set_include_dir(const char* dir) noexcept { _include_dir = dir; }
+
+  //! \}
+
+  //! \name Recovery Mode
+  //! \{
+
+  inline AsmDiagnostics* diagnostics() const noexcept { return _diagnostics; }
+
+  //! Sets diagnostics that enable recovery mode, null disables it (the default).
+  //!
+  //! In recovery mode a command that fails is added to `diagnostics` and parsing continues at the next line, so all
+  //! errors of the input are found in a single pass. `parse()` and `parse_file()` discard diagnostics of the previous
+  //! input and return the error of the first failed command. `feed()` and `finish()` append to the diagnostics and
+  //! return the error of the first command that failed during the call, but don't discard the rest of the input.
+  //! Errors that are not caused by the input (like out of memory) stop parsing as usual. `parse_parallel()` and
+  //! `parse_pipelined()` parse the input by `parse()` in recovery mode.
+  inline void set_diagnostics(AsmDiagnostics* diagnostics) noexcept { _diagnostics = diagnostics; }
+
+  //! \}
+
+  //! \name Validation
+  //! \{
+
+  inline AsmValidation validation() const noexcept { return _validation; }
+  inline uint32_t validation_interval() const noexcept { return _validation_interval; }
+
+  //! Sets how parsed instructions are validated, `interval` is only used by `AsmValidation::kSampled`, which
+  //! validates the first instruction and then each `interval`-th one.
+  //!
+  //! Instructions that are not validated are still rejected by the assembler if they cannot be encoded - operand
+  //! combinations that have no encoding, immediates and displacements that don't fit, and registers that are not
+  //! available in 32-bit mode. What the assembler doesn't check is whether the encoded instruction is what was meant -
+  //! for example AVX-512 masking, zeroing, and broadcasts the instruction doesn't support, a LOCK or REP prefix of an
+  //! instruction that doesn't accept it, or implicit operands that don't match. A builder doesn't check anything until
+  //! it's serialized. Instructions recorded by `record()` are never validated when replayed, so a record of input
+  //! parsed without validation is only as valid as the input.
+  inline void set_validation(AsmValidation validation, uint32_t interval = 64) noexcept {
+    _validation = validation;
+    _validation_interval = interval ? interval : 1u;
+    _validation_counter = 0;
+  }
+
+  //! \}
+
+#if defined(ASMTK_STATISTICS)
+  //! \name Statistics
+  //! \{
+
+  //! Returns statistics collected since the parser was created or since `reset_statistics()` (not reset by
+  //! `reset()`). Statistics of worker threads of `parse_parallel()` are included.
+  inline const AsmParserStatistics& statistics() const noexcept { return _statistics; }
+  inline void reset_statistics() noexcept { _statistics.reset(); }
+
+  //! \}
+#endif
+
   //! \name Parser
   //! \{
 
@@ -98,8 +536,135 @@ public:
   //! and error code describing the problem.
   ASMTK_API Error parse(const char* input, size_t size = SIZE_MAX) noexcept;
 
+  //! Parses the input like `parse()`, but uses up to `thread_count` threads (all hardware threads if zero).
+  //!
+  //! The input is split into regions of complete lines, which are parsed in parallel into `AsmRecord`s - tokenizing,
+  //! operand parsing, and instruction validation run on worker threads. The records are then replayed in order on the
+  //! calling thread, which resolves symbols to labels and emits the instructions, so the result is exactly the same
+  //! as if the input was parsed by `parse()`. Errors are reported in the same order as well - commands preceding the
+  //! failed one are emitted and `current_command_offset()` is the offset of the failed command.
+  //!
+  //! Binding labels and encoding instructions stays serial, so the speedup is bounded by the time of `parse()`
+  //! divided by the time of replaying the records, which `asmtk_bench` reports next to the parallel results.
+  //!
+  //! Falls back to `parse()` if the input is too small to benefit from threads, if an unknown symbol handler is set,
+  //! as the handler must see symbols in the input order, or if no thread can be created.
+  ASMTK_API Error parse_parallel(const char* input, size_t size = SIZE_MAX, uint32_t thread_count = 0) noexcept;
+
+  //! Parses the input like `parse()`, but tokenizes it on another thread.
+  //!
+  //! The tokenizer thread runs ahead of the parser and passes batches of complete lines (see `kTokenBatchSize`) to
+  //! the calling thread through a lock-free single-producer/single-consumer ring, while the calling thread parses
+  //! and emits the commands. The two stages overlap on two cores and the result is exactly the same as by `parse()`.
+  //!
+  //! Falls back to `parse()` if the input is too small to benefit from another thread, too large to be tokenized
+  //! into `AsmTokenStream`, or if the thread cannot be created.
+  ASMTK_API Error parse_pipelined(const char* input, size_t size = SIZE_MAX) noexcept;
+
+  //! Parses the input like `parse()`, but appends the parsed commands to `record` instead of emitting them.
+  //!
+  //! Instructions are validated for the architecture of the emitter, which must be attached to a `CodeHolder`. The
+  //! record can then be replayed onto any emitter of the same architecture by `AsmRecord::replay()` without parsing
+  //! the input again. Returns `Error::kInvalidArch` if `record` already contains commands of another architecture.
+  //!
+  //! Symbols are recorded by name and resolved to labels when the record is replayed, so an unknown symbol handler
+  //! cannot be used - `record()` returns `Error::kInvalidState` if a handler is set.
+  ASMTK_API Error record(AsmRecord& record, const char* input, size_t size = SIZE_MAX) noexcept;
+
+  //! Parses a file at `path`, which is mapped to memory read-only and parsed in place without copying it.
+  //!
+  //! Returns `Error::kFailedToOpenFile` if the file cannot be opened or mapped, otherwise the same as `parse()`.
+  //! In case of a parse error `current_command_offset()` is the offset of the failed command in the file.
+  ASMTK_API Error parse_file(const char* path) noexcept;
+
   ASMTK_API Error parse_command() noexcept;
 
+  //! Parses the input like `parse()`, but calls the emitter as `EmitterT`, see `BasicAsmParser`.
+  template<typename EmitterT>
+  ASMTK_API Error _parse(const char* input, size_t size) noexcept;
+  //! Parses a file like `parse_file()`, but calls the emitter as `EmitterT`, see `BasicAsmParser`.
+  template<typename EmitterT>
+  ASMTK_API Error _parse_file(const char* path) noexcept;
+  //! Parses a command like `parse_command()`, but calls the emitter as `EmitterT`, see `BasicAsmParser`.
+  template<typename EmitterT>
+  ASMTK_API Error _parse_command() noexcept;
+
+  //! Parses input that arrives in chunks of arbitrary size.
+  //!
+  //! Complete lines are parsed directly from `input` as soon as they arrive, and only the incomplete line at the end
+  //! of the chunk is copied and carried over to the next call, so the memory used is bounded by the longest line. The
+  //! remaining input is parsed by `finish()`, which must be called at the end of the input.
+  //!
+  //! Returns the first error encountered, in which case the rest of the fed input is discarded.
+  ASMTK_API Error feed(const char* input, size_t size) noexcept;
+
+  //! Parses the remaining input provided by `feed()` and prepares the parser for the next input.
+  ASMTK_API Error finish() noexcept;
+
+  //! \}
+};
+
+// ============================================================================
+// [asmtk::BasicAsmParser]
+// ============================================================================
+
+//! Asm parser that emits to an emitter of type `EmitterT` (either `x86::Assembler` or `x86::Builder`).
+//!
+//! `AsmParser` emits to any `BaseEmitter`, so each label, directive, and instruction is a virtual call of the emitter.
+//! `BasicAsmParser` calls the emitter by its type instead, which makes the calls direct and lets the compiler inline
+//! the whole path from the tokenizer to the emitter. It's otherwise the same parser, which is the base class.
+//!
+//! Only `parse()`, `parse_file()`, and `parse_command()` are specialized. The other functions are inherited from
+//! `AsmParser` unchanged - `feed()`, `finish()`, `parse_pipelined()`, and `parse_parallel()` still call the emitter
+//! virtually, and so does replaying what `record()` recorded.
+//!
+//! ```
+//! x86::Assembler a(&code);
+//! BasicAsmParser<x86::Assembler> p(&a);
+//! p.parse(input);
+//! ```
+template<typename EmitterT>
+class BasicAsmParser : public AsmParser {
+public:
+  // Only these emitters are instantiated by AsmTK, any other would fail to link.
+#ifndef ASMJIT_NO_BUILDER
+  static_assert(std::is_same<EmitterT, asmjit::x86::Assembler>::value ||
+                std::is_same<EmitterT, asmjit::x86::Builder>::value,
+                "BasicAsmParser only supports x86::Assembler and x86::Builder");
+#else
+  static_assert(std::is_same<EmitterT, asmjit::x86::Assembler>::value,
+                "BasicAsmParser only supports x86::Assembler");
+#endif
+
+  //! \name Construction & Destruction
+  //! \{
+
+  inline BasicAsmParser(EmitterT* emitter) noexcept
+    : AsmParser(emitter) {}
+
+  //! \}
+
+  //! \name Reset & Attach
+  //! \{
+
+  inline void attach(EmitterT* emitter) noexcept { AsmParser::attach(emitter); }
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  inline EmitterT* emitter() const noexcept { return static_cast<EmitterT*>(_emitter); }
+
+  //! \}
+
+  //! \name Parser
+  //! \{
+
+  inline Error parse(const char* input, size_t size = SIZE_MAX) noexcept { return _parse<EmitterT>(input, size); }
+  inline Error parse_file(const char* path) noexcept { return _parse_file<EmitterT>(path); }
+  inline Error parse_command() noexcept { return _parse_command<EmitterT>(); }
+
   //! \}
 };
 
@@ -0,0 +1,438 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./asmrecord.h"
+#include "./labelutils_p.h"
+
+namespace asmtk {
+
+using namespace asmjit;
+
+// Each command starts with `CommandHeader`, instructions continue with options, extra register, and operands, and
+// embedded data continue with the data padded to 8 bytes, so every command starts at an 8-byte aligned offset.
+static constexpr size_t kInstPayloadSize = 8u + sizeof(RegOnly);
+
+static_assert(sizeof(AsmRecord::CommandHeader) == 16, "CommandHeader must be 16 bytes");
+static_assert(sizeof(RegOnly) % 8u == 0, "RegOnly must keep commands 8-byte aligned");
+static_assert(sizeof(Operand_) % 8u == 0, "Operand_ must keep commands 8-byte aligned");
+
+// ============================================================================
+// [asmtk::AsmRecord - Construction & Destruction]
+// ============================================================================
+
+AsmRecord::AsmRecord() noexcept
+  : _arch(Arch::kUnknown),
+    _data(nullptr),
+    _size(0),
+    _capacity(0),
+    _names(nullptr),
+    _names_size(0),
+    _names_capacity(0),
+    _symbols(nullptr),
+    _symbol_count(0),
+    _symbol_capacity(0),
+    _symbol_slots(nullptr),
+    _symbol_slot_count(0),
+    _command_count(0) {}
+
+AsmRecord::~AsmRecord() noexcept {
+  reset();
+}
+
+// ============================================================================
+// [asmtk::AsmRecord - Utilities]
+// ============================================================================
+
+static size_t record_grow_capacity(size_t capacity, size_t n) noexcept {
+  size_t new_capacity = std::max<size_t>(capacity, 256);
+  while (new_capacity < n)
+    new_capacity *= 2;
+  return new_capacity;
+}
+
+template<typename T>
+static Error record_reserve(T** data, size_t* capacity, size_t n) noexcept {
+  if (n <= *capacity)
+    return Error::kOk;
+
+  size_t new_capacity = record_grow_capacity(*capacity, n);
+  if (ASMJIT_UNLIKELY(new_capacity > SIZE_MAX / sizeof(T)))
+    return make_error(Error::kOutOfMemory);
+
+  T* new_data = static_cast<T*>(::realloc(*data, new_capacity * sizeof(T)));
+  if (ASMJIT_UNLIKELY(!new_data))
+    return make_error(Error::kOutOfMemory);
+
+  *data = new_data;
+  *capacity = new_capacity;
+  return Error::kOk;
+}
+
+static inline uint32_t symbol_slot_of(uint32_t hash, uint32_t slot_count) noexcept {
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6Bu;
+  hash ^= hash >> 13;
+  return hash & (slot_count - 1u);
+}
+
+static Error rehash_symbols(AsmRecord& record, uint32_t slot_count) noexcept {
+  uint32_t* slots = static_cast<uint32_t*>(::calloc(slot_count, sizeof(uint32_t)));
+  if (ASMJIT_UNLIKELY(!slots))
+    return make_error(Error::kOutOfMemory);
+
+  uint32_t mask = slot_count - 1u;
+  for (uint32_t i = 0; i < record._symbol_count; i++) {
+    uint32_t slot = symbol_slot_of(record._symbols[i].hash, slot_count);
+    while (slots[slot])
+      slot = (slot + 1u) & mask;
+    slots[slot] = i + 1u;
+  }
+
+  ::free(record._symbol_slots);
+  record._symbol_slots = slots;
+  record._symbol_slot_count = slot_count;
+  return Error::kOk;
+}
+
+static uint8_t* append_command(AsmRecord& record, size_t size, Error* err) noexcept {
+  *err = record_reserve(&record._data, &record._capacity, record._size + size);
+  if (ASMJIT_UNLIKELY(*err != Error::kOk))
+    return nullptr;
+
+  uint8_t* p = record._data + record._size;
+  record._size += size;
+  record._command_count++;
+  return p;
+}
+
+static inline AsmRecord::CommandHeader make_header(AsmRecord::CommandType type, uint32_t value, size_t offset) noexcept {
+  AsmRecord::CommandHeader header {};
+  header.type = type;
+  header.value = value;
+  header.source_offset = offset;
+  return header;
+}
+
+// ============================================================================
+// [asmtk::AsmRecord - Recording]
+// ============================================================================
+
+Error AsmRecord::add_symbol(const uint8_t* name, size_t name_size, uint32_t hash, uint32_t dot_index, uint32_t* index_out) noexcept {
+  if (_symbol_slot_count) {
+    uint32_t mask = _symbol_slot_count - 1u;
+    uint32_t slot = symbol_slot_of(hash, _symbol_slot_count);
+
+    while (uint32_t index = _symbol_slots[slot]) {
+      const Symbol& symbol = _symbols[index - 1u];
+      if (symbol.hash == hash && symbol.name_size == name_size && memcmp(_names + symbol.name_offset, name, name_size) == 0) {
+        *index_out = index - 1u;
+        return Error::kOk;
+      }
+      slot = (slot + 1u) & mask;
+    }
+  }
+
+  if (ASMJIT_UNLIKELY(name_size > UINT32_MAX || _names_size > UINT32_MAX - name_size || _symbol_count >= UINT32_MAX / 2u))
+    return make_error(Error::kTooLarge);
+
+  // Keep the load factor of the hash table below 0.5.
+  if ((_symbol_count + 1u) * 2u > _symbol_slot_count)
+    ASMJIT_PROPAGATE(rehash_symbols(*this, std::max<uint32_t>(_symbol_slot_count * 2u, 256u)));
+
+  ASMJIT_PROPAGATE(record_reserve(&_symbols, &_symbol_capacity, size_t(_symbol_count) + 1u));
+
+  ASMJIT_PROPAGATE(record_reserve(&_names, &_names_capacity, _names_size + name_size));
+  memcpy(_names + _names_size, name, name_size);
+
+  uint32_t index = _symbol_count++;
+  Symbol& symbol = _symbols[index];
+  symbol.name_offset = uint32_t(_names_size);
+  symbol.name_size = uint32_t(name_size);
+  symbol.hash = hash;
+  symbol.dot_index = dot_index;
+  _names_size += name_size;
+
+  uint32_t mask = _symbol_slot_count - 1u;
+  uint32_t slot = symbol_slot_of(hash, _symbol_slot_count);
+  while (_symbol_slots[slot])
+    slot = (slot + 1u) & mask;
+  _symbol_slots[slot] = index + 1u;
+
+  *index_out = index;
+  return Error::kOk;
+}
+
+Error AsmRecord::add_inst(size_t offset, const BaseInst& inst, const Operand_* operands, uint32_t op_count) noexcept {
+  ASMJIT_ASSERT(op_count <= 6);
+
+  Error err;
+  uint8_t* p = append_command(*this, sizeof(CommandHeader) + kInstPayloadSize + op_count * sizeof(Operand_), &err);
+  if (ASMJIT_UNLIKELY(!p))
+    return err;
+
+  // Labels of recorded operands are symbol indexes, see `AsmRecord`.
+  uint32_t symbol_mask = 0;
+  for (uint32_t i = 0; i < op_count; i++) {
+    const Operand_& op = operands[i];
+    if (op.is_label() || (op.is_mem() && op.as<BaseMem>().has_base_label()))
+      symbol_mask |= 1u << i;
+  }
+
+  CommandHeader header = make_header(CommandType::kInst, inst.inst_id(), offset);
+  header.op_count = uint8_t(op_count);
+  header.symbol_mask = uint8_t(symbol_mask);
+  memcpy(p, &header, sizeof(header));
+  p += sizeof(CommandHeader);
+
+  uint32_t options = uint32_t(inst.options());
+  memcpy(p, &options, sizeof(options));
+  memset(p + 4, 0, 4);
+  memcpy(p + 8, &inst.extra_reg(), sizeof(RegOnly));
+  p += kInstPayloadSize;
+
+  memcpy(p, operands, op_count * sizeof(Operand_));
+  return Error::kOk;
+}
+
+Error AsmRecord::add_bind(size_t offset, uint32_t symbol_index) noexcept {
+  Error err;
+  uint8_t* p = append_command(*this, sizeof(CommandHeader), &err);
+  if (ASMJIT_UNLIKELY(!p))
+    return err;
+
+  CommandHeader header = make_header(CommandType::kBind, symbol_index, offset);
+  memcpy(p, &header, sizeof(header));
+  return Error::kOk;
+}
+
+Error AsmRecord::add_align(size_t offset, AlignMode align_mode, uint32_t alignment) noexcept {
+  Error err;
+  uint8_t* p = append_command(*this, sizeof(CommandHeader), &err);
+  if (ASMJIT_UNLIKELY(!p))
+    return err;
+
+  CommandHeader header = make_header(CommandType::kAlign, alignment, offset);
+  header.align_mode = align_mode;
+  memcpy(p, &header, sizeof(header));
+  return Error::kOk;
+}
+
+Error AsmRecord::add_embed(size_t offset, const void* data, size_t size) noexcept {
+  if (ASMJIT_UNLIKELY(size > UINT32_MAX))
+    return make_error(Error::kTooLarge);
+
+  Error err;
+  size_t padded_size = Support::align_up(size, 8u);
+  uint8_t* p = append_command(*this, sizeof(CommandHeader) + padded_size, &err);
+  if (ASMJIT_UNLIKELY(!p))
+    return err;
+
+  CommandHeader header = make_header(CommandType::kEmbed, uint32_t(size), offset);
+  memcpy(p, &header, sizeof(header));
+  memcpy(p + sizeof(CommandHeader), data, size);
+  memset(p + sizeof(CommandHeader) + size, 0, padded_size - size);
+  return Error::kOk;
+}
+
+// ============================================================================
+// [asmtk::AsmRecord - Reading]
+// ============================================================================
+
+size_t AsmRecord::read_command(size_t offset, Command* out) const noexcept {
+  ASMJIT_ASSERT(offset + sizeof(CommandHeader) <= _size);
+
+  const uint8_t* p = _data + offset;
+  memcpy(&out->header, p, sizeof(CommandHeader));
+  p += sizeof(CommandHeader);
+
+  switch (out->header.type) {
+    case CommandType::kInst: {
+      uint32_t options;
+      memcpy(&options, p, sizeof(options));
+      memcpy(&out->extra_reg, p + 8, sizeof(RegOnly));
+      p += kInstPayloadSize;
+
+      out->options = InstOptions(options);
+      memcpy(out->operands, p, out->header.op_count * sizeof(Operand_));
+      p += out->header.op_count * sizeof(Operand_);
+      break;
+    }
+
+    case CommandType::kEmbed:
+      out->data = p;
+      p += Support::align_up(size_t(out->header.value), 8u);
+      break;
+
+    default:
+      break;
+  }
+
+  return (size_t)(p - _data);
+}
+
+// ============================================================================
+// [asmtk::AsmRecord - Replay]
+// ============================================================================
+
+//! Labels of symbols resolved during `AsmRecord::replay()`.
+struct ReplaySymbols {
+  //! Label of each symbol, `Globals::kInvalidId` if not resolved yet.
+  uint32_t* label_ids;
+  //! Global label each ".local" symbol was resolved for.
+  uint32_t* parent_ids;
+};
+
+static Error resolve_symbol(const AsmRecord& record, BaseEmitter* emitter, AsmRecord::ReplayState& state, ReplaySymbols& symbols, uint32_t index, uint32_t* label_id_out) noexcept {
+  const AsmRecord::Symbol& symbol = record.symbol_at(index);
+  const uint8_t* name = reinterpret_cast<const uint8_t*>(record.symbol_name(symbol));
+
+  LabelUtils::SymbolName symbol_name = LabelUtils::split_symbol_name(name, symbol.name_size, symbol.dot_index);
+  uint32_t label_id = symbols.label_ids[index];
+
+  if (label_id != Globals::kInvalidId && (!symbol_name.is_relative() || symbols.parent_ids[index] == state.current_global_label_id)) {
+    *label_id_out = label_id;
+    return Error::kOk;
+  }
+
+  Label parent;
+  Label label = LabelUtils::find_label(emitter, symbol_name, state.current_global_label_id, &parent);
+
+  if (!label.is_valid())
+    ASMJIT_PROPAGATE(LabelUtils::new_label(emitter, symbol_name, parent, &label));
+
+  symbols.label_ids[index] = label.id();
+  symbols.parent_ids[index] = state.current_global_label_id;
+
+  *label_id_out = label.id();
+  return Error::kOk;
+}
+
+static Error replay_commands(const AsmRecord& record, BaseEmitter* emitter, AsmRecord::ReplayState& state, ReplaySymbols& symbols) noexcept {
+  AsmRecord::Command command;
+  size_t offset = 0;
+
+  while (offset < record.size()) {
+    offset = record.read_command(offset, &command);
+    state.command_offset = size_t(command.header.source_offset);
+
+    switch (command.header.type) {
+      case AsmRecord::CommandType::kInst: {
+        uint32_t symbol_mask = command.header.symbol_mask;
+
+        while (symbol_mask) {
+          Operand_& op = command.operands[Support::ctz(symbol_mask)];
+          symbol_mask &= symbol_mask - 1u;
+
+          uint32_t label_id;
+          if (op.is_label()) {
+            ASMJIT_PROPAGATE(resolve_symbol(record, emitter, state, symbols, op.id(), &label_id));
+            op = Label(label_id);
+          }
+          else {
+            BaseMem& mem = op.as<BaseMem>();
+            ASMJIT_PROPAGATE(resolve_symbol(record, emitter, state, symbols, mem.base_id(), &label_id));
+            mem.set_base_id(label_id);
+          }
+        }
+
+        emitter->set_inst_options(command.options);
+        emitter->set_extra_reg(command.extra_reg);
+        ASMJIT_PROPAGATE(emitter->emit_op_array(command.header.value, command.operands, command.header.op_count));
+        break;
+      }
+
+      case AsmRecord::CommandType::kBind: {
+        uint32_t label_id;
+        ASMJIT_PROPAGATE(resolve_symbol(record, emitter, state, symbols, command.header.value, &label_id));
+        ASMJIT_PROPAGATE(emitter->bind(Label(label_id)));
+
+        if (emitter->code()->label_entry_of(label_id).label_type() == LabelType::kGlobal)
+          state.current_global_label_id = label_id;
+        break;
+      }
+
+      case AsmRecord::CommandType::kAlign:
+        ASMJIT_PROPAGATE(emitter->align(command.header.align_mode, command.header.value));
+        break;
+
+      case AsmRecord::CommandType::kEmbed:
+        ASMJIT_PROPAGATE(emitter->embed(command.data, command.header.value));
+        break;
+
+      default:
+        return make_error(Error::kInvalidState);
+    }
+  }
+
+  return Error::kOk;
+}
+
+Error AsmRecord::replay(BaseEmitter* emitter, ReplayState* state) const noexcept {
+  if (ASMJIT_UNLIKELY(!emitter->code()))
+    return make_error(Error::kNotInitialized);
+
+  if (is_empty())
+    return Error::kOk;
+
+  if (ASMJIT_UNLIKELY(emitter->arch() != _arch))
+    return make_error(Error::kInvalidArch);
+
+  ReplaySymbols symbols { nullptr, nullptr };
+  if (_symbol_count) {
+    symbols.label_ids = static_cast<uint32_t*>(::malloc(size_t(_symbol_count) * 2u * sizeof(uint32_t)));
+    if (ASMJIT_UNLIKELY(!symbols.label_ids))
+      return make_error(Error::kOutOfMemory);
+
+    symbols.parent_ids = symbols.label_ids + _symbol_count;
+    memset(symbols.label_ids, 0xFF, size_t(_symbol_count) * sizeof(uint32_t));
+  }
+
+  ReplayState local_state;
+  Error err = replay_commands(*this, emitter, state ? *state : local_state, symbols);
+
+  ::free(symbols.label_ids);
+  return err;
+}
+
+// ============================================================================
+// [asmtk::AsmRecord - Reset]
+// ============================================================================
+
+void AsmRecord::clear() noexcept {
+  if (_symbol_slot_count)
+    memset(_symbol_slots, 0, _symbol_slot_count * sizeof(uint32_t));
+
+  _arch = Arch::kUnknown;
+  _size = 0;
+  _names_size = 0;
+  _symbol_count = 0;
+  _command_count = 0;
+}
+
+void AsmRecord::reset() noexcept {
+  ::free(_data);
+  ::free(_names);
+  ::free(_symbols);
+  ::free(_symbol_slots);
+
+  _arch = Arch::kUnknown;
+  _data = nullptr;
+  _size = 0;
+  _capacity = 0;
+  _names = nullptr;
+  _names_size = 0;
+  _names_capacity = 0;
+  _symbols = nullptr;
+  _symbol_count = 0;
+  _symbol_capacity = 0;
+  _symbol_slots = nullptr;
+  _symbol_slot_count = 0;
+  _command_count = 0;
+}
+
+} // {asmtk}
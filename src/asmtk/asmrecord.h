@@ -0,0 +1,218 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_ASMRECORD_H
+#define _ASMTK_ASMRECORD_H
+
+#include "./globals.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::AsmRecord]
+// ============================================================================
+
+//! Record of parsed commands - what `AsmParser` would emit, captured before it's emitted, see `AsmParser::record()`.
+//!
+//! Commands are stored in a single byte buffer in the order in which they were parsed. Labels are not resolved when
+//! recording - each label operand (or a label base of a memory operand) refers to a symbol by its index in the symbol
+//! table of the record, and the symbol is resolved to a label when the record is replayed. This makes it possible to
+//! record independent parts of the input in parallel and to replay them in order, as ".local" symbols can only be
+//! resolved when the current global label is known.
+//!
+//! A record doesn't refer to the parsed input and can be replayed any number of times onto any emitter of the same
+//! architecture by `replay()`, which neither tokenizes nor validates the instructions again.
+//!
+//! ```
+//! AsmRecord record;
+//! AsmParser parser(&a);
+//! parser.record(record, "mov eax, 1\nret\n");
+//!
+//! for (uint64_t base_address : base_addresses) {
+//!   CodeHolder code;
+//!   code.init(Environment(Arch::kX64), base_address);
+//!   x86::Assembler b(&code);
+//!   record.replay(&b);
+//! }
+//! ```
+class AsmRecord {
+public:
+  //! Command type.
+  enum class CommandType : uint8_t {
+    //! Instruction - `inst_id`, `options`, `extra_reg`, and operands.
+    kInst = 0,
+    //! Label binding - symbol index.
+    kBind = 1,
+    //! Alignment - alignment mode and alignment.
+    kAlign = 2,
+    //! Embedded data - size followed by data.
+    kEmbed = 3
+  };
+
+  //! Symbol referenced by the record.
+  struct Symbol {
+    //! Offset of the symbol name in the names buffer.
+    uint32_t name_offset;
+    //! Size of the symbol name.
+    uint32_t name_size;
+    //! Symbol hash, see `AsmToken::symbol_hash()`.
+    uint32_t hash;
+    //! Index of the first '.', see `AsmToken::symbol_dot_index()`.
+    uint32_t dot_index;
+  };
+
+  //! Header of each recorded command.
+  struct CommandHeader {
+    //! Command type.
+    CommandType type;
+    //! Number of operands (`kInst`).
+    uint8_t op_count;
+    //! Operands that refer to a symbol instead of a label, bit per operand (`kInst`).
+    uint8_t symbol_mask;
+    //! Alignment mode (`kAlign`).
+    asmjit::AlignMode align_mode;
+    //! Instruction id (`kInst`), symbol index (`kBind`), alignment (`kAlign`), or data size (`kEmbed`).
+    uint32_t value;
+    //! Offset of the command in the parsed input, see `AsmParser::current_command_offset()`.
+    uint64_t source_offset;
+  };
+
+  //! Decoded command, see `read_command()`.
+  struct Command {
+    CommandHeader header;
+    //! Instruction options and extra register (`kInst`).
+    asmjit::InstOptions options;
+    asmjit::RegOnly extra_reg;
+    //! Operands (`kInst`).
+    asmjit::Operand_ operands[6];
+    //! Embedded data (`kEmbed`).
+    const uint8_t* data;
+  };
+
+  //! State of `replay()` that continues from one record to another.
+  struct ReplayState {
+    //! Id of the current global label, which ".local" symbols refer to.
+    uint32_t current_global_label_id;
+    //! Offset of the last replayed command in the parsed input - the failed command if `replay()` failed.
+    size_t command_offset;
+
+    inline ReplayState() noexcept
+      : current_global_label_id(asmjit::Globals::kInvalidId),
+        command_offset(0) {}
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Architecture of recorded instructions.
+  asmjit::Arch _arch;
+
+  //! Commands.
+  uint8_t* _data;
+  size_t _size;
+  size_t _capacity;
+
+  //! Symbol names.
+  char* _names;
+  size_t _names_size;
+  size_t _names_capacity;
+
+  //! Symbols.
+  Symbol* _symbols;
+  uint32_t _symbol_count;
+  size_t _symbol_capacity;
+
+  //! Hash table of symbols (index plus one, zero if the slot is empty), used to record each symbol only once.
+  uint32_t* _symbol_slots;
+  uint32_t _symbol_slot_count;
+
+  //! Number of recorded commands.
+  size_t _command_count;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmRecord() noexcept;
+  ASMTK_API ~AsmRecord() noexcept;
+
+  AsmRecord(const AsmRecord& other) = delete;
+  AsmRecord& operator=(const AsmRecord& other) = delete;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  inline bool is_empty() const noexcept { return _command_count == 0; }
+
+  inline asmjit::Arch arch() const noexcept { return _arch; }
+  inline void set_arch(asmjit::Arch arch) noexcept { _arch = arch; }
+
+  inline size_t command_count() const noexcept { return _command_count; }
+
+  inline const uint8_t* data() const noexcept { return _data; }
+  inline size_t size() const noexcept { return _size; }
+
+  inline uint32_t symbol_count() const noexcept { return _symbol_count; }
+  inline const Symbol& symbol_at(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _symbol_count);
+    return _symbols[index];
+  }
+
+  inline const char* symbol_name(const Symbol& symbol) const noexcept { return _names + symbol.name_offset; }
+
+  //! \}
+
+  //! \name Recording
+  //! \{
+
+  //! Adds a symbol `name` of `name_size` having the given `hash` and `dot_index` to the symbol table (only if it's
+  //! not there yet) and stores its index to `index_out`.
+  ASMTK_API Error add_symbol(const uint8_t* name, size_t name_size, uint32_t hash, uint32_t dot_index, uint32_t* index_out) noexcept;
+
+  //! Records an instruction, operands that refer to a label refer to a symbol index instead of a label id.
+  ASMTK_API Error add_inst(size_t offset, const asmjit::BaseInst& inst, const asmjit::Operand_* operands, uint32_t op_count) noexcept;
+  //! Records binding of a label of the symbol at `symbol_index`.
+  ASMTK_API Error add_bind(size_t offset, uint32_t symbol_index) noexcept;
+  //! Records an alignment.
+  ASMTK_API Error add_align(size_t offset, asmjit::AlignMode align_mode, uint32_t alignment) noexcept;
+  //! Records embedded data.
+  ASMTK_API Error add_embed(size_t offset, const void* data, size_t size) noexcept;
+
+  //! Decodes a command at `offset` into `out` and returns the offset of the next command.
+  ASMTK_API size_t read_command(size_t offset, Command* out) const noexcept;
+
+  //! \}
+
+  //! \name Replay
+  //! \{
+
+  //! Emits all recorded commands to `emitter`, which must be attached to a `CodeHolder` of the same architecture.
+  //!
+  //! Symbols are resolved to labels the same way as by `AsmParser` - existing labels are reused and missing labels are
+  //! created. Each symbol is looked up only once per replay, except ".local" symbols, which are looked up again when
+  //! the current global label changes. If `state` is given, replaying continues from the state left by the replay of
+  //! a previous record (the current global label) and the state is updated.
+  ASMTK_API Error replay(asmjit::BaseEmitter* emitter, ReplayState* state = nullptr) const noexcept;
+
+  //! \}
+
+  //! \name Reset
+  //! \{
+
+  //! Removes all commands and symbols, but keeps the allocated storage.
+  ASMTK_API void clear() noexcept;
+  //! Removes all commands and symbols and releases the allocated storage.
+  ASMTK_API void reset() noexcept;
+
+  //! \}
+};
+
+} // {asmtk}
+
+#endif // _ASMTK_ASMRECORD_H
@@ -9,7 +9,11 @@
 
 #include "./globals.h"
 
+#include "./asmbatch.h"
+#include "./asmcache.h"
+#include "./asmdiagnostics.h"
 #include "./asmparser.h"
+#include "./asmrecord.h"
 #include "./asmtokenizer.h"
 #include "./elfdefs.h"
 
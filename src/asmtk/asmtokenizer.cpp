@@ -7,6 +7,8 @@
 #define ASMTK_EXPORTS
 
 #include "./asmtokenizer.h"
+#include "./scanutils_p.h"
+#include "./strtod.h"
 
 namespace asmtk {
 
@@ -82,6 +84,320 @@ static const uint8_t CharMap[] = {
 };
 #undef C
 
+// ============================================================================
+// [asmtk::AsmTokenizer - Floating Point]
+// ============================================================================
+
+enum FloatScanResult : uint32_t {
+  //! Not a floating point literal, parse it as an integer.
+  kFloatScanNone,
+  //! A floating point literal.
+  kFloatScanFound,
+  //! A floating point literal followed by symbol characters.
+  kFloatScanInvalid
+};
+
+static inline bool is_dec_digit(uint32_t c) noexcept { return c - uint32_t('0') < 10u; }
+
+// Scans a decimal floating point literal `digits[.digits][(e|E)[+|-]digits]` starting at `p`, which must contain
+// either a fraction or an exponent (otherwise it's an integer). The fraction must start with a digit so `1.` is
+// still tokenized as an integer followed by a dot.
+//
+// A literal that only has an exponent and is followed by a symbol character (like `1e5h`) is not a floating point
+// literal, because it could be a hexadecimal number with a suffix.
+static FloatScanResult scan_float(const uint8_t* p, const uint8_t* end, const uint8_t** out) noexcept {
+  while (p != end && is_dec_digit(p[0]))
+    p++;
+
+  bool has_fraction = false;
+  if (p != end && p[0] == '.') {
+    if ((size_t)(end - p) < 2 || !is_dec_digit(p[1]))
+      return kFloatScanNone;
+
+    p += 2;
+    while (p != end && is_dec_digit(p[0]))
+      p++;
+    has_fraction = true;
+  }
+
+  bool has_exponent = false;
+  if (p != end && (p[0] | 0x20u) == 'e') {
+    const uint8_t* q = p + 1;
+    if (q != end && (q[0] == '+' || q[0] == '-'))
+      q++;
+
+    if (q != end && is_dec_digit(q[0])) {
+      do {
+        q++;
+      } while (q != end && is_dec_digit(q[0]));
+
+      p = q;
+      has_exponent = true;
+    }
+  }
+
+  if (!has_fraction && !has_exponent)
+    return kFloatScanNone;
+
+  *out = p;
+  if (p != end && CharMap[p[0]] <= kCharUsd)
+    return has_fraction ? kFloatScanInvalid : kFloatScanNone;
+
+  return kFloatScanFound;
+}
+
+// ============================================================================
+// [asmtk::AsmTokenizer - Number Lists]
+// ============================================================================
+
+// Data directives like `.db 1, 2, 3, ...` can have thousands of values per line. `tokenize_all()` scans the rest of
+// such a list by `scan_number_list()` instead of calling `next()` for each token. Only decimal and `0x` prefixed
+// hexadecimal numbers are scanned this way, anything else is left to `next()`, so the tokens are always the same.
+//
+// Digits are classified and converted 8 at a time (SWAR) - bytes are never carried into their neighbors, so any 8
+// bytes can be classified at once. Values wrap the same way as in `next()`.
+
+static const uint64_t kPow10Table[] = {
+  1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u
+};
+
+#if ASMJIT_ARCH_LE
+static inline uint64_t load_u64_le(const uint8_t* p) noexcept {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+#endif
+
+// Scans decimal digits at `p`, accumulates them to `val`, and returns the end of the digits.
+static inline const uint8_t* scan_dec_digits(const uint8_t* p, const uint8_t* end, uint64_t& val) noexcept {
+#if ASMJIT_ARCH_LE
+  while ((size_t)(end - p) >= 8) {
+    // A byte is a digit if it's at most 9 after the '0' is removed.
+    uint64_t x = load_u64_le(p) ^ 0x3030303030303030u;
+    uint64_t non_digits = (((x & 0x7F7F7F7F7F7F7F7Fu) + 0x7676767676767676u) | x) & 0x8080808080808080u;
+    uint32_t n = non_digits ? asmjit::Support::ctz(non_digits) >> 3 : 8u;
+
+    if (n == 0)
+      return p;
+
+    // Move the digits to the top (the first digit is the lowest byte), then combine pairs, quads, and octets.
+    x <<= (8u - n) * 8u;
+    x = ((x & 0x0F0F0F0F0F0F0F0Fu) * 2561u) >> 8;
+    x = ((x & 0x00FF00FF00FF00FFu) * 6553601u) >> 16;
+    x = ((x & 0x0000FFFF0000FFFFu) * 42949672960001u) >> 32;
+
+    val = val * kPow10Table[n] + x;
+    p += n;
+
+    if (n != 8)
+      return p;
+  }
+#endif
+
+  while (p != end && is_dec_digit(p[0])) {
+    val = val * 10u + (p[0] - uint32_t('0'));
+    p++;
+  }
+  return p;
+}
+
+// Scans hexadecimal digits at `p`, accumulates them to `val`, and returns the end of the digits.
+static inline const uint8_t* scan_hex_digits(const uint8_t* p, const uint8_t* end, uint64_t& val) noexcept {
+#if ASMJIT_ARCH_LE
+  while ((size_t)(end - p) >= 8) {
+    uint64_t v = load_u64_le(p);
+    uint64_t x = v & 0x7F7F7F7F7F7F7F7Fu;
+
+    // Digits are at most 9 after the '0' is removed, letters are 1 to 6 after they are lowercased and 0x60 is removed.
+    uint64_t d = x ^ 0x3030303030303030u;
+    uint64_t a = (x | 0x2020202020202020u) ^ 0x6060606060606060u;
+
+    uint64_t digits = ~((d + 0x7676767676767676u) | d);
+    uint64_t letters = (a + 0x7F7F7F7F7F7F7F7Fu) & ~(a + 0x7979797979797979u) & 0x8080808080808080u;
+    uint64_t non_hex = ~((digits | letters) & ~v) & 0x8080808080808080u;
+    uint32_t n = non_hex ? asmjit::Support::ctz(non_hex) >> 3 : 8u;
+
+    if (n == 0)
+      return p;
+
+    // Nibble values, then the same as with decimal digits, but each step multiplies by 16.
+    x = (v & 0x0F0F0F0F0F0F0F0Fu) + (letters >> 7) * 9u;
+    x <<= (8u - n) * 8u;
+    x = ((x << 4) + (x >> 8)) & 0x00FF00FF00FF00FFu;
+    x = ((x << 8) + (x >> 16)) & 0x0000FFFF0000FFFFu;
+    x = ((x << 16) + (x >> 32)) & 0x00000000FFFFFFFFu;
+
+    val = (val << (n * 4u)) | x;
+    p += n;
+
+    if (n != 8)
+      return p;
+  }
+#endif
+
+  while (p != end && CharMap[p[0]] <= kChar0xF) {
+    val = (val << 4) | CharMap[p[0]];
+    p++;
+  }
+  return p;
+}
+
+static inline const uint8_t* skip_blanks(const uint8_t* p, const uint8_t* end) noexcept {
+  while (p != end && (p[0] == ' ' || p[0] == '\t'))
+    p++;
+  return p;
+}
+
+// Scans `, number` pairs that follow the number at the end of `stream` and appends them to it. Stops before the
+// first pair that is not that simple, which is then tokenized by `next()`.
+static Error scan_number_list(AsmTokenizer& tokenizer, AsmTokenStream& stream) noexcept {
+  const uint8_t* end = tokenizer._end;
+  const uint8_t* p = skip_blanks(tokenizer._cur, end);
+
+  if (p == end || p[0] != ',')
+    return Error::kOk;
+
+  // Each number takes at least one character and so does each comma, thus a single reservation is enough.
+  size_t line_size = (size_t)(ScanUtils::find_newline(p, end) - p);
+  ASMJIT_PROPAGATE(stream.reserve(stream._size + line_size));
+  ASMJIT_PROPAGATE(stream.reserve_values(stream._value_count + line_size / 2u + 1u));
+
+  const uint8_t* input = stream._input;
+  size_t size = stream._size;
+  size_t value_count = stream._value_count;
+
+  do {
+    const uint8_t* comma = p;
+    const uint8_t* start = skip_blanks(comma + 1, end);
+    uint64_t val = 0;
+
+    if (start == end)
+      break;
+
+    if (start[0] == '0' && (size_t)(end - start) >= 2 && (start[1] | 0x20u) == 'x') {
+      p = scan_hex_digits(start + 2, end, val);
+      if (p == start + 2)
+        break;
+    }
+    else {
+      p = scan_dec_digits(start, end, val);
+      // Numbers starting with '0' are octal.
+      if (p == start || (start[0] == '0' && p != start + 1))
+        break;
+    }
+
+    // Suffixes, floating point literals, and symbols are left to `next()`.
+    if (p != end && CharMap[p[0]] <= kCharDot)
+      break;
+
+    stream._types[size] = AsmTokenType::kComma;
+    stream._offsets[size] = uint32_t(size_t(comma - input));
+    stream._sizes[size] = 1;
+    size++;
+
+    stream._types[size] = AsmTokenType::kU64;
+    stream._offsets[size] = uint32_t(size_t(start - input));
+    stream._sizes[size] = uint32_t(size_t(p - start));
+    stream._values[value_count++] = val;
+    size++;
+
+    tokenizer._cur = p;
+    p = skip_blanks(p, end);
+  } while (p != end && p[0] == ',');
+
+  stream._size = size;
+  stream._value_count = value_count;
+  return Error::kOk;
+}
+
+// ============================================================================
+// [asmtk::AsmTokenStream]
+// ============================================================================
+
+AsmTokenStream::AsmTokenStream() noexcept
+  : _input(nullptr),
+    _types(nullptr),
+    _offsets(nullptr),
+    _sizes(nullptr),
+    _values(nullptr),
+    _size(0),
+    _capacity(0),
+    _value_count(0),
+    _value_capacity(0) {}
+
+AsmTokenStream::~AsmTokenStream() noexcept {
+  reset();
+}
+
+void AsmTokenStream::reset() noexcept {
+  ::free(_types);
+  ::free(_offsets);
+  ::free(_sizes);
+  ::free(_values);
+
+  _types = nullptr;
+  _offsets = nullptr;
+  _sizes = nullptr;
+  _values = nullptr;
+
+  _size = 0;
+  _capacity = 0;
+  _value_count = 0;
+  _value_capacity = 0;
+}
+
+static size_t token_stream_grow_capacity(size_t capacity, size_t n) noexcept {
+  size_t new_capacity = std::max<size_t>(capacity, 1024);
+  while (new_capacity < n)
+    new_capacity *= 2;
+  return new_capacity;
+}
+
+Error AsmTokenStream::reserve(size_t n) noexcept {
+  if (n <= _capacity)
+    return Error::kOk;
+
+  size_t new_capacity = token_stream_grow_capacity(_capacity, n);
+  if (ASMJIT_UNLIKELY(new_capacity > SIZE_MAX / sizeof(uint32_t)))
+    return make_error(Error::kOutOfMemory);
+
+  AsmTokenType* new_types = static_cast<AsmTokenType*>(::realloc(_types, new_capacity * sizeof(AsmTokenType)));
+  if (ASMJIT_UNLIKELY(!new_types))
+    return make_error(Error::kOutOfMemory);
+  _types = new_types;
+
+  uint32_t* new_offsets = static_cast<uint32_t*>(::realloc(_offsets, new_capacity * sizeof(uint32_t)));
+  if (ASMJIT_UNLIKELY(!new_offsets))
+    return make_error(Error::kOutOfMemory);
+  _offsets = new_offsets;
+
+  uint32_t* new_sizes = static_cast<uint32_t*>(::realloc(_sizes, new_capacity * sizeof(uint32_t)));
+  if (ASMJIT_UNLIKELY(!new_sizes))
+    return make_error(Error::kOutOfMemory);
+  _sizes = new_sizes;
+
+  _capacity = new_capacity;
+  return Error::kOk;
+}
+
+Error AsmTokenStream::reserve_values(size_t n) noexcept {
+  if (n <= _value_capacity)
+    return Error::kOk;
+
+  size_t new_capacity = token_stream_grow_capacity(_value_capacity, n);
+  if (ASMJIT_UNLIKELY(new_capacity > SIZE_MAX / sizeof(uint64_t)))
+    return make_error(Error::kOutOfMemory);
+
+  uint64_t* new_values = static_cast<uint64_t*>(::realloc(_values, new_capacity * sizeof(uint64_t)));
+  if (ASMJIT_UNLIKELY(!new_values))
+    return make_error(Error::kOutOfMemory);
+
+  _values = new_values;
+  _value_capacity = new_capacity;
+  return Error::kOk;
+}
+
 // ============================================================================
 // [asmtk::AsmTokenizer]
 // ============================================================================
@@ -89,8 +405,7 @@ static const uint8_t CharMap[] = {
 AsmTokenizer::AsmTokenizer() noexcept
   : _input(nullptr),
     _end(nullptr),
-    _cur(nullptr),
-    _stodctx() {}
+    _cur(nullptr) {}
 
 AsmTokenizer::~AsmTokenizer() noexcept {}
 
@@ -112,17 +427,22 @@ AsmTokenType AsmTokenizer::next(AsmToken* token, ParseFlags parse_flags) noexcep
   // ----------------
 
   if (m == kCharSpc) {
-    do {
+    if (c == '\n') {
       cur++;
-      if (c == '\n')
-        goto NL;
+      goto NL;
+    }
 
-      if (cur == end)
-        goto End;
+    cur = ScanUtils::skip_spaces(cur + 1, end);
+    if (cur == end)
+      goto End;
 
-      c = cur[0];
-      m = CharMap[c];
-    } while (m == kCharSpc);
+    c = cur[0];
+    m = CharMap[c];
+
+    if (c == '\n') {
+      cur++;
+      goto NL;
+    }
   }
 
   // Skip Comment
@@ -135,13 +455,10 @@ AsmTokenType AsmTokenizer::next(AsmToken* token, ParseFlags parse_flags) noexcep
     is_comment = true;
 
   if (is_comment) {
-    for (;;) {
-      if (++cur == end)
-        goto End;
-      c = cur[0];
-      if (c == '\n')
-        goto NL;
-    }
+    cur = ScanUtils::find_newline(cur + 1, end);
+    if (cur == end)
+      goto End;
+    goto NL;
   }
 
   // The beginning of the token.
@@ -153,6 +470,7 @@ AsmTokenType AsmTokenizer::next(AsmToken* token, ParseFlags parse_flags) noexcep
   if (c == '$') {
     if (++cur == end) {
       _cur = cur;
+      token->set_symbol_info(AsmToken::hash_symbol_char(AsmToken::kSymbolHashInit, '$'), AsmToken::kNoDot);
       return token->set_data(AsmTokenType::kSym, start, cur);
     }
 
@@ -179,6 +497,26 @@ AsmTokenType AsmTokenizer::next(AsmToken* token, ParseFlags parse_flags) noexcep
     // The number either starts with [0..9], which could contain an optional
     // [0x|0b] prefixes, or $[0-9], which is a hexadecimal prefix as well.
     if (m <= kChar0x9) {
+      // Parse a decimal floating point literal, which always starts with a digit and is never prefixed by '$'.
+      if ((state_flags & kStateDollarPrefix) == 0) {
+        const uint8_t* fp_end;
+        FloatScanResult result = scan_float(cur, end, &fp_end);
+
+        if (result != kFloatScanNone) {
+          cur = fp_end;
+          if (result == kFloatScanInvalid)
+            goto Invalid;
+
+          bool overflow;
+          StrToD::parse_f64(start, (size_t)(cur - start), &token->_f64, &overflow);
+          if (overflow)
+            goto Invalid;
+
+          _cur = cur;
+          return token->set_data(AsmTokenType::kF64, start, cur);
+        }
+      }
+
       uint64_t val = m;
       uint32_t base = 10;
       uint32_t shift = 0;
@@ -357,17 +695,34 @@ ParseHex:
   if (m <= kCharUsd) {
     uint32_t mSymMax = asmjit::Support::test(parse_flags, ParseFlags::kIncludeDashes) ? kCharDsh : kCharUsd;
 
-    while (++cur != end) {
+    // The symbol is hashed while it's scanned, so the parser doesn't have to hash it again when it's used as a label.
+    uint32_t hash = AsmToken::kSymbolHashInit;
+    size_t dot_index = AsmToken::kNoDot;
+
+    for (const uint8_t* p = start; p != cur; p++) {
+      if (p[0] == '.' && dot_index == AsmToken::kNoDot)
+        dot_index = (size_t)(p - start);
+      hash = AsmToken::hash_symbol_char(hash, p[0]);
+    }
+
+    c = cur[0];
+    for (;;) {
+      if (c == '.' && dot_index == AsmToken::kNoDot)
+        dot_index = (size_t)(cur - start);
+      hash = AsmToken::hash_symbol_char(hash, c);
+
+      if (++cur == end)
+        break;
+
       c = cur[0];
       m = CharMap[c];
 
-      if (m <= mSymMax)
-        continue;
-
-      break;
+      if (m > mSymMax)
+        break;
     }
 
     _cur = cur;
+    token->set_symbol_info(hash, dot_index);
     return token->set_data(AsmTokenType::kSym, start, cur);
   }
 
@@ -375,6 +730,18 @@ ParseHex:
   // -----------------
 
   if (m <= kCharPcn) {
+    // A string literal ends at the closing quote, a string not closed on the same line is invalid.
+    if (c == '"') {
+      while (++cur != end && cur[0] != '"' && cur[0] != '\n')
+        continue;
+
+      if (cur == end || cur[0] != '"')
+        goto Invalid;
+
+      _cur = ++cur;
+      return token->set_data(AsmTokenType::kString, start, cur);
+    }
+
     AsmTokenType type = AsmTokenType::kOther;
     switch (c) {
       case '{': type = AsmTokenType::kLCurl   ; break;
@@ -407,4 +774,31 @@ End:
   return token->set_data(AsmTokenType::kEnd, start, cur);
 }
 
+Error AsmTokenizer::tokenize_all(AsmTokenStream& stream, size_t max_tokens) noexcept {
+  AsmToken token;
+  ParseFlags parse_flags = ParseFlags::kNone;
+
+  size_t limit = stream.size() + std::min<size_t>(max_tokens, SIZE_MAX - stream.size());
+  stream._input = _input;
+
+  for (;;) {
+    AsmTokenType type = next(&token, parse_flags);
+    ASMJIT_PROPAGATE(stream.append(token));
+
+    if (type == AsmTokenType::kU64)
+      ASMJIT_PROPAGATE(scan_number_list(*this, stream));
+
+    if (type == AsmTokenType::kEnd)
+      break;
+
+    if (type == AsmTokenType::kNL && stream.size() >= limit)
+      break;
+
+    parse_flags = type == AsmTokenType::kLCurl ? ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes
+                                               : ParseFlags::kNone;
+  }
+
+  return Error::kOk;
+}
+
 } // {asmtk}
@@ -19,6 +19,8 @@ enum class AsmTokenType : uint8_t {
   kNSym,
   kU64,
   kF64,
+  //! String literal in double quotes, the token includes the quotes (there are no escape sequences).
+  kString,
   kLCurl,
   kRCurl,
   kLBracket,
@@ -37,10 +39,23 @@ enum class AsmTokenType : uint8_t {
 
 //! Token.
 struct AsmToken {
+  //! \name Constants
+  //! \{
+
+  //! Returned by `symbol_dot_index()` if the symbol has no '.'.
+  static constexpr uint32_t kNoDot = 0xFFFFFFFFu;
+
+  //! Initial value of a symbol hash.
+  static constexpr uint32_t kSymbolHashInit = 0x811C9DC5u;
+
+  //! \}
+
   //! \name Members
   //! \{
 
   AsmTokenType _type;
+  //! Index of the token in `AsmTokenStream` (only valid if the token was fetched from a stream).
+  uint32_t _index;
   const uint8_t* _data;
   size_t _size;
 
@@ -79,6 +94,13 @@ struct AsmToken {
     return _data[index];
   }
 
+  //! Returns the hash of a symbol (only valid for `AsmTokenType::kSym` tokens), see `hash_symbol_char()`.
+  inline uint32_t symbol_hash() const noexcept { return uint32_t(_u64 & 0xFFFFFFFFu); }
+
+  //! Returns the index of the first '.' in a symbol (only valid for `AsmTokenType::kSym` tokens), or `kNoDot` if the
+  //! symbol has no dot or if its index cannot be represented by 32 bits.
+  inline uint32_t symbol_dot_index() const noexcept { return uint32_t(_u64 >> 32); }
+
   inline double f64_value() const noexcept { return _f64; }
   inline int64_t i64_value() const noexcept { return _i64; }
   inline uint64_t u64_value() const noexcept { return _u64; }
@@ -87,11 +109,21 @@ struct AsmToken {
 
   inline void reset() noexcept {
     _type = AsmTokenType::kEnd;
+    _index = 0;
     _data = nullptr;
     _size = 0;
     _u64 = 0;
   }
 
+  inline void set_symbol_info(uint32_t hash, size_t dot_index) noexcept {
+    _u64 = uint64_t(hash) | (uint64_t(std::min<size_t>(dot_index, kNoDot)) << 32);
+  }
+
+  //! Advances the symbol `hash` by a character `c` (FNV-1a).
+  static inline uint32_t hash_symbol_char(uint32_t hash, uint32_t c) noexcept {
+    return (hash ^ c) * 0x01000193u;
+  }
+
   inline AsmTokenType set_data(AsmTokenType type, const uint8_t* data, size_t size) noexcept {
     _data = data;
     _size = size;
@@ -114,6 +146,133 @@ enum class ParseFlags {
 };
 ASMJIT_DEFINE_ENUM_FLAGS(ParseFlags)
 
+//! Token stream - tokens stored as struct-of-arrays.
+//!
+//! The stream is filled by `AsmTokenizer::tokenize_all()` in a single linear pass. Each token is described by its
+//! type, and a 32-bit offset and size relative to the tokenizer input. Values of numeric tokens and hashes of symbols
+//! are stored in a separate side table in the order in which the tokens appear, so only these pay for 8 bytes of
+//! value.
+//!
+//! The stream keeps its storage when cleared so it can be refilled without reallocating.
+class AsmTokenStream {
+public:
+  //! \name Members
+  //! \{
+
+  const uint8_t* _input;
+  AsmTokenType* _types;
+  uint32_t* _offsets;
+  uint32_t* _sizes;
+  uint64_t* _values;
+
+  size_t _size;
+  size_t _capacity;
+  size_t _value_count;
+  size_t _value_capacity;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMTK_API AsmTokenStream() noexcept;
+  ASMTK_API ~AsmTokenStream() noexcept;
+
+  AsmTokenStream(const AsmTokenStream& other) = delete;
+  AsmTokenStream& operator=(const AsmTokenStream& other) = delete;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the input the token offsets are relative to.
+  inline const uint8_t* input() const noexcept { return _input; }
+
+  inline bool is_empty() const noexcept { return _size == 0; }
+  inline size_t size() const noexcept { return _size; }
+  inline size_t value_count() const noexcept { return _value_count; }
+
+  inline const AsmTokenType* types() const noexcept { return _types; }
+  inline const uint32_t* offsets() const noexcept { return _offsets; }
+  inline const uint32_t* sizes() const noexcept { return _sizes; }
+  inline const uint64_t* values() const noexcept { return _values; }
+
+  //! Tests whether the token of the given `type` has a value stored in the side table.
+  static inline bool has_value(AsmTokenType type) noexcept {
+    return type == AsmTokenType::kSym || type == AsmTokenType::kU64 || type == AsmTokenType::kF64;
+  }
+
+  //! Materializes a token at `index` into `token`, `value_index` is the index to the value side table, which is
+  //! advanced in case the token has a value.
+  inline AsmTokenType fetch(size_t index, size_t& value_index, AsmToken* token) const noexcept {
+    ASMJIT_ASSERT(index < _size);
+
+    AsmTokenType type = _types[index];
+    token->_index = uint32_t(index);
+    token->_u64 = 0;
+
+    if (has_value(type)) {
+      ASMJIT_ASSERT(value_index < _value_count);
+      token->_u64 = _values[value_index++];
+    }
+
+    return token->set_data(type, _input + _offsets[index], _sizes[index]);
+  }
+
+  //! \}
+
+  //! \name Utilities
+  //! \{
+
+  //! Clears the stream, but keeps the allocated storage.
+  inline void clear() noexcept {
+    _size = 0;
+    _value_count = 0;
+  }
+
+  //! Swaps the contents (including the allocated storage) of this stream with `other`.
+  inline void swap(AsmTokenStream& other) noexcept {
+    std::swap(_input, other._input);
+    std::swap(_types, other._types);
+    std::swap(_offsets, other._offsets);
+    std::swap(_sizes, other._sizes);
+    std::swap(_values, other._values);
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+    std::swap(_value_count, other._value_count);
+    std::swap(_value_capacity, other._value_capacity);
+  }
+
+  //! Releases the allocated storage.
+  ASMTK_API void reset() noexcept;
+
+  //! Reserves space for at least `n` tokens.
+  ASMTK_API Error reserve(size_t n) noexcept;
+  //! Reserves space for at least `n` values.
+  ASMTK_API Error reserve_values(size_t n) noexcept;
+
+  //! Appends a token to the stream.
+  inline Error append(const AsmToken& token) noexcept {
+    if (ASMJIT_UNLIKELY(_size == _capacity))
+      ASMJIT_PROPAGATE(reserve(_size + 1));
+
+    if (has_value(token.type())) {
+      if (ASMJIT_UNLIKELY(_value_count == _value_capacity))
+        ASMJIT_PROPAGATE(reserve_values(_value_count + 1));
+      _values[_value_count++] = token.u64_value();
+    }
+
+    _types[_size] = token.type();
+    _offsets[_size] = uint32_t(size_t(token.data() - _input));
+    _sizes[_size] = uint32_t(token.size());
+    _size++;
+    return Error::kOk;
+  }
+
+  //! \}
+};
+
 //! Tokenizer.
 class AsmTokenizer {
 public:
@@ -125,6 +284,17 @@ public:
   //! Parses a next `token` and advances.
   ASMTK_API AsmTokenType next(AsmToken* token, ParseFlags parse_flags = ParseFlags::kNone) noexcept;
 
+  //! Tokenizes the input into `stream` (appends) until the end of the input is reached, in which case the last
+  //! token appended is `AsmTokenType::kEnd`.
+  //!
+  //! If `max_tokens` is specified the tokenizer stops at the first end of line (inclusive) after at least
+  //! `max_tokens` tokens were appended, so the input can be tokenized in batches of complete lines. Tokens that
+  //! follow `AsmTokenType::kLCurl` are parsed with `ParseFlags::kParseSymbol | ParseFlags::kIncludeDashes`, as
+  //! that's how the parser reads AVX-512 options like `{1to16}` or `{rn-sae}`.
+  //!
+  //! \note The stream uses 32-bit offsets, so the input must not be larger than 4GB.
+  ASMTK_API Error tokenize_all(AsmTokenStream& stream, size_t max_tokens = SIZE_MAX) noexcept;
+
   //! Puts a token back to the tokenizer so that `next()` would parse it again.
   inline void put_back(AsmToken* token) noexcept {
     _cur = token->data();
@@ -143,8 +313,6 @@ public:
   const uint8_t* _input;
   const uint8_t* _end;
   const uint8_t* _cur;
-
-  StrToD _stodctx;
 };
 
 } // {asmtk}
@@ -14,6 +14,10 @@
 #include <cstdlib>
 #include <cstring>
 
+// Library version - the version of the library the code was compiled against.
+#define ASMTK_LIBRARY_MAKE_VERSION(major, minor, patch) ((major << 16) | (minor << 8) | (patch))
+#define ASMTK_LIBRARY_VERSION ASMTK_LIBRARY_MAKE_VERSION(1, 0, 0)
+
 // DEPRECATED: Will be removed in the future.
 #if defined(ASMTK_BUILD_STATIC)
   #pragma message("'ASMTK_BUILD_STATIC' is deprecated, use 'ASMTK_STATIC'")
@@ -0,0 +1,67 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./labelutils_p.h"
+
+namespace asmtk {
+namespace LabelUtils {
+
+using namespace asmjit;
+
+// ============================================================================
+// [asmtk::LabelUtils]
+// ============================================================================
+
+Label find_label(BaseEmitter* emitter, const SymbolName& symbol, uint32_t current_global_label_id, Label* parent_out) noexcept {
+  Label parent;
+  Label label;
+
+  if (symbol.has_local_name()) {
+    if (symbol.is_relative())
+      parent.set_id(current_global_label_id);
+    else
+      parent = emitter->label_by_name(reinterpret_cast<const char*>(symbol.name), symbol.parent_name_size);
+
+    if (parent.is_valid())
+      label = emitter->label_by_name(reinterpret_cast<const char*>(symbol.local_name), symbol.local_name_size, parent.id());
+  }
+  else {
+    label = emitter->label_by_name(reinterpret_cast<const char*>(symbol.name), symbol.name_size);
+  }
+
+  *parent_out = parent;
+  return label;
+}
+
+Error new_label(BaseEmitter* emitter, const SymbolName& symbol, Label parent, Label* out) noexcept {
+  Label label;
+
+  if (symbol.has_local_name()) {
+    if (!parent.is_valid()) {
+      if (!symbol.parent_name_size)
+        return make_error(Error::kInvalidParentLabel);
+
+      parent = emitter->new_named_label(reinterpret_cast<const char*>(symbol.name), symbol.parent_name_size, LabelType::kGlobal);
+      if (!parent.is_valid())
+        return make_error(Error::kOutOfMemory);
+    }
+    label = emitter->new_named_label(reinterpret_cast<const char*>(symbol.local_name), symbol.local_name_size, LabelType::kLocal, parent.id());
+  }
+  else {
+    label = emitter->new_named_label(reinterpret_cast<const char*>(symbol.name), symbol.name_size, LabelType::kGlobal);
+  }
+
+  if (!label.is_valid())
+    return make_error(Error::kOutOfMemory);
+
+  *out = label;
+  return Error::kOk;
+}
+
+} // {LabelUtils}
+} // {asmtk}
@@ -0,0 +1,97 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_LABELUTILS_P_H
+#define _ASMTK_LABELUTILS_P_H
+
+#include "./globals.h"
+#include "./asmtokenizer.h"
+
+namespace asmtk {
+namespace LabelUtils {
+
+// ============================================================================
+// [asmtk::LabelUtils]
+// ============================================================================
+
+// Symbols are resolved to labels by the following rules, shared by `AsmParser` and `AsmRecord::replay()`:
+//
+//   - "name"         - global label "name".
+//   - "parent.local" - local label "local" of global label "parent".
+//   - ".local"       - local label "local" of the current global label (the last global label bound).
+//   - "..name"       - global label "..name".
+//
+// Labels that don't exist are created.
+
+//! Symbol name split into its parent and local part.
+struct SymbolName {
+  const uint8_t* name;
+  size_t name_size;
+
+  //! Local part of "parent.local" or ".local", null if the name has no local part.
+  const uint8_t* local_name;
+  size_t local_name_size;
+
+  //! Size of the parent part (zero in case of ".local"), `name_size` if the name has no local part.
+  size_t parent_name_size;
+
+  inline bool has_local_name() const noexcept { return local_name != nullptr; }
+
+  //! Tests whether the name is ".local", which depends on the current global label.
+  inline bool is_relative() const noexcept { return local_name != nullptr && name[0] == '.'; }
+};
+
+//! Splits a symbol `name` of `name_size`, `dot_index` is the index of the first '.' provided by the tokenizer (see
+//! `AsmToken::symbol_dot_index()`).
+static inline SymbolName split_symbol_name(const uint8_t* name, size_t name_size, uint32_t dot_index) noexcept {
+  SymbolName out { name, name_size, nullptr, 0, name_size };
+
+  // Don't do anything if the name starts with "..".
+  if (name_size >= 2 && name[0] == '.' && name[1] == '.')
+    return out;
+
+  // The tokenizer provides the index of the first '.', unless the symbol is too long to represent it.
+  size_t index = dot_index;
+  if (ASMJIT_UNLIKELY(dot_index == AsmToken::kNoDot && name_size > AsmToken::kNoDot)) {
+    const void* dot = memchr(name, '.', name_size);
+    index = dot ? (size_t)(static_cast<const uint8_t*>(dot) - name) : name_size;
+  }
+
+  if (index < name_size) {
+    out.parent_name_size = index;
+    out.local_name = name + index + 1;
+    out.local_name_size = name_size - index - 1;
+  }
+
+  return out;
+}
+
+//! Tests whether `label_id` refers to a named label of the given `name` and `parent_id`. Named labels are unique within
+//! their parent, so a matching label is exactly the one `label_by_name()` would return.
+static inline bool is_label_named(asmjit::CodeHolder* code, uint32_t label_id, const uint8_t* name, size_t name_size, uint32_t parent_id) noexcept {
+  if (label_id >= code->label_count())
+    return false;
+
+  const asmjit::LabelEntry& le = code->label_entry_of(label_id);
+  return le.has_name() &&
+         le.parent_id() == parent_id &&
+         le.name_size() == name_size &&
+         memcmp(le.name(), name, name_size) == 0;
+}
+
+//! Finds an existing label of `symbol`, returns an invalid label if it doesn't exist.
+//!
+//! The parent of a local label is stored to `parent_out` (invalid if it doesn't exist either), to be passed to
+//! `new_label()` if the label has to be created.
+asmjit::Label find_label(asmjit::BaseEmitter* emitter, const SymbolName& symbol, uint32_t current_global_label_id, asmjit::Label* parent_out) noexcept;
+
+//! Creates a label of `symbol` (and its parent in case of "parent.local" if `parent` is not valid).
+Error new_label(asmjit::BaseEmitter* emitter, const SymbolName& symbol, asmjit::Label parent, asmjit::Label* out) noexcept;
+
+} // {LabelUtils}
+} // {asmtk}
+
+#endif // _ASMTK_LABELUTILS_P_H
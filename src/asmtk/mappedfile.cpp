@@ -0,0 +1,170 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./mappedfile_p.h"
+
+#if defined(_WIN32)
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace asmtk {
+
+using namespace asmjit;
+
+// An empty file cannot be mapped, the mapping then points here.
+static const uint8_t mapped_file_empty[1] = { 0 };
+
+// ============================================================================
+// [asmtk::MappedFile - Construction & Destruction]
+// ============================================================================
+
+MappedFile::MappedFile() noexcept
+  : _data(mapped_file_empty),
+    _size(0) {
+#if defined(_WIN32)
+  _file_handle = nullptr;
+  _mapping_handle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() noexcept {
+  close();
+}
+
+// ============================================================================
+// [asmtk::MappedFile - Mapping (Windows)]
+// ============================================================================
+
+#if defined(_WIN32)
+
+Error MappedFile::open(const char* path) noexcept {
+  close();
+
+  HANDLE file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return make_error(Error::kFailedToOpenFile);
+
+  LARGE_INTEGER file_size;
+  if (!::GetFileSizeEx(file, &file_size)) {
+    ::CloseHandle(file);
+    return make_error(Error::kFailedToOpenFile);
+  }
+
+  if (uint64_t(file_size.QuadPart) > uint64_t(SIZE_MAX)) {
+    ::CloseHandle(file);
+    return make_error(Error::kTooLarge);
+  }
+
+  if (file_size.QuadPart == 0) {
+    ::CloseHandle(file);
+    return Error::kOk;
+  }
+
+  HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    ::CloseHandle(file);
+    return make_error(Error::kFailedToOpenFile);
+  }
+
+  void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    ::CloseHandle(mapping);
+    ::CloseHandle(file);
+    return make_error(Error::kFailedToOpenFile);
+  }
+
+  _data = static_cast<const uint8_t*>(data);
+  _size = size_t(file_size.QuadPart);
+  _file_handle = file;
+  _mapping_handle = mapping;
+
+  return Error::kOk;
+}
+
+void MappedFile::close() noexcept {
+  if (_size) {
+    ::UnmapViewOfFile(_data);
+    ::CloseHandle(static_cast<HANDLE>(_mapping_handle));
+    ::CloseHandle(static_cast<HANDLE>(_file_handle));
+  }
+
+  _data = mapped_file_empty;
+  _size = 0;
+  _file_handle = nullptr;
+  _mapping_handle = nullptr;
+}
+
+#endif
+
+// ============================================================================
+// [asmtk::MappedFile - Mapping (Posix)]
+// ============================================================================
+
+#if !defined(_WIN32)
+
+Error MappedFile::open(const char* path) noexcept {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return make_error(Error::kFailedToOpenFile);
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return make_error(Error::kFailedToOpenFile);
+  }
+
+  if (uint64_t(st.st_size) > uint64_t(SIZE_MAX)) {
+    ::close(fd);
+    return make_error(Error::kTooLarge);
+  }
+
+  size_t size = size_t(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return Error::kOk;
+  }
+
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping holds its own reference to the file.
+  ::close(fd);
+
+  if (data == MAP_FAILED)
+    return make_error(Error::kFailedToOpenFile);
+
+  // Only a hint - the file is read once from the beginning to the end, so the kernel can read ahead aggressively
+  // and drop pages that were already parsed.
+  ::posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+
+  _data = static_cast<const uint8_t*>(data);
+  _size = size;
+
+  return Error::kOk;
+}
+
+void MappedFile::close() noexcept {
+  if (_size)
+    ::munmap(const_cast<uint8_t*>(_data), _size);
+
+  _data = mapped_file_empty;
+  _size = 0;
+}
+
+#endif
+
+} // {asmtk}
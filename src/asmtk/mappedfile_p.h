@@ -0,0 +1,70 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_MAPPEDFILE_P_H
+#define _ASMTK_MAPPEDFILE_P_H
+
+#include "./globals.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::MappedFile]
+// ============================================================================
+
+//! Read-only memory mapping of a whole file, which is expected to be read sequentially.
+class MappedFile {
+public:
+  //! \name Members
+  //! \{
+
+  const uint8_t* _data;
+  size_t _size;
+
+#if defined(_WIN32)
+  void* _file_handle;
+  void* _mapping_handle;
+#endif
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  MappedFile() noexcept;
+  ~MappedFile() noexcept;
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the mapped content, which is not null-terminated (never null, even if the file is empty).
+  inline const uint8_t* data() const noexcept { return _data; }
+  //! Returns the size of the mapped content.
+  inline size_t size() const noexcept { return _size; }
+
+  //! \}
+
+  //! \name Mapping
+  //! \{
+
+  //! Maps a file at `path`. Returns `Error::kFailedToOpenFile` if the file cannot be opened or mapped, and
+  //! `Error::kTooLarge` if it doesn't fit into the address space.
+  Error open(const char* path) noexcept;
+
+  //! Unmaps the file, does nothing if it's not mapped.
+  void close() noexcept;
+
+  //! \}
+};
+
+} // {asmtk}
+
+#endif // _ASMTK_MAPPEDFILE_P_H
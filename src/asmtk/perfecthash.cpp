@@ -0,0 +1,104 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./perfecthash_p.h"
+
+namespace asmtk {
+namespace PerfectHash {
+
+// ============================================================================
+// [asmtk::PerfectHash - Build]
+// ============================================================================
+
+// Assigns a seed to each bucket, buckets having the most keys first, as these are the hardest to place.
+bool build(const uint64_t* hashes, uint32_t count,
+           uint16_t* seeds, uint32_t bucket_count,
+           uint16_t* slots, uint32_t slot_count) noexcept {
+  if (count >= 0xFFFFu || count > slot_count)
+    return false;
+
+  memset(seeds, 0, bucket_count * sizeof(uint16_t));
+  memset(slots, 0, slot_count * sizeof(uint16_t));
+
+  // Scratch: [bucket_start (bucket_count + 1)] [bucket_fill (bucket_count)] [bucket_order (bucket_count)] [keys].
+  size_t scratch_size = (size_t(bucket_count) * 3u + 1u + count) * sizeof(uint32_t);
+  uint32_t* scratch = static_cast<uint32_t*>(::malloc(scratch_size));
+
+  if (ASMJIT_UNLIKELY(!scratch))
+    return false;
+
+  uint32_t* bucket_start = scratch;
+  uint32_t* bucket_fill = bucket_start + bucket_count + 1u;
+  uint32_t* bucket_order = bucket_fill + bucket_count;
+  uint32_t* bucket_keys = bucket_order + bucket_count;
+
+  memset(bucket_start, 0, (size_t(bucket_count) + 1u) * sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < count; i++)
+    bucket_start[bucket_of(hashes[i], bucket_count) + 1u]++;
+
+  for (uint32_t b = 0; b < bucket_count; b++) {
+    bucket_start[b + 1u] += bucket_start[b];
+    bucket_fill[b] = bucket_start[b];
+    bucket_order[b] = b;
+  }
+
+  for (uint32_t i = 0; i < count; i++)
+    bucket_keys[bucket_fill[bucket_of(hashes[i], bucket_count)]++] = i;
+
+  std::sort(bucket_order, bucket_order + bucket_count, [&](uint32_t a, uint32_t b) noexcept {
+    return bucket_start[a + 1u] - bucket_start[a] > bucket_start[b + 1u] - bucket_start[b];
+  });
+
+  bool ok = true;
+  for (uint32_t i = 0; i < bucket_count && ok; i++) {
+    uint32_t b = bucket_order[i];
+    uint32_t first = bucket_start[b];
+    uint32_t n = bucket_start[b + 1u] - first;
+
+    if (n == 0)
+      break;
+
+    uint32_t seed = 0;
+    for (;;) {
+      uint32_t placed = 0;
+      while (placed < n) {
+        uint32_t key = bucket_keys[first + placed];
+        uint32_t slot = slot_of(hashes[key], seed, slot_count);
+
+        if (slots[slot] != 0)
+          break;
+
+        slots[slot] = uint16_t(key + 1u);
+        placed++;
+      }
+
+      if (placed == n)
+        break;
+
+      // Undo the partial placement and try the next seed.
+      while (placed) {
+        placed--;
+        slots[slot_of(hashes[bucket_keys[first + placed]], seed, slot_count)] = 0;
+      }
+
+      if (++seed > 0xFFFFu) {
+        ok = false;
+        break;
+      }
+    }
+
+    seeds[b] = uint16_t(seed);
+  }
+
+  ::free(scratch);
+  return ok;
+}
+
+} // {PerfectHash}
+} // {asmtk}
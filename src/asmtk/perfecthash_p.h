@@ -0,0 +1,49 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_PERFECTHASH_P_H
+#define _ASMTK_PERFECTHASH_P_H
+
+#include "./globals.h"
+
+namespace asmtk {
+namespace PerfectHash {
+
+// ============================================================================
+// [asmtk::PerfectHash]
+// ============================================================================
+
+// Hash and displace - the upper half of a 64-bit hash selects a bucket, which provides a seed that is mixed with
+// the lower half to select a slot. Seeds are chosen by `build()` so that each key has its own slot, so a lookup is
+// always a single probe followed by a single comparison.
+
+//! Returns a bucket of hash `h`, `bucket_count` must be a power of 2.
+static inline uint32_t bucket_of(uint64_t h, uint32_t bucket_count) noexcept {
+  return uint32_t(h >> 32) & (bucket_count - 1u);
+}
+
+//! Returns a slot of hash `h` displaced by `seed`, `slot_count` must be a power of 2.
+static inline uint32_t slot_of(uint64_t h, uint32_t seed, uint32_t slot_count) noexcept {
+  uint32_t x = uint32_t(h) ^ (seed * 0x9E3779B9u);
+  x ^= x >> 16;
+  x *= 0x85EBCA6Bu;
+  x ^= x >> 13;
+  x *= 0xC2B2AE35u;
+  x ^= x >> 16;
+  return x & (slot_count - 1u);
+}
+
+//! Computes `seeds` of `bucket_count` buckets for `count` keys having the given `hashes` and fills `slots` with key
+//! indexes plus one (zero marks an empty slot). Returns false if the keys cannot be placed (too many keys or keys
+//! having the same hash) or on allocation failure.
+bool build(const uint64_t* hashes, uint32_t count,
+           uint16_t* seeds, uint32_t bucket_count,
+           uint16_t* slots, uint32_t slot_count) noexcept;
+
+} // {PerfectHash}
+} // {asmtk}
+
+#endif // _ASMTK_PERFECTHASH_P_H
@@ -0,0 +1,196 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./scanutils_p.h"
+
+#if ASMJIT_ARCH_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define ASMTK_SCAN_SSE2
+  #include <emmintrin.h>
+
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #define ASMTK_SCAN_AVX2
+    #define ASMTK_TARGET_AVX2
+    #include <immintrin.h>
+  #elif defined(__GNUC__) || defined(__clang__)
+    #define ASMTK_SCAN_AVX2
+    #define ASMTK_TARGET_AVX2 __attribute__((__target__("avx2")))
+    #include <immintrin.h>
+  #endif
+#endif
+
+namespace asmtk {
+namespace ScanUtils {
+
+// ============================================================================
+// [asmtk::ScanUtils - Scalar]
+// ============================================================================
+
+static const uint8_t* skip_spaces_scalar(const uint8_t* p, const uint8_t* end) noexcept {
+  while (p != end && is_horizontal_space(p[0]))
+    p++;
+  return p;
+}
+
+static const uint8_t* find_newline_scalar(const uint8_t* p, const uint8_t* end) noexcept {
+  const void* nl = memchr(p, '\n', (size_t)(end - p));
+  return nl ? static_cast<const uint8_t*>(nl) : end;
+}
+
+static size_t index_newlines_scalar(const uint8_t* p, const uint8_t* end, size_t base, size_t* out) noexcept {
+  size_t count = 0;
+  for (size_t i = 0, size = (size_t)(end - p); i < size; i++)
+    if (p[i] == '\n')
+      out[count++] = base + i;
+  return count;
+}
+
+// ============================================================================
+// [asmtk::ScanUtils - SSE2]
+// ============================================================================
+
+#if defined(ASMTK_SCAN_SSE2)
+// A byte is a horizontal space if it's 0x20 or if `byte - 0x09` is at most 4 (unsigned), excluding '\n'. SSE2 has
+// no unsigned byte comparison, but `min_epu8(t, 4) == t` is equivalent to `t <= 4`.
+static inline uint32_t space_mask_sse2(__m128i x) noexcept {
+  __m128i t = _mm_sub_epi8(x, _mm_set1_epi8(0x09));
+  __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(0x04)), t);
+  __m128i is_nl = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+  __m128i is_sp = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+  return uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_andnot_si128(is_nl, in_range), is_sp)));
+}
+
+static const uint8_t* skip_spaces_sse2(const uint8_t* p, const uint8_t* end) noexcept {
+  while ((size_t)(end - p) >= 16) {
+    uint32_t mask = space_mask_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) ^ 0xFFFFu;
+    if (mask)
+      return p + asmjit::Support::ctz(mask);
+    p += 16;
+  }
+  return skip_spaces_scalar(p, end);
+}
+
+static const uint8_t* find_newline_sse2(const uint8_t* p, const uint8_t* end) noexcept {
+  __m128i nl = _mm_set1_epi8('\n');
+  while ((size_t)(end - p) >= 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, nl)));
+    if (mask)
+      return p + asmjit::Support::ctz(mask);
+    p += 16;
+  }
+  return find_newline_scalar(p, end);
+}
+
+// Newlines are dense (a line is a few tens of bytes), so the index is built from the mask of each block instead of
+// calling `find_newline()` for each line.
+static size_t index_newlines_sse2(const uint8_t* p, const uint8_t* end, size_t base, size_t* out) noexcept {
+  __m128i nl = _mm_set1_epi8('\n');
+  size_t count = 0;
+  size_t i = 0;
+  size_t size = (size_t)(end - p);
+
+  for (; size - i >= 16; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, nl)));
+    while (mask) {
+      out[count++] = base + i + asmjit::Support::ctz(mask);
+      mask &= mask - 1u;
+    }
+  }
+
+  return count + index_newlines_scalar(p + i, end, base + i, out + count);
+}
+#endif
+
+// ============================================================================
+// [asmtk::ScanUtils - AVX2]
+// ============================================================================
+
+#if defined(ASMTK_SCAN_AVX2)
+ASMTK_TARGET_AVX2
+static const uint8_t* skip_spaces_avx2(const uint8_t* p, const uint8_t* end) noexcept {
+  __m256i k09 = _mm256_set1_epi8(0x09);
+  __m256i k04 = _mm256_set1_epi8(0x04);
+  __m256i kNL = _mm256_set1_epi8('\n');
+  __m256i kSP = _mm256_set1_epi8(' ');
+
+  while ((size_t)(end - p) >= 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i t = _mm256_sub_epi8(x, k09);
+    __m256i in_range = _mm256_cmpeq_epi8(_mm256_min_epu8(t, k04), t);
+    __m256i is_space = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(x, kNL), in_range), _mm256_cmpeq_epi8(x, kSP));
+
+    uint32_t mask = ~uint32_t(_mm256_movemask_epi8(is_space));
+    if (mask)
+      return p + asmjit::Support::ctz(mask);
+    p += 32;
+  }
+  return skip_spaces_sse2(p, end);
+}
+
+ASMTK_TARGET_AVX2
+static const uint8_t* find_newline_avx2(const uint8_t* p, const uint8_t* end) noexcept {
+  __m256i nl = _mm256_set1_epi8('\n');
+  while ((size_t)(end - p) >= 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    uint32_t mask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl)));
+    if (mask)
+      return p + asmjit::Support::ctz(mask);
+    p += 32;
+  }
+  return find_newline_sse2(p, end);
+}
+
+ASMTK_TARGET_AVX2
+static size_t index_newlines_avx2(const uint8_t* p, const uint8_t* end, size_t base, size_t* out) noexcept {
+  __m256i nl = _mm256_set1_epi8('\n');
+  size_t count = 0;
+  size_t i = 0;
+  size_t size = (size_t)(end - p);
+
+  for (; size - i >= 32; i += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    uint32_t mask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl)));
+    while (mask) {
+      out[count++] = base + i + asmjit::Support::ctz(mask);
+      mask &= mask - 1u;
+    }
+  }
+
+  return count + index_newlines_sse2(p + i, end, base + i, out + count);
+}
+#endif
+
+// ============================================================================
+// [asmtk::ScanUtils - Dispatch]
+// ============================================================================
+
+// Constant-initialized to the scalar implementation so the scanner is usable even before dynamic initialization
+// of this translation unit took place, upgraded by `ScanFuncsInit` at load time.
+ScanFuncs scan_funcs = { skip_spaces_scalar, find_newline_scalar, index_newlines_scalar };
+
+static struct ScanFuncsInit {
+  ScanFuncsInit() noexcept {
+#if defined(ASMTK_SCAN_SSE2)
+    scan_funcs.skip_spaces = skip_spaces_sse2;
+    scan_funcs.find_newline = find_newline_sse2;
+    scan_funcs.index_newlines = index_newlines_sse2;
+#endif
+
+#if defined(ASMTK_SCAN_AVX2)
+    if (asmjit::CpuInfo::host().features().x86().has_avx2()) {
+      scan_funcs.skip_spaces = skip_spaces_avx2;
+      scan_funcs.find_newline = find_newline_avx2;
+      scan_funcs.index_newlines = index_newlines_avx2;
+    }
+#endif
+  }
+} scan_funcs_init;
+
+} // {ScanUtils}
+} // {asmtk}
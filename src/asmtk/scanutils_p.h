@@ -0,0 +1,60 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_SCANUTILS_P_H
+#define _ASMTK_SCANUTILS_P_H
+
+#include "./globals.h"
+
+namespace asmtk {
+namespace ScanUtils {
+
+// ============================================================================
+// [asmtk::ScanUtils]
+// ============================================================================
+
+//! Scanner functions selected at runtime based on the features of the host CPU.
+struct ScanFuncs {
+  //! Returns the first byte in `[p, end)` that is not a horizontal space, or `end`.
+  const uint8_t* (*skip_spaces)(const uint8_t* p, const uint8_t* end) noexcept;
+  //! Returns the first `'\n'` in `[p, end)`, or `end`.
+  const uint8_t* (*find_newline)(const uint8_t* p, const uint8_t* end) noexcept;
+  //! Stores `base` plus the offset of each `'\n'` in `[p, end)` to `out` and returns their count.
+  size_t (*index_newlines)(const uint8_t* p, const uint8_t* end, size_t base, size_t* out) noexcept;
+};
+
+extern ScanFuncs scan_funcs;
+
+//! Tests whether `c` is a space that doesn't terminate a line (0x09, 0x0B-0x0D, 0x20).
+static inline bool is_horizontal_space(uint32_t c) noexcept {
+  return c == ' ' || (c - 0x09u <= 0x04u && c != '\n');
+}
+
+//! Skips horizontal spaces starting at `p`.
+//!
+//! Most tokens are separated by a single space, so the first byte is checked inline before dispatching to the
+//! vectorized scanner, which only pays off on longer runs (indentation, alignment of operands and comments).
+static inline const uint8_t* skip_spaces(const uint8_t* p, const uint8_t* end) noexcept {
+  if (p == end || !is_horizontal_space(p[0]))
+    return p;
+  return scan_funcs.skip_spaces(p + 1, end);
+}
+
+//! Finds the first `'\n'` in `[p, end)`, returns `end` if there is none.
+static inline const uint8_t* find_newline(const uint8_t* p, const uint8_t* end) noexcept {
+  return scan_funcs.find_newline(p, end);
+}
+
+//! Stores `base` plus the offset of each `'\n'` in `[p, end)` to `out`, which must have room for `end - p` offsets,
+//! and returns the number of newlines found.
+static inline size_t index_newlines(const uint8_t* p, const uint8_t* end, size_t base, size_t* out) noexcept {
+  return scan_funcs.index_newlines(p, end, base, out);
+}
+
+} // {ScanUtils}
+} // {asmtk}
+
+#endif // _ASMTK_SCANUTILS_P_H
@@ -0,0 +1,498 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include <float.h>
+
+#include "./strtod.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::StrToD - Format Info]
+// ============================================================================
+
+struct FloatFormatInfo {
+  uint32_t mantissa_bits;
+  uint32_t exponent_bits;
+  int32_t bias;
+};
+
+static const FloatFormatInfo float_format_info[] = {
+  { 10,  5,   -15 }, // kF16
+  { 23,  8,  -127 }, // kF32
+  { 52, 11, -1023 }  // kF64
+};
+
+static inline bool is_digit(uint32_t c) noexcept { return c - uint32_t('0') < 10u; }
+
+// ============================================================================
+// [asmtk::StrToD - Decimal]
+// ============================================================================
+
+// Arbitrary precision decimal used by the slow path, which is exact for all inputs having less than `kMaxDigits`
+// significant digits. Further digits only matter to break ties, which is what the `truncated` flag is for.
+//
+// The algorithm repeatedly shifts the decimal by powers of two until it's in [0.5, 1) and then extracts the
+// mantissa bits, which is slow, but simple and correct for all inputs.
+struct Decimal {
+  static constexpr int kMaxDigits = 800;
+  static constexpr uint32_t kMaxShift = 60;
+
+  uint8_t digits[kMaxDigits]; // Digits (0-9, not ASCII), most significant first.
+  int count;                  // Number of digits used.
+  int point;                  // Position of the decimal point.
+  bool truncated;             // Discarded non-zero digits beyond `count`.
+
+  inline void trim() noexcept {
+    while (count > 0 && digits[count - 1] == 0)
+      count--;
+    if (count == 0)
+      point = 0;
+  }
+
+  // Binary shift left (multiply by 2^k), k <= kMaxShift.
+  void shift_left(uint32_t k) noexcept {
+    uint8_t tmp[kMaxDigits + 24];
+    int w = int(sizeof(tmp));
+    uint64_t n = 0;
+
+    for (int r = count - 1; r >= 0; r--) {
+      n += uint64_t(digits[r]) << k;
+      uint64_t quo = n / 10u;
+      tmp[--w] = uint8_t(n - quo * 10u);
+      n = quo;
+    }
+
+    while (n) {
+      uint64_t quo = n / 10u;
+      tmp[--w] = uint8_t(n - quo * 10u);
+      n = quo;
+    }
+
+    int new_count = int(sizeof(tmp)) - w;
+    point += new_count - count;
+
+    if (new_count > kMaxDigits) {
+      for (int i = kMaxDigits; i < new_count; i++) {
+        if (tmp[w + i]) {
+          truncated = true;
+          break;
+        }
+      }
+      new_count = kMaxDigits;
+    }
+
+    memcpy(digits, tmp + w, size_t(new_count));
+    count = new_count;
+    trim();
+  }
+
+  // Binary shift right (divide by 2^k), k <= kMaxShift.
+  void shift_right(uint32_t k) noexcept {
+    int r = 0;
+    int w = 0;
+    uint64_t n = 0;
+
+    // Pick up enough leading digits to cover the first shift.
+    for (; (n >> k) == 0; r++) {
+      if (r >= count) {
+        if (n == 0) {
+          count = 0;
+          point = 0;
+          return;
+        }
+
+        while ((n >> k) == 0) {
+          n *= 10u;
+          r++;
+        }
+        break;
+      }
+      n = n * 10u + digits[r];
+    }
+    point -= r - 1;
+
+    uint64_t mask = (uint64_t(1) << k) - 1u;
+
+    // Pick up a digit, put down a digit.
+    for (; r < count; r++) {
+      uint64_t c = digits[r];
+      digits[w++] = uint8_t(n >> k);
+      n = ((n & mask) * 10u) + c;
+    }
+
+    // Put down extra digits.
+    while (n) {
+      uint8_t d = uint8_t(n >> k);
+      n &= mask;
+
+      if (w < kMaxDigits)
+        digits[w++] = d;
+      else if (d)
+        truncated = true;
+      n *= 10u;
+    }
+
+    count = w;
+    trim();
+  }
+
+  void shift(int k) noexcept {
+    if (count == 0)
+      return;
+
+    if (k > 0) {
+      while (uint32_t(k) > kMaxShift) {
+        shift_left(kMaxShift);
+        k -= int(kMaxShift);
+      }
+      shift_left(uint32_t(k));
+    }
+    else if (k < 0) {
+      while (uint32_t(-k) > kMaxShift) {
+        shift_right(kMaxShift);
+        k += int(kMaxShift);
+      }
+      shift_right(uint32_t(-k));
+    }
+  }
+
+  // Tests whether rounding to `n` digits should round up (ties to even).
+  bool should_round_up(int n) const noexcept {
+    if (n < 0 || n >= count)
+      return false;
+
+    // Exactly halfway - round to even, unless there are truncated digits that make it a little bit higher.
+    if (digits[n] == 5 && n + 1 == count) {
+      if (truncated)
+        return true;
+      return n > 0 && (digits[n - 1] & 1u) != 0;
+    }
+
+    return digits[n] >= 5;
+  }
+
+  // Returns the integer part rounded to the nearest integer.
+  uint64_t rounded_integer() const noexcept {
+    if (point > 20)
+      return ~uint64_t(0);
+
+    int i = 0;
+    uint64_t n = 0;
+
+    for (; i < point && i < count; i++)
+      n = n * 10u + digits[i];
+
+    for (; i < point; i++)
+      n *= 10u;
+
+    if (should_round_up(point))
+      n++;
+
+    return n;
+  }
+
+  uint64_t to_bits(const FloatFormatInfo& info, bool& overflow) noexcept {
+    // Number of bits to shift by to get at least one decimal digit shifted out (indexed by decimal point).
+    static const uint8_t pow2_for_point[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+    constexpr int kPow2ForPointCount = int(sizeof(pow2_for_point));
+
+    int exponent = 0;
+    uint64_t mantissa = 0;
+    int exponent_limit = (1 << info.exponent_bits) - 1;
+
+    overflow = false;
+
+    if (count == 0) {
+      exponent = info.bias;
+      goto Done;
+    }
+
+    // Obvious overflow / underflow (bounds are for 64-bit floats, which is the largest supported format).
+    if (point > 310)
+      goto Overflow;
+
+    if (point < -330) {
+      exponent = info.bias;
+      goto Done;
+    }
+
+    // Scale by powers of 2 until in range [0.5, 1).
+    while (point > 0) {
+      int n = point >= kPow2ForPointCount ? 27 : int(pow2_for_point[point]);
+      shift(-n);
+      exponent += n;
+    }
+
+    while (point < 0 || (point == 0 && digits[0] < 5)) {
+      int n = -point >= kPow2ForPointCount ? 27 : int(pow2_for_point[-point]);
+      shift(n);
+      exponent -= n;
+    }
+
+    // Our range is [0.5, 1), but the floating point range is [1, 2).
+    exponent--;
+
+    // The minimum representable exponent is `bias + 1` - if the exponent is smaller, move it up and adjust the
+    // decimal accordingly (the result is a subnormal number).
+    if (exponent < info.bias + 1) {
+      int n = info.bias + 1 - exponent;
+      shift(-n);
+      exponent += n;
+    }
+
+    if (exponent - info.bias >= exponent_limit)
+      goto Overflow;
+
+    // Extract `1 + mantissa_bits` bits.
+    shift(int(1 + info.mantissa_bits));
+    mantissa = rounded_integer();
+
+    // Rounding might have added a bit, shift down.
+    if (mantissa == (uint64_t(2) << info.mantissa_bits)) {
+      mantissa >>= 1;
+      exponent++;
+      if (exponent - info.bias >= exponent_limit)
+        goto Overflow;
+    }
+
+    // Subnormal number.
+    if ((mantissa & (uint64_t(1) << info.mantissa_bits)) == 0)
+      exponent = info.bias;
+    goto Done;
+
+Overflow:
+    mantissa = 0;
+    exponent = exponent_limit + info.bias;
+    overflow = true;
+
+Done:
+    uint64_t bits = mantissa & ((uint64_t(1) << info.mantissa_bits) - 1u);
+    bits |= uint64_t(uint32_t(exponent - info.bias) & uint32_t(exponent_limit)) << info.mantissa_bits;
+    return bits;
+  }
+};
+
+// ============================================================================
+// [asmtk::StrToD - Parse]
+// ============================================================================
+
+// Powers of 10 that are exactly representable by double and float, respectively.
+static const double f64_pow10[] = {
+  1e0 , 1e1 , 1e2 , 1e3 , 1e4 , 1e5 , 1e6 , 1e7 , 1e8 , 1e9 , 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const float f32_pow10[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+// Clinger's fast path - if both the significand and the power of 10 are exactly representable, a single IEEE
+// multiplication or division is correctly rounded. Not used when the compiler evaluates floating point operations
+// in a higher precision, as that would round twice.
+static bool convert_fast(uint64_t mantissa, int exponent, FloatFormat format, uint64_t* out) noexcept {
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+  (void)mantissa;
+  (void)exponent;
+  (void)format;
+  (void)out;
+  return false;
+#else
+  if (format == FloatFormat::kF64) {
+    if (mantissa > (uint64_t(1) << 53))
+      return false;
+
+    double value = double(int64_t(mantissa));
+    if (exponent > 22) {
+      // Exact if the significand stays below 2^53 after taking the excess power of 10.
+      if (exponent > 22 + 15)
+        return false;
+
+      value *= f64_pow10[exponent - 22];
+      if (value > 9007199254740992.0)
+        return false;
+      exponent = 22;
+    }
+
+    if (exponent >= 0)
+      value *= f64_pow10[exponent];
+    else if (exponent >= -22)
+      value /= f64_pow10[-exponent];
+    else
+      return false;
+
+    memcpy(out, &value, sizeof(double));
+    return true;
+  }
+
+  if (format == FloatFormat::kF32) {
+    if (mantissa > (uint64_t(1) << 24) || exponent < -10 || exponent > 10)
+      return false;
+
+    float value = float(int64_t(mantissa));
+    if (exponent >= 0)
+      value *= f32_pow10[exponent];
+    else
+      value /= f32_pow10[-exponent];
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    *out = bits;
+    return true;
+  }
+
+  return false;
+#endif
+}
+
+size_t StrToD::parse(const uint8_t* s, size_t size, FloatFormat format, uint64_t* out, bool* overflow) noexcept {
+  const uint8_t* p = s;
+  const uint8_t* end = s + size;
+
+  bool negative = false;
+  bool has_overflow = false;
+
+  *out = 0;
+  if (overflow)
+    *overflow = false;
+
+  if (p != end && (p[0] == '+' || p[0] == '-')) {
+    negative = p[0] == '-';
+    p++;
+  }
+
+  // Parse the significand - up to 19 significant digits fit into 64-bit integer, which is what the fast path
+  // needs. The remaining digits are only scanned here, the slow path parses the input again.
+  uint64_t mantissa = 0;
+  uint32_t mantissa_digits = 0;
+  int exponent = 0;
+  bool truncated = false;
+  bool has_digits = false;
+
+  const uint8_t* digits_start = p;
+
+  while (p != end && is_digit(p[0])) {
+    uint32_t d = uint32_t(p[0]) - '0';
+    has_digits = true;
+
+    if (mantissa_digits < 19) {
+      mantissa = mantissa * 10u + d;
+      mantissa_digits += uint32_t(mantissa != 0);
+    }
+    else {
+      exponent++;
+      truncated |= d != 0;
+    }
+    p++;
+  }
+
+  if (p != end && p[0] == '.') {
+    const uint8_t* frac = p + 1;
+    while (frac != end && is_digit(frac[0])) {
+      uint32_t d = uint32_t(frac[0]) - '0';
+      has_digits = true;
+
+      if (mantissa_digits < 19) {
+        mantissa = mantissa * 10u + d;
+        mantissa_digits += uint32_t(mantissa != 0);
+        exponent--;
+      }
+      else {
+        truncated |= d != 0;
+      }
+      frac++;
+    }
+
+    // A single '.' without digits is not a literal.
+    if (has_digits)
+      p = frac;
+  }
+
+  if (!has_digits)
+    return 0;
+
+  const uint8_t* digits_end = p;
+
+  // Parse the exponent.
+  int exp_value = 0;
+  if (p != end && (p[0] | 0x20u) == 'e') {
+    const uint8_t* q = p + 1;
+    bool exp_negative = false;
+
+    if (q != end && (q[0] == '+' || q[0] == '-')) {
+      exp_negative = q[0] == '-';
+      q++;
+    }
+
+    if (q != end && is_digit(q[0])) {
+      do {
+        // Clamp, the result is zero or infinity anyway.
+        if (exp_value < 100000)
+          exp_value = exp_value * 10 + int(q[0] - '0');
+        q++;
+      } while (q != end && is_digit(q[0]));
+
+      if (exp_negative)
+        exp_value = -exp_value;
+      p = q;
+    }
+  }
+
+  size_t consumed = (size_t)(p - s);
+  uint64_t sign_bit = uint64_t(negative) << (float_format_info[size_t(format)].mantissa_bits + float_format_info[size_t(format)].exponent_bits);
+
+  if (mantissa == 0 && !truncated) {
+    *out = sign_bit;
+    return consumed;
+  }
+
+  if (!truncated && convert_fast(mantissa, exponent + exp_value, format, out)) {
+    *out |= sign_bit;
+    return consumed;
+  }
+
+  // Slow path.
+  Decimal d;
+  d.count = 0;
+  d.point = 0;
+  d.truncated = false;
+
+  bool saw_point = false;
+  for (const uint8_t* q = digits_start; q != digits_end; q++) {
+    if (q[0] == '.') {
+      saw_point = true;
+      d.point = d.count;
+      continue;
+    }
+
+    uint8_t digit = uint8_t(q[0] - '0');
+    if (digit == 0 && d.count == 0) {
+      // Ignore leading zeros.
+      d.point--;
+      continue;
+    }
+
+    if (d.count < Decimal::kMaxDigits)
+      d.digits[d.count++] = digit;
+    else if (digit)
+      d.truncated = true;
+  }
+
+  if (!saw_point)
+    d.point = d.count;
+
+  d.point += exp_value;
+  d.trim();
+
+  *out = d.to_bits(float_format_info[size_t(format)], has_overflow) | sign_bit;
+  if (overflow)
+    *overflow = has_overflow;
+  return consumed;
+}
+
+} // {asmtk}
@@ -9,54 +9,59 @@
 
 #include "./globals.h"
 
-#if defined(_WIN32)
-  #define ASMTK_STRTOD_MSLOCALE
-  #include <locale.h>
-  #include <stdlib.h>
-#else
-  #define ASMTK_STRTOD_XLOCALE
-  #include <locale.h>
-  #include <stdlib.h>
-  // xlocale.h is not available on Linux anymore, it uses <locale.h>.
-  #if defined(__APPLE__    ) || \
-      defined(__bsdi__     ) || \
-      defined(__DragonFly__) || \
-      defined(__FreeBSD__  ) || \
-      defined(__NetBSD__   ) || \
-      defined(__OpenBSD__  )
-    #include <xlocale.h>
-  #endif
-#endif
-
 namespace asmtk {
 
+// ============================================================================
+// [asmtk::FloatFormat]
+// ============================================================================
+
+//! Binary floating point format.
+enum class FloatFormat : uint32_t {
+  //! IEEE-754 binary16 (half precision).
+  kF16,
+  //! IEEE-754 binary32 (single precision).
+  kF32,
+  //! IEEE-754 binary64 (double precision).
+  kF64
+};
+
 // ============================================================================
 // [asmtk::StrToD]
 // ============================================================================
 
+//! Locale-independent conversion of decimal floating point literals to binary floating point.
+//!
+//! The conversion is correctly rounded (round to nearest, ties to even) for all supported formats. Literals whose
+//! significand and exponent are small enough are converted by exact floating point arithmetic (Clinger's fast
+//! path), everything else is converted by a big decimal algorithm that never depends on the current locale.
 class StrToD {
 public:
-#if defined(ASMTK_STRTOD_MSLOCALE)
-  inline StrToD() { handle = _create_locale(LC_ALL, "C"); }
-  inline ~StrToD() { _free_locale(handle); }
-
-  inline bool isOk() const { return handle != nullptr; }
-  inline double conv(const char* s, char** end) const { return _strtod_l(s, end, handle); }
+  //! Parses a literal in the form `[+|-]digits[.digits][(e|E)[+|-]digits]` (the integer part can be omitted if
+  //! the fractional part is present) from `s` of `size` bytes and stores its binary representation of the given
+  //! `format` to `out`.
+  //!
+  //! Returns the number of bytes consumed, zero if `s` doesn't start with a literal. If the value is too large to
+  //! be represented `overflow` is set to true and `out` contains infinity.
+  ASMTK_API static size_t parse(const uint8_t* s, size_t size, FloatFormat format, uint64_t* out, bool* overflow = nullptr) noexcept;
 
-  _locale_t handle;
-#elif defined(ASMTK_STRTOD_XLOCALE)
-  inline StrToD() { handle = newlocale(LC_ALL_MASK, "C", nullptr); }
-  inline ~StrToD() { freelocale(handle); }
+  //! Parses a double precision floating point literal, see `parse()`.
+  static inline size_t parse_f64(const uint8_t* s, size_t size, double* out, bool* overflow = nullptr) noexcept {
+    uint64_t bits = 0;
+    size_t n = parse(s, size, FloatFormat::kF64, &bits, overflow);
+    memcpy(out, &bits, sizeof(double));
+    return n;
+  }
 
-  inline bool isOk() const { return handle != nullptr; }
-  inline double conv(const char* s, char** end) const { return strtod_l(s, end, handle); }
+  //! Compatibility with the `strtod()` interface - converts a null terminated string `s`.
+  inline bool isOk() const noexcept { return true; }
 
-  locale_t handle;
-#else
-  // Time bomb!
-  inline bool isOk() const { return true; }
-  inline double conv(const char* s, char** end) const { return strtod(s, end); }
-#endif
+  inline double conv(const char* s, char** end) const noexcept {
+    double value = 0.0;
+    size_t n = parse_f64(reinterpret_cast<const uint8_t*>(s), strlen(s), &value);
+    if (end)
+      *end = const_cast<char*>(s + n);
+    return value;
+  }
 };
 
 } // {asmtk}
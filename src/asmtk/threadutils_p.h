@@ -0,0 +1,70 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_THREADUTILS_P_H
+#define _ASMTK_THREADUTILS_P_H
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+#include "./globals.h"
+
+namespace asmtk {
+namespace ThreadUtils {
+
+// ============================================================================
+// [asmtk::ThreadUtils]
+// ============================================================================
+
+//! Starts `thread` running `fn(args...)`, returns false if the thread cannot be created.
+//!
+//! `std::thread` reports a failure by throwing `std::system_error`, which would terminate the process when thrown
+//! from a `noexcept` function, so all threads of AsmTK are started by this function.
+template<typename Fn, typename... Args>
+static inline bool start_thread(std::thread& thread, Fn&& fn, Args&&... args) noexcept {
+  try {
+    thread = std::thread(std::forward<Fn>(fn), std::forward<Args>(args)...);
+    return true;
+  }
+  catch (...) {
+    return false;
+  }
+}
+
+//! State of a `call_once()` flag, must be constant-initialized to `kOnceNone`.
+enum OnceState : uint32_t {
+  kOnceNone = 0,
+  kOnceRunning = 1,
+  kOnceDone = 2
+};
+
+//! Tests whether `call_once()` has finished for `flag`.
+static inline bool is_done(const std::atomic<uint32_t>& flag) noexcept {
+  return flag.load(std::memory_order_acquire) == kOnceDone;
+}
+
+//! Calls `fn()` exactly once for `flag`, other callers wait until it returns.
+//!
+//! Function-local statics are not thread-safe as AsmTK is compiled without thread-safe statics, and `std::call_once`
+//! may throw, so data built on first use is guarded by an atomic flag instead.
+template<typename Fn>
+static inline void call_once(std::atomic<uint32_t>& flag, Fn&& fn) noexcept {
+  uint32_t expected = kOnceNone;
+  if (flag.compare_exchange_strong(expected, kOnceRunning, std::memory_order_acquire)) {
+    fn();
+    flag.store(kOnceDone, std::memory_order_release);
+    return;
+  }
+
+  while (!is_done(flag))
+    std::this_thread::yield();
+}
+
+} // {ThreadUtils}
+} // {asmtk}
+
+#endif // _ASMTK_THREADUTILS_P_H
@@ -0,0 +1,160 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./x86mnemonics_p.h"
+
+namespace asmtk {
+namespace X86Mnemonics {
+
+using namespace asmjit;
+
+// ============================================================================
+// [asmtk::X86Mnemonics - Words]
+// ============================================================================
+
+struct AliasWord {
+  char name[8];
+  uint32_t inst_id;
+};
+
+struct OptionWord {
+  char name[12];
+  InstOptions options;
+};
+
+// Aliases take precedence over instructions of the same name (for example `movsd` is both a string instruction and
+// SSE2 instruction, which is decided by operands).
+static const AliasWord alias_words[] = {
+  { "sal"  , x86::Inst::kIdShl },
+  { "insb" , kX86AliasInsb     },
+  { "insw" , kX86AliasInsw     },
+  { "insd" , kX86AliasInsd     },
+  { "cmpsb", kX86AliasCmpsb    },
+  { "cmpsw", kX86AliasCmpsw    },
+  { "cmpsd", kX86AliasCmpsd    },
+  { "cmpsq", kX86AliasCmpsq    },
+  { "lodsb", kX86AliasLodsb    },
+  { "lodsw", kX86AliasLodsw    },
+  { "lodsd", kX86AliasLodsd    },
+  { "lodsq", kX86AliasLodsq    },
+  { "movsb", kX86AliasMovsb    },
+  { "movsw", kX86AliasMovsw    },
+  { "movsd", kX86AliasMovsd    },
+  { "movsq", kX86AliasMovsq    },
+  { "scasb", kX86AliasScasb    },
+  { "scasw", kX86AliasScasw    },
+  { "scasd", kX86AliasScasd    },
+  { "scasq", kX86AliasScasq    },
+  { "stosb", kX86AliasStosb    },
+  { "stosw", kX86AliasStosw    },
+  { "stosd", kX86AliasStosd    },
+  { "stosq", kX86AliasStosq    },
+  { "outsb", kX86AliasOutsb    },
+  { "outsw", kX86AliasOutsw    },
+  { "outsd", kX86AliasOutsd    },
+  { "jrcxz", kX86AliasJrcxz    }
+};
+
+static const OptionWord option_words[] = {
+  { "bnd"     , InstOptions::kX86_Repne    },
+  { "rep"     , InstOptions::kX86_Rep      },
+  { "rex"     , InstOptions::kX86_Rex      },
+  { "vex"     , InstOptions::kX86_Vex      },
+  { "evex"    , InstOptions::kX86_Evex     },
+  { "lock"    , InstOptions::kX86_Lock     },
+  { "long"    , InstOptions::kLongForm     },
+  { "repe"    , InstOptions::kX86_Rep      },
+  { "repz"    , InstOptions::kX86_Rep      },
+  { "vex3"    , InstOptions::kX86_Vex3     },
+  { "modrm"   , InstOptions::kX86_ModRM    },
+  { "modmr"   , InstOptions::kX86_ModMR    },
+  { "repne"   , InstOptions::kX86_Repne    },
+  { "repnz"   , InstOptions::kX86_Repne    },
+  { "short"   , InstOptions::kShortForm    },
+  { "xacquire", InstOptions::kX86_XAcquire },
+  { "xrelease", InstOptions::kX86_XRelease }
+};
+
+// ============================================================================
+// [asmtk::X86Mnemonics - Construction]
+// ============================================================================
+
+Table table;
+std::atomic<uint32_t> table_state { ThreadUtils::kOnceNone };
+
+// Only the first `search_count` entries are searched for duplicates - instruction names provided by AsmJit are
+// unique, so they only have to be checked against aliases.
+static Entry* find_or_add_entry(Table& t, const char* name, size_t size, uint32_t search_count) noexcept {
+  if (size == 0 || size > kMaxNameSize)
+    return nullptr;
+
+  for (uint32_t i = 0; i < search_count; i++) {
+    Entry& entry = t.entries[i];
+    if (entry.size == size && memcmp(entry.name, name, size) == 0)
+      return &entry;
+  }
+
+  if (t.count >= kMaxEntries)
+    return nullptr;
+
+  Entry& entry = t.entries[t.count++];
+  memset(&entry, 0, sizeof(Entry));
+
+  for (size_t i = 0; i < size; i++)
+    entry.name[i] = char(Support::ascii_to_lower<uint8_t>(uint8_t(name[i])));
+
+  entry.size = uint8_t(size);
+  entry.inst_id = x86::Inst::kIdNone;
+  entry.options = InstOptions::kNone;
+  return &entry;
+}
+
+static void build_table(Table& t) noexcept {
+  t.count = 0;
+
+  for (const AliasWord& word : alias_words) {
+    Entry* entry = find_or_add_entry(t, word.name, strlen(word.name), t.count);
+    entry->inst_id = word.inst_id;
+  }
+
+  uint32_t alias_count = t.count;
+
+  StringTmp<64> name;
+  for (uint32_t inst_id = 1; inst_id < uint32_t(x86::Inst::_kIdCount); inst_id++) {
+    name.clear();
+    if (InstAPI::inst_id_to_string(Arch::kX64, inst_id, InstStringifyOptions::kNone, name) != Error::kOk)
+      continue;
+
+    Entry* entry = find_or_add_entry(t, name.data(), name.size(), alias_count);
+    if (entry && entry->inst_id == x86::Inst::kIdNone)
+      entry->inst_id = inst_id;
+  }
+
+  for (const OptionWord& word : option_words) {
+    Entry* entry = find_or_add_entry(t, word.name, strlen(word.name), t.count);
+    entry->options = word.options;
+  }
+
+  uint64_t hashes[kMaxEntries];
+  for (uint32_t i = 0; i < t.count; i++)
+    hashes[i] = hash_word(reinterpret_cast<const uint8_t*>(t.entries[i].name), t.entries[i].size);
+
+  // Cannot fail with a load factor below 0.5 - each bucket has 65536 seeds to choose from.
+  bool ok = PerfectHash::build(hashes, t.count, t.seeds, kBucketCount, t.slots, kSlotCount);
+  ASMJIT_ASSERT(ok);
+  (void)ok;
+}
+
+// The table is built on first lookup and not by a static initializer, which would leave it empty when used by
+// static initializers of other translation units.
+void init_table() noexcept {
+  ThreadUtils::call_once(table_state, [] { build_table(table); });
+}
+
+} // {X86Mnemonics}
+} // {asmtk}
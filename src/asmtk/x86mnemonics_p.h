@@ -0,0 +1,160 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_X86MNEMONICS_P_H
+#define _ASMTK_X86MNEMONICS_P_H
+
+#include <asmjit/x86.h>
+
+#include "./globals.h"
+#include "./perfecthash_p.h"
+#include "./threadutils_p.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::X86Alias]
+// ============================================================================
+
+enum X86Alias : uint32_t {
+  kX86AliasStart = 0x00010000u,
+
+  kX86AliasInsb = kX86AliasStart,
+  kX86AliasInsd,
+  kX86AliasInsw,
+
+  kX86AliasOutsb,
+  kX86AliasOutsd,
+  kX86AliasOutsw,
+
+  kX86AliasCmpsb,
+  kX86AliasCmpsd,
+  kX86AliasCmpsq,
+  kX86AliasCmpsw,
+
+  kX86AliasMovsb,
+  kX86AliasMovsd,
+  kX86AliasMovsq,
+  kX86AliasMovsw,
+
+  kX86AliasLodsb,
+  kX86AliasLodsd,
+  kX86AliasLodsq,
+  kX86AliasLodsw,
+
+  kX86AliasScasb,
+  kX86AliasScasd,
+  kX86AliasScasq,
+  kX86AliasScasw,
+
+  kX86AliasStosb,
+  kX86AliasStosd,
+  kX86AliasStosq,
+  kX86AliasStosw,
+
+  kX86AliasJrcxz,
+};
+
+// ============================================================================
+// [asmtk::X86Mnemonics]
+// ============================================================================
+
+//! Perfect hash table of all words that can start an x86 instruction - instruction mnemonics known to AsmJit,
+//! AsmTK aliases, and instruction options / prefixes, see `PerfectHash`. Lookups are performed directly on the
+//! input bytes.
+namespace X86Mnemonics {
+
+//! Maximum size of a word stored in the table.
+static constexpr uint32_t kMaxNameSize = 22;
+
+//! Maximum number of words in the table.
+static constexpr uint32_t kMaxEntries = uint32_t(asmjit::x86::Inst::_kIdCount) + 64u;
+
+//! Number of slots (power of 2, at least twice the number of entries to keep the construction fast).
+static constexpr uint32_t kSlotCount = asmjit::Support::align_up_power_of_2<uint32_t>(kMaxEntries * 2u);
+
+//! Number of buckets (seeds).
+static constexpr uint32_t kBucketCount = kSlotCount / 4u;
+
+//! A word in the table.
+struct Entry {
+  //! Lowercased word padded by zeros.
+  char name[kMaxNameSize];
+  //! Size of the word.
+  uint8_t size;
+  uint8_t reserved;
+  //! Instruction id or alias (`kX86AliasStart` and above), `x86::Inst::kIdNone` if the word is not an instruction.
+  uint32_t inst_id;
+  //! Instruction option, `InstOptions::kNone` if the word is not an option.
+  asmjit::InstOptions options;
+};
+
+struct Table {
+  //! Hash seed of each bucket.
+  uint16_t seeds[kBucketCount];
+  //! Index of an entry in each slot plus one, zero if the slot is empty.
+  uint16_t slots[kSlotCount];
+  //! Number of entries.
+  uint32_t count;
+  //! Entries.
+  Entry entries[kMaxEntries];
+};
+
+static_assert(kMaxEntries < 0xFFFFu, "Entry indexes must fit into uint16_t");
+
+extern Table table;
+//! Set when `table` has been built, see `init_table()`.
+extern std::atomic<uint32_t> table_state;
+
+//! Builds `table` if it's not built yet, called by `get_table()`.
+void init_table() noexcept;
+
+static inline const Table& get_table() noexcept {
+  if (ASMJIT_UNLIKELY(!ThreadUtils::is_done(table_state)))
+    init_table();
+  return table;
+}
+
+// All words consist of [a-z0-9] characters, which are unaffected by setting bit 5 except [A-Z], which become
+// lowercase. Other symbol characters that may appear in tokens never map to [a-z0-9], so the input can be folded
+// this way without a prior check.
+static inline uint32_t fold_char(uint8_t c) noexcept { return uint32_t(c) | 0x20u; }
+
+static inline uint64_t hash_word(const uint8_t* s, size_t size) noexcept {
+  uint64_t h = 0xCBF29CE484222325u;
+  for (size_t i = 0; i < size; i++)
+    h = (h ^ fold_char(s[i])) * 0x100000001B3u;
+  return h;
+}
+
+//! Finds a word `s` of `size` bytes (case insensitive), returns null if it's not in the table.
+static inline const Entry* lookup(const uint8_t* s, size_t size) noexcept {
+  if (size == 0 || size > kMaxNameSize)
+    return nullptr;
+
+  const Table& t = get_table();
+  uint64_t h = hash_word(s, size);
+  uint32_t bucket = PerfectHash::bucket_of(h, kBucketCount);
+  uint32_t index = t.slots[PerfectHash::slot_of(h, t.seeds[bucket], kSlotCount)];
+
+  if (index == 0)
+    return nullptr;
+
+  const Entry* entry = &t.entries[index - 1u];
+  if (entry->size != size)
+    return nullptr;
+
+  for (size_t i = 0; i < size; i++)
+    if (fold_char(s[i]) != uint8_t(entry->name[i]))
+      return nullptr;
+
+  return entry;
+}
+
+} // {X86Mnemonics}
+} // {asmtk}
+
+#endif // _ASMTK_X86MNEMONICS_P_H
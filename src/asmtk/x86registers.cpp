@@ -0,0 +1,159 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#define ASMTK_EXPORTS
+
+#include "./x86registers_p.h"
+
+namespace asmtk {
+namespace X86Registers {
+
+using namespace asmjit;
+
+// ============================================================================
+// [asmtk::X86Registers - Names]
+// ============================================================================
+
+struct FixedName {
+  char name[4];
+  RegType reg_type;
+  uint8_t reg_id;
+};
+
+// Registers that don't have a numeric index.
+static const FixedName fixed_names[] = {
+  { "al" , RegType::kGp8Lo  , x86::Gp::kIdAx   }, { "ah" , RegType::kGp8Hi  , x86::Gp::kIdAx   },
+  { "bl" , RegType::kGp8Lo  , x86::Gp::kIdBx   }, { "bh" , RegType::kGp8Hi  , x86::Gp::kIdBx   },
+  { "cl" , RegType::kGp8Lo  , x86::Gp::kIdCx   }, { "ch" , RegType::kGp8Hi  , x86::Gp::kIdCx   },
+  { "dl" , RegType::kGp8Lo  , x86::Gp::kIdDx   }, { "dh" , RegType::kGp8Hi  , x86::Gp::kIdDx   },
+  { "spl", RegType::kGp8Lo  , x86::Gp::kIdSp   }, { "bpl", RegType::kGp8Lo  , x86::Gp::kIdBp   },
+  { "sil", RegType::kGp8Lo  , x86::Gp::kIdSi   }, { "dil", RegType::kGp8Lo  , x86::Gp::kIdDi   },
+
+  { "ax" , RegType::kGp16   , x86::Gp::kIdAx   }, { "eax", RegType::kGp32   , x86::Gp::kIdAx   },
+  { "bx" , RegType::kGp16   , x86::Gp::kIdBx   }, { "ebx", RegType::kGp32   , x86::Gp::kIdBx   },
+  { "cx" , RegType::kGp16   , x86::Gp::kIdCx   }, { "ecx", RegType::kGp32   , x86::Gp::kIdCx   },
+  { "dx" , RegType::kGp16   , x86::Gp::kIdDx   }, { "edx", RegType::kGp32   , x86::Gp::kIdDx   },
+  { "sp" , RegType::kGp16   , x86::Gp::kIdSp   }, { "esp", RegType::kGp32   , x86::Gp::kIdSp   },
+  { "bp" , RegType::kGp16   , x86::Gp::kIdBp   }, { "ebp", RegType::kGp32   , x86::Gp::kIdBp   },
+  { "si" , RegType::kGp16   , x86::Gp::kIdSi   }, { "esi", RegType::kGp32   , x86::Gp::kIdSi   },
+  { "di" , RegType::kGp16   , x86::Gp::kIdDi   }, { "edi", RegType::kGp32   , x86::Gp::kIdDi   },
+
+  { "rax", RegType::kGp64   , x86::Gp::kIdAx   }, { "rbx", RegType::kGp64   , x86::Gp::kIdBx   },
+  { "rcx", RegType::kGp64   , x86::Gp::kIdCx   }, { "rdx", RegType::kGp64   , x86::Gp::kIdDx   },
+  { "rsp", RegType::kGp64   , x86::Gp::kIdSp   }, { "rbp", RegType::kGp64   , x86::Gp::kIdBp   },
+  { "rsi", RegType::kGp64   , x86::Gp::kIdSi   }, { "rdi", RegType::kGp64   , x86::Gp::kIdDi   },
+  { "rip", RegType::kPC     , 0                },
+
+  { "es" , RegType::kSegment, x86::SReg::kIdEs }, { "cs" , RegType::kSegment, x86::SReg::kIdCs },
+  { "ss" , RegType::kSegment, x86::SReg::kIdSs }, { "ds" , RegType::kSegment, x86::SReg::kIdDs },
+  { "fs" , RegType::kSegment, x86::SReg::kIdFs }, { "gs" , RegType::kSegment, x86::SReg::kIdGs }
+};
+
+struct IndexedName {
+  char prefix[4];
+  char suffix[2];
+  RegType reg_type;
+};
+
+// Registers that are followed by a numeric index (and an optional suffix).
+static const IndexedName indexed_names[] = {
+  { "r"  , ""  , RegType::kGp64    },
+  { "r"  , "b" , RegType::kGp8Lo   },
+  { "r"  , "w" , RegType::kGp16    },
+  { "r"  , "d" , RegType::kGp32    },
+  { "xmm", ""  , RegType::kVec128  },
+  { "ymm", ""  , RegType::kVec256  },
+  { "zmm", ""  , RegType::kVec512  },
+  { "k"  , ""  , RegType::kMask    },
+  { "st" , ""  , RegType::kX86_St  },
+  { "fp" , ""  , RegType::kX86_St  },
+  { "mm" , ""  , RegType::kX86_Mm  },
+  { "bnd", ""  , RegType::kX86_Bnd },
+  { "tmm", ""  , RegType::kTile    },
+  { "cr" , ""  , RegType::kControl },
+  { "dr" , ""  , RegType::kDebug   }
+};
+
+// ============================================================================
+// [asmtk::X86Registers - Construction]
+// ============================================================================
+
+Table table;
+std::atomic<uint32_t> table_state { ThreadUtils::kOnceNone };
+
+static constexpr uint32_t kMaxEntries = 512;
+
+struct TableBuilder {
+  Entry entries[kMaxEntries];
+  uint64_t hashes[kMaxEntries];
+  uint16_t slots[kSlotCount];
+  uint32_t count;
+
+  void add(const char* name, size_t size, RegType reg_type, uint32_t reg_id, bool two_digit_index) noexcept {
+    ASMJIT_ASSERT(count < kMaxEntries);
+    ASMJIT_ASSERT(size >= kMinNameSize && size <= kMaxNameSize);
+
+    uint64_t key = make_key(reinterpret_cast<const uint8_t*>(name), size);
+    entries[count] = Entry::make(key, reg_type, reg_id, two_digit_index);
+    hashes[count] = hash_key(key);
+    count++;
+  }
+};
+
+// A single digit index is always accepted, whereas an index of two digits only if it's less than the number of
+// registers of the given type, which depends on the target architecture. Names having two digits are only added
+// if they are valid for at least one architecture, the rest is checked at parse time by `x86_register_count()`.
+static void add_indexed_names(TableBuilder& builder, const IndexedName& indexed) noexcept {
+  size_t prefix_size = strlen(indexed.prefix);
+  size_t suffix_size = strlen(indexed.suffix);
+
+  char name[8];
+  memcpy(name, indexed.prefix, prefix_size);
+
+  for (uint32_t id = 0; id < 10; id++) {
+    name[prefix_size] = char('0' + id);
+    memcpy(name + prefix_size + 1, indexed.suffix, suffix_size);
+    builder.add(name, prefix_size + 1 + suffix_size, indexed.reg_type, id, false);
+  }
+
+  uint32_t max_count = x86_register_count(Arch::kX64, indexed.reg_type);
+  for (uint32_t id = 0; id < max_count; id++) {
+    name[prefix_size + 0] = char('0' + id / 10u);
+    name[prefix_size + 1] = char('0' + id % 10u);
+    memcpy(name + prefix_size + 2, indexed.suffix, suffix_size);
+    builder.add(name, prefix_size + 2 + suffix_size, indexed.reg_type, id, true);
+  }
+}
+
+static void build_table(Table& t) noexcept {
+  static TableBuilder builder;
+  builder.count = 0;
+
+  for (const FixedName& fixed : fixed_names)
+    builder.add(fixed.name, strlen(fixed.name), fixed.reg_type, fixed.reg_id, false);
+
+  for (const IndexedName& indexed : indexed_names)
+    add_indexed_names(builder, indexed);
+
+  // Cannot fail with a load factor below 0.5 - each bucket has 65536 seeds to choose from.
+  bool ok = PerfectHash::build(builder.hashes, builder.count, t.seeds, kBucketCount, builder.slots, kSlotCount);
+  ASMJIT_ASSERT(ok);
+  (void)ok;
+
+  for (uint32_t slot = 0; slot < kSlotCount; slot++) {
+    uint32_t index = builder.slots[slot];
+    t.entries[slot] = index ? builder.entries[index - 1u] : Entry{0};
+  }
+}
+
+// The table is built on first lookup and not by a static initializer, which would leave it empty when used by
+// static initializers of other translation units.
+void init_table() noexcept {
+  ThreadUtils::call_once(table_state, [] { build_table(table); });
+}
+
+} // {X86Registers}
+} // {asmtk}
@@ -0,0 +1,159 @@
+// [AsmTk]
+// Assembler toolkit based on AsmJit.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+#ifndef _ASMTK_X86REGISTERS_P_H
+#define _ASMTK_X86REGISTERS_P_H
+
+#include <asmjit/x86.h>
+
+#include "./globals.h"
+#include "./perfecthash_p.h"
+#include "./threadutils_p.h"
+
+namespace asmtk {
+
+// ============================================================================
+// [asmtk::X86Registers]
+// ============================================================================
+
+//! Returns the number of registers of `reg_type` addressable by two-digit register names (like `xmm15`) in `arch`.
+//! The parser calls it with a constant `arch` (see `parse_command_as()`), so the check of the architecture folds away.
+static constexpr uint32_t x86_register_count(asmjit::Arch arch, asmjit::RegType reg_type) noexcept {
+  using asmjit::RegType;
+
+  if (arch == asmjit::Arch::kX86)
+    return 8;
+
+  if (reg_type == RegType::kX86_St || reg_type == RegType::kX86_Mm || reg_type == RegType::kMask || reg_type == RegType::kTile)
+    return 8;
+
+  if (reg_type == RegType::kVec128 || reg_type == RegType::kVec256 || reg_type == RegType::kVec512)
+    return 32;
+
+  return 16;
+}
+
+//! Perfect hash table of all x86 register names (GP, segment, vector, mask, x87, MMX, bound, tile, control, and
+//! debug registers), see `PerfectHash`.
+//!
+//! Register names have at most 5 characters, so the key is the lowercased name packed into a 64-bit integer together
+//! with its size, and a lookup is a single probe and a single 64-bit comparison.
+namespace X86Registers {
+
+//! Minimum size of a register name.
+static constexpr uint32_t kMinNameSize = 2;
+//! Maximum size of a register name.
+static constexpr uint32_t kMaxNameSize = 5;
+
+//! Number of slots (power of 2).
+static constexpr uint32_t kSlotCount = 1024;
+//! Number of buckets (seeds).
+static constexpr uint32_t kBucketCount = 256;
+
+//! Mask of a key stored in `Entry::data`.
+static constexpr uint64_t kKeyMask = 0x0000FFFFFFFFFFFFu;
+
+//! Register name, which maps to a register type and id.
+//!
+//! All the information is packed into a single 64-bit integer: [7:0] to [39:32] are lowercased characters, [42:40]
+//! is the size of the name, [55:48] is a register type, [61:56] is a register id, and [63] is set if the register
+//! index was specified by two digits.
+struct Entry {
+  uint64_t data;
+
+  static inline Entry make(uint64_t key, asmjit::RegType reg_type, uint32_t reg_id, bool two_digit_index) noexcept {
+    return Entry{key | (uint64_t(reg_type) << 48) | (uint64_t(reg_id) << 56) | (uint64_t(two_digit_index) << 63)};
+  }
+
+  //! Returns the key, zero if the slot is empty.
+  inline uint64_t key() const noexcept { return data & kKeyMask; }
+  //! Returns the register type.
+  inline asmjit::RegType reg_type() const noexcept { return asmjit::RegType((data >> 48) & 0xFFu); }
+  //! Returns the register id.
+  inline uint32_t reg_id() const noexcept { return uint32_t(data >> 56) & 0x3Fu; }
+  //! Tests whether the register index was specified by two digits, which is only valid if it's less than
+  //! `x86_register_count()` of the target architecture.
+  inline bool has_two_digit_index() const noexcept { return (data >> 63) != 0; }
+};
+
+struct Table {
+  //! Hash seed of each bucket.
+  uint16_t seeds[kBucketCount];
+  //! Entries indexed by slot.
+  Entry entries[kSlotCount];
+};
+
+extern Table table;
+//! Set when `table` has been built, see `init_table()`.
+extern std::atomic<uint32_t> table_state;
+
+//! Builds `table` if it's not built yet, called by `get_table()`.
+void init_table() noexcept;
+
+static inline const Table& get_table() noexcept {
+  if (ASMJIT_UNLIKELY(!ThreadUtils::is_done(table_state)))
+    init_table();
+  return table;
+}
+
+static inline uint64_t read_u16_le(const uint8_t* s) noexcept {
+  return uint64_t(s[0]) | (uint64_t(s[1]) << 8);
+}
+
+static inline uint64_t read_u32_le(const uint8_t* s) noexcept {
+  return read_u16_le(s) | (read_u16_le(s + 2) << 16);
+}
+
+// Register names consist of [a-z0-9] characters, which are unaffected by setting bit 5 except [A-Z], which become
+// lowercase. Other symbol characters never map to [a-z0-9], thus they never produce a valid key.
+//
+// The name is loaded by two overlapping reads, which are always within `[s, s + size)` as `size` is at least 2.
+static inline uint64_t make_key(const uint8_t* s, size_t size) noexcept {
+  ASMJIT_ASSERT(size >= kMinNameSize && size <= kMaxNameSize);
+
+  uint64_t chars;
+  if (size >= 4) {
+    uint64_t lo = read_u32_le(s);
+    uint64_t hi = read_u32_le(s + size - 4);
+    chars = lo | (hi << ((size - 4) * 8u));
+  }
+  else {
+    uint64_t lo = read_u16_le(s);
+    uint64_t hi = read_u16_le(s + size - 2);
+    chars = lo | (hi << ((size - 2) * 8u));
+  }
+
+  uint64_t case_mask = 0x2020202020u >> ((kMaxNameSize - size) * 8u);
+  return (chars | case_mask) | (uint64_t(size) << 40);
+}
+
+static inline uint64_t hash_key(uint64_t key) noexcept {
+  key ^= key >> 33;
+  key *= 0xFF51AFD7ED558CCDu;
+  key ^= key >> 33;
+  key *= 0xC4CEB9FE1A85EC53u;
+  key ^= key >> 33;
+  return key;
+}
+
+//! Finds a register name `s` of `size` bytes (case insensitive), returns null if it's not a register name.
+static inline const Entry* lookup(const uint8_t* s, size_t size) noexcept {
+  if (size < kMinNameSize || size > kMaxNameSize)
+    return nullptr;
+
+  uint64_t key = make_key(s, size);
+  uint64_t h = hash_key(key);
+
+  const Table& t = get_table();
+  uint32_t bucket = PerfectHash::bucket_of(h, kBucketCount);
+  const Entry* entry = &t.entries[PerfectHash::slot_of(h, t.seeds[bucket], kSlotCount)];
+  return entry->key() == key ? entry : nullptr;
+}
+
+} // {X86Registers}
+} // {asmtk}
+
+#endif // _ASMTK_X86REGISTERS_P_H
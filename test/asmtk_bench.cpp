@@ -0,0 +1,1626 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asmjit/x86.h>
+#include "./asmtk.h"
+#include "./cmdline.h"
+
+// The register table is private, the bench is compiled with its sources (see CMakeLists.txt).
+#include "../src/asmtk/x86registers_p.h"
+
+using namespace asmjit;
+using namespace asmtk;
+
+// ============================================================================
+// [Bench - Utilities]
+// ============================================================================
+
+class PerformanceTimer {
+public:
+  typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+  inline void start() { _start = std::chrono::high_resolution_clock::now(); }
+  inline void stop() { _end = std::chrono::high_resolution_clock::now(); }
+
+  inline double duration() const {
+    std::chrono::duration<double> elapsed = _end - _start;
+    return elapsed.count() * 1000;
+  }
+
+  TimePoint _start {};
+  TimePoint _end {};
+};
+
+struct BenchOptions {
+  uint32_t iterations = 5;
+};
+
+static double mb_per_sec(size_t size, double ms) {
+  return ms > 0.0 ? (double(size) / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+}
+
+// ============================================================================
+// [Bench - Corpora]
+// ============================================================================
+
+// Inputs shared by the benchmarks below, resembling real inputs for both X86 and X64.
+
+//! Line of a corpus.
+struct CorpusLine {
+  const char* text;
+  //! Number of commands of the line - instructions and data directives (labels, comments, and empty lines have none).
+  uint32_t command_count;
+  //! Number of instructions of the line.
+  uint32_t instruction_count;
+};
+
+struct Corpus {
+  const char* name;
+  Arch arch;
+  std::string input;
+  size_t line_count;
+  size_t command_count;
+  size_t instruction_count;
+};
+
+static Corpus generate_corpus(const char* name, Arch arch, const CorpusLine* lines, size_t line_count, size_t target_size) {
+  Corpus corpus { name, arch, std::string(), 0, 0, 0 };
+  corpus.input.reserve(target_size + 256);
+
+  size_t i = 0;
+  while (corpus.input.size() < target_size) {
+    const CorpusLine& line = lines[i++ % line_count];
+    corpus.input.append(line.text);
+    corpus.input.push_back('\n');
+    corpus.line_count++;
+    corpus.command_count += line.command_count;
+    corpus.instruction_count += line.instruction_count;
+  }
+
+  return corpus;
+}
+
+static Corpus generate_gp_heavy_corpus(Arch arch, size_t target_size) {
+  static const CorpusLine x86_lines[] = {
+    { "mov eax, ebx", 1, 1 },
+    { "add eax, [esi + ecx*4 + 16]", 1, 1 },
+    { "lea edx, [eax + ebx*2 + 8]", 1, 1 },
+    { "imul ecx, edx, 12", 1, 1 },
+    { "xor eax, eax", 1, 1 },
+    { "shr edx, 5", 1, 1 },
+    { "cmp eax, 1000", 1, 1 },
+    { "push ebx", 1, 1 },
+    { "movzx eax, byte ptr [esi]", 1, 1 },
+    { "pop ebx", 1, 1 },
+    { "test ecx, ecx", 1, 1 },
+    { "lock xadd [edi], eax", 1, 1 }
+  };
+
+  static const CorpusLine x64_lines[] = {
+    { "mov rax, rbx", 1, 1 },
+    { "add rax, [rsi + rcx*8 + 16]", 1, 1 },
+    { "lea r8, [rax + r9*2 + 8]", 1, 1 },
+    { "imul r10d, edx, 12", 1, 1 },
+    { "xor eax, eax", 1, 1 },
+    { "shr r11, 5", 1, 1 },
+    { "cmp r12, 1000", 1, 1 },
+    { "push r13", 1, 1 },
+    { "movzx eax, byte ptr [rsi]", 1, 1 },
+    { "pop r13", 1, 1 },
+    { "test r14, r15", 1, 1 },
+    { "lock xadd [rdi], rax", 1, 1 }
+  };
+
+  return arch == Arch::kX86
+    ? generate_corpus("gp-heavy", arch, x86_lines, ASMJIT_ARRAY_SIZE(x86_lines), target_size)
+    : generate_corpus("gp-heavy", arch, x64_lines, ASMJIT_ARRAY_SIZE(x64_lines), target_size);
+}
+
+static Corpus generate_avx512_heavy_corpus(Arch arch, size_t target_size) {
+  static const CorpusLine x86_lines[] = {
+    { "vaddps zmm0 {k1}{z}, zmm1, zmm2", 1, 1 },
+    { "vmulpd zmm3 {k2}, zmm4, [eax] {1to8}", 1, 1 },
+    { "vfmadd231ps zmm0 {k3}{z}, zmm1, dword ptr [eax + ecx*4 + 64] {1to16}", 1, 1 },
+    { "vpaddd zmm5 {k1}, zmm6, zmm7", 1, 1 },
+    { "vcmpps k2 {k7}, zmm2, dword ptr [eax + ebx*4 + 256] {1to16}, 15", 1, 1 },
+    { "vmovups zmm0 {k1}{z}, [esi + 64]", 1, 1 },
+    { "vpternlogd zmm1, zmm2, zmm3, 202", 1, 1 },
+    { "vpermt2ps zmm0 {k1}, zmm1, zmm2", 1, 1 }
+  };
+
+  static const CorpusLine x64_lines[] = {
+    { "vaddps zmm16 {k1}{z}, zmm17, zmm18", 1, 1 },
+    { "vmulpd zmm19 {k2}, zmm20, [rax] {1to8}", 1, 1 },
+    { "vfmadd231ps zmm0 {k3}{z}, zmm21, dword ptr [rax + r8*4 + 64] {1to16}", 1, 1 },
+    { "vpaddd zmm29 {k1}, zmm30, zmm31", 1, 1 },
+    { "vcmpps k2 {k7}, zmm22, dword ptr [rax + rbx*4 + 256] {1to16}, 15", 1, 1 },
+    { "vmovups zmm8 {k1}{z}, [rsi + 64]", 1, 1 },
+    { "vpternlogd zmm9, zmm10, zmm11, 202", 1, 1 },
+    { "vpermt2ps zmm24 {k1}, zmm25, zmm26", 1, 1 }
+  };
+
+  return arch == Arch::kX86
+    ? generate_corpus("avx512-heavy", arch, x86_lines, ASMJIT_ARRAY_SIZE(x86_lines), target_size)
+    : generate_corpus("avx512-heavy", arch, x64_lines, ASMJIT_ARRAY_SIZE(x64_lines), target_size);
+}
+
+// Mimics generated listings - deep indentation, operands aligned by spaces, and most lines annotated by comments.
+static Corpus generate_comment_heavy_corpus(Arch arch, size_t target_size) {
+  static const CorpusLine x86_lines[] = {
+    { "    mov     eax, ebx                                  ; copy the loop counter into the accumulator", 1, 1 },
+    { "    ; -------------------------------------------------------------------------------------------", 0, 0 },
+    { "    add     esi, 16                                   // advance by one vector (16 bytes)", 1, 1 },
+    { "", 0, 0 },
+    { "        ;; spill slot #3 is reused by the epilogue, see the register allocator notes above", 0, 0 },
+    { "    vpaddd  xmm0, xmm1, xmm2                          ; lanes [0..3]", 1, 1 },
+    { "                                                      ; continuation of the previous annotation", 0, 0 }
+  };
+
+  static const CorpusLine x64_lines[] = {
+    { "    mov     rax, rbx                                  ; copy the loop counter into the accumulator", 1, 1 },
+    { "    ; -------------------------------------------------------------------------------------------", 0, 0 },
+    { "    add     rsi, 16                                   // advance by one vector (16 bytes)", 1, 1 },
+    { "", 0, 0 },
+    { "        ;; spill slot #3 is reused by the epilogue, see the register allocator notes above", 0, 0 },
+    { "    vpaddd  xmm8, xmm9, xmm10                         ; lanes [0..3]", 1, 1 },
+    { "                                                      ; continuation of the previous annotation", 0, 0 }
+  };
+
+  return arch == Arch::kX86
+    ? generate_corpus("comment-heavy", arch, x86_lines, ASMJIT_ARRAY_SIZE(x86_lines), target_size)
+    : generate_corpus("comment-heavy", arch, x64_lines, ASMJIT_ARRAY_SIZE(x64_lines), target_size);
+}
+
+static Corpus generate_data_heavy_corpus(Arch arch, size_t target_size) {
+  static const CorpusLine lines[] = {
+    { ".db 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16", 1, 0 },
+    { ".dw 1000, 2000, 3000, 4000, 5000, 6000, 7000, 8000", 1, 0 },
+    { ".dd 305419896, 2271560481, 4294967295, 0", 1, 0 },
+    { ".dq 1311768467463790320, 18446744073709551615", 1, 0 },
+    { ".float 1.5, 2.25, -0.125, 3.0e10", 1, 0 },
+    { ".double 3.141592653589793, 2.718281828459045", 1, 0 },
+    { ".align 16", 1, 0 }
+  };
+
+  return generate_corpus("data-heavy", arch, lines, ASMJIT_ARRAY_SIZE(lines), target_size);
+}
+
+// Many small functions with local labels, where most of the work is resolving jump targets - global, ".local", and
+// "parent.local" forms, both backward and forward references. Each function is 9 lines (about 80 bytes), 5 of them
+// instructions.
+static Corpus generate_label_dense_corpus(Arch arch, uint32_t function_count) {
+  Corpus corpus { "label-dense", arch, std::string(), 0, 0, 0 };
+  corpus.input.reserve(size_t(function_count) * 96u);
+
+  char buf[256];
+
+  for (uint32_t i = 0; i < function_count; i++) {
+    uint32_t callee = uint32_t((uint64_t(i) * 7919u + 13u) % function_count);
+    snprintf(buf, sizeof(buf),
+      "fn_%u:\n"
+      ".loop:\n"
+      "dec ecx\n"
+      "jnz .loop\n"
+      "jz fn_%u.exit\n"
+      "call fn_%u\n"
+      "jmp .exit\n"
+      ".exit:\n"
+      "ret\n", i, i, callee);
+    corpus.input.append(buf);
+    corpus.line_count += 9;
+    corpus.command_count += 5;
+    corpus.instruction_count += 5;
+  }
+
+  return corpus;
+}
+
+// ============================================================================
+// [Bench - Tokenizer]
+// ============================================================================
+
+static void bench_tokenizer(const BenchOptions& options, const char* name, const std::string& input) {
+  AsmTokenizer tokenizer;
+  AsmToken token;
+
+  double best = 0.0;
+  size_t token_count = 0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+    size_t count = 0;
+
+    timer.start();
+    tokenizer.set_input(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    while (tokenizer.next(&token) != AsmTokenType::kEnd)
+      count++;
+    timer.stop();
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+    token_count = count;
+  }
+
+  printf("  [Tokenizer] %-24s: %8.1f MB/s (%zu bytes, %zu tokens, %.3f ms)\n",
+    name, mb_per_sec(input.size(), best), input.size(), token_count, best);
+}
+
+static void bench_tokenize_all(const BenchOptions& options, const char* name, const std::string& input) {
+  AsmTokenizer tokenizer;
+  AsmTokenStream stream;
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+
+    timer.start();
+    tokenizer.set_input(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    stream.clear();
+    Error err = tokenizer.tokenize_all(stream);
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [TokenizeAll] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return;
+    }
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [TokenizeAll] %-22s: %8.1f MB/s (%zu bytes, %zu tokens, %.3f ms)\n",
+    name, mb_per_sec(input.size(), best), input.size(), stream.size(), best);
+}
+
+// ============================================================================
+// [Bench - Parser]
+// ============================================================================
+
+// Short instructions with prefixes and aliases, where mnemonic resolution makes a large part of the work.
+static std::string generate_instruction_heavy_input(size_t target_size) {
+  static const char* const lines[] = {
+    "mov eax, ebx\n",
+    "ADD RAX, RCX\n",
+    "lock xadd [rdi], eax\n",
+    "rep movsb\n",
+    "vaddps ymm0, ymm1, ymm2\n",
+    "pshufb xmm3, xmm4\n",
+    "sal edx, 3\n",
+    "xacquire lock or [rsi], ecx\n",
+    "cmpsd xmm0, xmm1, 1\n",
+    "vfmadd231ps zmm0, zmm1, zmm2\n"
+  };
+
+  std::string s;
+  s.reserve(target_size + 256);
+
+  size_t i = 0;
+  while (s.size() < target_size)
+    s.append(lines[i++ % ASMJIT_ARRAY_SIZE(lines)]);
+  return s;
+}
+
+static void bench_parser(const BenchOptions& options, const char* name, const std::string& input) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment);
+    x86::Assembler a(&code);
+    AsmParser parser(&a);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = parser.parse(input.data(), input.size());
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [AsmParser] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return;
+    }
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmParser] %-24s: %8.1f MB/s (%zu bytes, %.3f ms)\n",
+    name, mb_per_sec(input.size(), best), input.size(), best);
+}
+
+// Compares `parse()` with replaying a record of the same input made by `AsmParser::record()`, returns the time of
+// the replay (zero on failure).
+static double bench_replay(const BenchOptions& options, const char* name, const std::string& input) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  AsmRecord record;
+  {
+    CodeHolder code;
+    code.init(environment);
+    x86::Assembler a(&code);
+
+    Error err = AsmParser(&a).record(record, input.data(), input.size());
+    if (err != Error::kOk) {
+      printf("  [AsmRecord] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return 0.0;
+    }
+  }
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment);
+    x86::Assembler a(&code);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = record.replay(&a);
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [AsmRecord] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return 0.0;
+    }
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmRecord] %-24s: %8.1f MB/s (%zu bytes, %.3f ms, %zu commands, %zu bytes recorded)\n",
+    name, mb_per_sec(input.size(), best), input.size(), best, record.command_count(), record.size());
+  return best;
+}
+
+// Compares `parse()` with `parse_parallel()` using an increasing number of threads.
+//
+// Records are replayed (labels bound and instructions encoded) serially by the calling thread, so the speedup is
+// bounded by the time of `parse()` divided by the time of the replay, which is reported as well.
+static void bench_parser_parallel(const BenchOptions& options, const char* name, const std::string& input) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  uint32_t max_threads = std::max<uint32_t>(std::thread::hardware_concurrency(), 1u);
+  double serial = 0.0;
+
+  for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+    double best = 0.0;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+      CodeHolder code;
+      code.init(environment);
+      x86::Assembler a(&code);
+      AsmParser parser(&a);
+
+      PerformanceTimer timer;
+      timer.start();
+      Error err = parser.parse_parallel(input.data(), input.size(), thread_count);
+      timer.stop();
+
+      if (err != Error::kOk) {
+        printf("  [AsmParser] %s: %s\n", name, DebugUtils::error_as_string(err));
+        return;
+      }
+
+      if (i == 0 || timer.duration() < best)
+        best = timer.duration();
+    }
+
+    printf("  [AsmParser] %-24s: %8.1f MB/s (%zu bytes, %.3f ms, %u threads)\n",
+      name, mb_per_sec(input.size(), best), input.size(), best, thread_count);
+
+    // A single thread parses the input by `parse()`.
+    if (thread_count == 1)
+      serial = best;
+  }
+
+  double replay = bench_replay(options, name, input);
+  if (replay > 0.0)
+    printf("  [AsmParser] %-24s: %8.1fx speedup at most (serial replay)\n", name, serial / replay);
+}
+
+// Compares `parse()` with `parse_pipelined()`, which tokenizes on another thread.
+static void bench_parser_pipelined(const BenchOptions& options, const char* name, const std::string& input) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment);
+    x86::Assembler a(&code);
+    AsmParser parser(&a);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = parser.parse_pipelined(input.data(), input.size());
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [AsmParser] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return;
+    }
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmParser] %-24s: %8.1f MB/s (%zu bytes, %.3f ms)\n",
+    name, mb_per_sec(input.size(), best), input.size(), best);
+}
+
+// Compares parsing with a cold cache (parse and store) and a warm cache (load only).
+static void bench_cache(const BenchOptions& options, const char* name, const std::string& input) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  std::error_code ec;
+  std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "asmtk_bench_cache";
+  std::filesystem::remove_all(directory, ec);
+  std::filesystem::create_directories(directory, ec);
+
+  AsmCache cache;
+  if (cache.init(directory.string().c_str()) != Error::kOk)
+    return;
+
+  double cold = 0.0;
+  double warm = 0.0;
+
+  for (uint32_t i = 0; i <= options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment, 0x10000);
+    x86::Assembler a(&code);
+
+    AsmParser parser(&a);
+    parser.set_cache(&cache);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = parser.parse(input.data(), input.size());
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [AsmCache ] %s: %s\n", name, DebugUtils::error_as_string(err));
+      break;
+    }
+
+    if (i == 0)
+      cold = timer.duration();
+    else if (i == 1 || timer.duration() < warm)
+      warm = timer.duration();
+  }
+
+  if (cache.stats().store_count) {
+    printf("  [AsmCache ] %-24s: %8.1f MB/s cold, %8.1f MB/s warm (%zu bytes)\n",
+      name, mb_per_sec(input.size(), cold), mb_per_sec(input.size(), warm), input.size());
+  }
+  else {
+    printf("  [AsmCache ] %-24s: not cacheable\n", name);
+  }
+
+  std::filesystem::remove_all(directory, ec);
+}
+
+// Each function of the label-dense input defines 3 labels (a global and 2 locals), so the time per byte should stay
+// flat as the number of labels grows.
+static void bench_label_scaling(const BenchOptions& options) {
+  static const uint32_t label_counts[] = { 1000, 10000, 100000, 1000000 };
+
+  for (uint32_t label_count : label_counts) {
+    char name[64];
+    snprintf(name, sizeof(name), "labels=%u", label_count);
+
+    std::string input = generate_label_dense_corpus(Arch::kX64, label_count / 3u).input;
+    bench_parser(options, name, input);
+  }
+}
+
+// ============================================================================
+// [Bench - Register Recognizer]
+// ============================================================================
+
+// The branchy recognizer that was used by AsmParser before register names were moved to a perfect hash table, kept
+// here as a baseline.
+#define COMB_CHAR_2(a, b) \
+  ((uint32_t(a) << 8) | uint32_t(b))
+
+#define COMB_CHAR_4(a, b, c, d) \
+  ((uint32_t(a) << 24) | (uint32_t(b) << 16) | (uint32_t(c) << 8) | uint32_t(d))
+
+static uint32_t legacy_register_count(Arch arch, RegType reg_type) noexcept {
+  if (arch == Arch::kX86)
+    return 8;
+
+  if (reg_type == RegType::kX86_St || reg_type == RegType::kX86_Mm || reg_type == RegType::kMask || reg_type == RegType::kTile)
+    return 8;
+
+  if (reg_type == RegType::kVec128 || reg_type == RegType::kVec256 || reg_type == RegType::kVec512)
+    return 32;
+
+  return 16;
+}
+
+static bool legacy_parse_register(Arch arch, Operand_& op, const uint8_t* s, size_t size) noexcept {
+  constexpr uint32_t kMinSize = 2;
+  constexpr uint32_t kMaxSize = 5;
+
+  if (size < kMinSize || size > kMaxSize)
+    return false;
+
+  const uint8_t* sEnd = s + size;
+
+  uint32_t c0 = Support::ascii_to_lower<uint32_t>(s[0]);
+  uint32_t c1 = Support::ascii_to_lower<uint32_t>(s[1]);
+  uint32_t c2 = size > 2 ? Support::ascii_to_lower<uint32_t>(s[2]) : uint32_t(0);
+  uint32_t cn = (c0 << 8) + c1;
+
+  RegType rType = RegType::kNone;
+  uint32_t rId = 0;
+
+  static const uint8_t gp_letter_to_reg_index[] = {
+    uint8_t(x86::Gp::kIdAx), // a
+    uint8_t(x86::Gp::kIdBx), // b
+    uint8_t(x86::Gp::kIdCx), // c
+    uint8_t(x86::Gp::kIdDx)  // d
+  };
+
+  static const uint8_t sr_letter_to_reg_index[] = {
+    uint8_t(Reg::kIdBad), // a
+    uint8_t(Reg::kIdBad), // b
+    uint8_t(x86::SReg::kIdCs), // c
+    uint8_t(x86::SReg::kIdDs), // d
+    uint8_t(x86::SReg::kIdEs), // e
+    uint8_t(x86::SReg::kIdFs), // f
+    uint8_t(x86::SReg::kIdGs), // g
+    uint8_t(Reg::kIdBad), // h
+    uint8_t(Reg::kIdBad), // i
+    uint8_t(Reg::kIdBad), // j
+    uint8_t(Reg::kIdBad), // k
+    uint8_t(Reg::kIdBad), // l
+    uint8_t(Reg::kIdBad), // m
+    uint8_t(Reg::kIdBad), // n
+    uint8_t(Reg::kIdBad), // o
+    uint8_t(Reg::kIdBad), // p
+    uint8_t(Reg::kIdBad), // q
+    uint8_t(Reg::kIdBad), // r
+    uint8_t(x86::SReg::kIdSs)  // s
+  };
+
+  // [AL|BL|CL|DL]
+  // [AH|BH|CH|DH]
+  // [AX|BX|CX|DX]
+  // [ES|CS|SS|DS|FS|GS]
+  if (size == 2 && Support::is_between<uint32_t>(c0, 'a', 's')) {
+    if (c0 <= 'd') {
+      rId = gp_letter_to_reg_index[c0 - 'a'];
+
+      rType = RegType::kGp8Lo;
+      if (c1 == 'l') goto Done;
+
+      rType = RegType::kGp8Hi;
+      if (c1 == 'h') goto Done;
+
+      rType = RegType::kGp16;
+      if (c1 == 'x') goto Done;
+    }
+
+    if (c1 == 's') {
+      rId = sr_letter_to_reg_index[c0 - 'a'];
+      rType = RegType::kSegment;
+
+      if (rId != Reg::kIdBad)
+        goto Done;
+    }
+
+    rType = RegType::kGp16;
+    goto TrySpBpSiDi;
+  }
+
+  // [SP|BP|SI|DI]
+  // [SPL|BPL|SIL|DIL]
+  // [EAX|EBX|ECX|EDX|ESP|EBP|EDI|ESI]
+  // [RAX|RBX|RCX|RDX|RSP|RBP|RDI|RSI]
+  // [RIP]
+  if (size == 3) {
+    if (c2 == 'l') {
+      rType = RegType::kGp8Lo;
+      goto TrySpBpSiDi;
+    }
+
+    if (c0 == 'e' || c0 == 'r') {
+      cn = (c1 << 8) | c2;
+      rType = (c0 == 'e') ? RegType::kGp32 : RegType::kGp64;
+
+      if (c0 == 'r' && cn == COMB_CHAR_2('i', 'p')) {
+        rType = RegType::kPC;
+        goto Done;
+      }
+
+      if (cn == COMB_CHAR_2('a', 'x')) { rId = x86::Gp::kIdAx; goto Done; }
+      if (cn == COMB_CHAR_2('d', 'x')) { rId = x86::Gp::kIdDx; goto Done; }
+      if (cn == COMB_CHAR_2('b', 'x')) { rId = x86::Gp::kIdBx; goto Done; }
+      if (cn == COMB_CHAR_2('c', 'x')) { rId = x86::Gp::kIdCx; goto Done; }
+
+TrySpBpSiDi:
+      if (cn == COMB_CHAR_2('s', 'p')) { rId = x86::Gp::kIdSp; goto Done; }
+      if (cn == COMB_CHAR_2('b', 'p')) { rId = x86::Gp::kIdBp; goto Done; }
+      if (cn == COMB_CHAR_2('s', 'i')) { rId = x86::Gp::kIdSi; goto Done; }
+      if (cn == COMB_CHAR_2('d', 'i')) { rId = x86::Gp::kIdDi; goto Done; }
+    }
+  }
+
+  // [R?|R?B|R?W|R?D]
+  if (c0 == 'r') {
+    s++;
+    rType = RegType::kGp64;
+
+    // Handle 'b', 'w', and 'd' suffixes.
+    c2 = Support::ascii_to_lower<uint32_t>(sEnd[-1]);
+    if (c2 == 'b')
+      rType = RegType::kGp8Lo;
+    else if (c2 == 'w')
+      rType = RegType::kGp16;
+    else if (c2 == 'd')
+      rType = RegType::kGp32;
+    sEnd -= (rType != RegType::kGp64);
+  }
+  // [XMM?|YMM?|ZMM?]
+  else if (c0 >= 'x' && c0 <= 'z' && c1 == 'm' && c2 == 'm') {
+    s += 3;
+    rType = RegType(uint32_t(RegType::kVec128) + uint32_t(c0 - 'x'));
+  }
+  // [K?]
+  else if (c0 == 'k') {
+    s++;
+    rType = RegType::kMask;
+  }
+  // [ST?|FP?]
+  else if ((c0 == 's' && c1 == 't') | (c0 == 'f' && c1 == 'p')) {
+    s += 2;
+    rType = RegType::kX86_St;
+  }
+  // [MM?]
+  else if (c0 == 'm' && c1 == 'm') {
+    s += 2;
+    rType = RegType::kX86_Mm;
+  }
+  // [BND?]
+  else if (c0 == 'b' && c1 == 'n' && c2 == 'd') {
+    s += 3;
+    rType = RegType::kX86_Bnd;
+  }
+  // [TMM?]
+  else if (c0 == 't' && c1 == 'm' && c2 == 'm') {
+    s += 3;
+    rType = RegType::kTile;
+  }
+  // [CR?]
+  else if (c0 == 'c' && c1 == 'r') {
+    s += 2;
+    rType = RegType::kControl;
+  }
+  // [DR?]
+  else if (c0 == 'd' && c1 == 'r') {
+    s += 2;
+    rType = RegType::kDebug;
+  }
+  else {
+    return false;
+  }
+
+  // Parse the register index.
+  rId = uint32_t(s[0]) - '0';
+  if (rId >= 10)
+    return false;
+
+  if (++s < sEnd) {
+    c0 = uint32_t(*s++) - '0';
+    if (c0 >= 10)
+      return false;
+    rId = rId * 10 + c0;
+
+    // Maximum register
+    if (rId >= legacy_register_count(arch, rType))
+      return false;
+  }
+
+  // Fail if the whole input wasn't parsed.
+  if (s != sEnd)
+    return false;
+
+  // Fail if the register index is greater than allowed.
+  if (rId >= 32)
+    return false;
+
+Done:
+  op._init_reg(RegUtils::signature_of(rType), rId);
+  return true;
+}
+
+#undef COMB_CHAR_4
+#undef COMB_CHAR_2
+
+static bool table_parse_register(Arch arch, Operand_& op, const uint8_t* s, size_t size) noexcept {
+  const X86Registers::Entry* entry = X86Registers::lookup(s, size);
+  if (!entry)
+    return false;
+
+  RegType reg_type = entry->reg_type();
+  uint32_t reg_id = entry->reg_id();
+
+  if (entry->has_two_digit_index() && reg_id >= x86_register_count(arch, reg_type))
+    return false;
+
+  op._init_reg(RegUtils::signature_of(reg_type), reg_id);
+  return true;
+}
+
+struct SymbolRef {
+  uint32_t offset;
+  uint32_t size;
+};
+
+// Symbols as seen by the operand parser in vectorized code - mostly registers of all kinds, and also size keywords
+// and labels, which must be rejected.
+static std::string generate_register_dense_symbols(size_t count, std::vector<SymbolRef>& refs) {
+  static const char* const symbols[] = {
+    "rax", "rbx", "rcx", "rdx", "rsi", "rdi", "rsp", "rbp", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+    "eax", "ecx", "r8d", "r15d", "ax", "r11w", "al", "cl", "ah", "sil", "r9b", "rip", "fs", "gs",
+    "xmm0", "xmm7", "xmm15", "xmm31", "ymm1", "ymm12", "zmm0", "zmm16", "zmm31", "k1", "k7",
+    "mm0", "st0", "st7", "bnd1", "tmm3", "cr0", "dr7",
+    "XMM3", "RAX", "Zmm9",
+    "qword", "ptr", "byte", "loop_start", "L1", "data", "rel"
+  };
+
+  std::string s;
+  refs.clear();
+  refs.reserve(count);
+
+  uint32_t state = 1;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1103515245u + 12345u;
+    const char* symbol = symbols[(state >> 16) % ASMJIT_ARRAY_SIZE(symbols)];
+    size_t size = strlen(symbol);
+
+    refs.push_back(SymbolRef{uint32_t(s.size()), uint32_t(size)});
+    s.append(symbol, size);
+    s.append(1, ' ');
+  }
+
+  return s;
+}
+
+template<typename Fn>
+static double bench_register_recognizer_fn(const BenchOptions& options, const std::string& data, const std::vector<SymbolRef>& refs, Fn&& fn, uint64_t& checksum) {
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(data.data());
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+    uint64_t sum = 0;
+
+    timer.start();
+    for (const SymbolRef& ref : refs) {
+      Operand_ op;
+      if (fn(Arch::kX64, op, base + ref.offset, ref.size))
+        sum += op.signature().bits() * 31u + op.id();
+      else
+        sum++;
+    }
+    timer.stop();
+
+    checksum = sum;
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  return best;
+}
+
+static void bench_register_recognizer(const BenchOptions& options) {
+  constexpr size_t kCount = 4000000;
+
+  std::vector<SymbolRef> refs;
+  std::string data = generate_register_dense_symbols(kCount, refs);
+
+  uint64_t legacy_checksum = 0;
+  uint64_t table_checksum = 0;
+
+  double legacy = bench_register_recognizer_fn(options, data, refs, legacy_parse_register, legacy_checksum);
+  double table = bench_register_recognizer_fn(options, data, refs, table_parse_register, table_checksum);
+
+  printf("  [Registers] %-24s: %8.1f ns/symbol (%zu symbols, %.3f ms)\n",
+    "branchy (legacy)", legacy * 1000000.0 / double(kCount), kCount, legacy);
+  printf("  [Registers] %-24s: %8.1f ns/symbol (%zu symbols, %.3f ms)%s\n",
+    "perfect hash", table * 1000000.0 / double(kCount), kCount, table,
+    legacy_checksum != table_checksum ? " [MISMATCH]" : "");
+}
+
+// ============================================================================
+// [Bench - Registers]
+// ============================================================================
+
+// Instructions whose operands are mostly registers of all kinds (GP of all sizes, vector, mask, FPU, and MMX), written
+// in mixed case, so most of the parsing time is spent by recognizing register names.
+static std::string generate_register_dense_input(size_t target_size) {
+  static const char* const gp64[] = {
+    "rax", "rbx", "rcx", "rdx", "rsi", "rdi", "RBP", "r8", "r9", "r10", "R11", "r12", "r13", "r14", "r15"
+  };
+  static const char* const gp32[] = { "eax", "ecx", "EDX", "esi", "r8d", "r9d", "r11d", "r15d" };
+  static const char* const gp8[] = { "al", "cl", "dl", "bl", "sil", "dil", "r9b", "R15B" };
+  static const char* const zmm[] = { "zmm0", "zmm1", "zmm9", "zmm16", "ZMM17", "zmm24", "zmm31" };
+  static const char* const xmm[] = { "xmm0", "xmm3", "xmm7", "XMM8", "xmm15" };
+  static const char* const mask[] = { "k1", "k2", "k3", "k7" };
+
+  std::string s;
+  s.reserve(target_size + 256);
+
+  uint32_t state = 1;
+  auto pick = [&](const char* const* regs, size_t count) {
+    state = state * 1103515245u + 12345u;
+    return regs[(state >> 16) % count];
+  };
+
+  char buf[128];
+  for (uint32_t i = 0; s.size() < target_size; i++) {
+    switch (i % 8u) {
+      case 0: snprintf(buf, sizeof(buf), "mov %s, %s\n", pick(gp64, 15), pick(gp64, 15)); break;
+      case 1: snprintf(buf, sizeof(buf), "add %s, %s\n", pick(gp32, 8), pick(gp32, 8)); break;
+      case 2: snprintf(buf, sizeof(buf), "xor %s, %s\n", pick(gp8, 8), pick(gp8, 8)); break;
+      case 3: snprintf(buf, sizeof(buf), "vpaddd %s {%s}, %s, %s\n", pick(zmm, 7), pick(mask, 4), pick(zmm, 7), pick(zmm, 7)); break;
+      case 4: snprintf(buf, sizeof(buf), "vxorps %s, %s, %s\n", pick(xmm, 5), pick(xmm, 5), pick(xmm, 5)); break;
+      case 5: snprintf(buf, sizeof(buf), "kandw %s, %s, %s\n", pick(mask, 4), pick(mask, 4), pick(mask, 4)); break;
+      case 6: snprintf(buf, sizeof(buf), "lea %s, [%s + %s * 4 + 16]\n", pick(gp64, 15), pick(gp64, 15), pick(gp64 + 1, 14)); break;
+      default: snprintf(buf, sizeof(buf), "paddb mm1, mm2\nfadd st0, st3\n"); break;
+    }
+    s.append(buf);
+  }
+
+  return s;
+}
+
+// ============================================================================
+// [Bench - Floating Point]
+// ============================================================================
+
+// A table of double precision constants as emitted for SIMD kernels (polynomial coefficients, lookup tables).
+static std::string generate_double_table(size_t count) {
+  std::string s;
+  s.reserve(count * 28);
+
+  uint64_t state = 0x9E3779B97F4A7C15u;
+  char buf[64];
+
+  for (size_t i = 0; i < count; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    double value = double(int64_t(state >> 11)) * 0x1p-40 - 1048576.0;
+    snprintf(buf, sizeof(buf), ".double %.17g\n", value);
+    s.append(buf);
+  }
+
+  return s;
+}
+
+static void bench_strtod(const BenchOptions& options, const std::string& input, size_t count) {
+  std::vector<const char*> literals;
+  literals.reserve(count);
+
+  const char* p = input.c_str();
+  while ((p = strchr(p, ' ')) != nullptr)
+    literals.push_back(++p);
+
+  double best_asmtk = 0.0;
+  double best_libc = 0.0;
+  uint64_t checksum = 0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+
+    timer.start();
+    for (const char* literal : literals) {
+      uint64_t bits;
+      StrToD::parse(reinterpret_cast<const uint8_t*>(literal), strcspn(literal, "\n"), FloatFormat::kF64, &bits);
+      checksum += bits;
+    }
+    timer.stop();
+
+    if (i == 0 || timer.duration() < best_asmtk)
+      best_asmtk = timer.duration();
+
+    timer.start();
+    for (const char* literal : literals) {
+      double value = strtod(literal, nullptr);
+      uint64_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      checksum -= bits;
+    }
+    timer.stop();
+
+    if (i == 0 || timer.duration() < best_libc)
+      best_libc = timer.duration();
+  }
+
+  printf("  [StrToD] %-27s: %8.1f ns/literal (%zu literals, %.3f ms)%s\n",
+    "StrToD::parse", best_asmtk * 1000000.0 / double(literals.size()), literals.size(), best_asmtk,
+    checksum ? " [MISMATCH]" : "");
+  printf("  [StrToD] %-27s: %8.1f ns/literal (%zu literals, %.3f ms)\n",
+    "strtod (libc)", best_libc * 1000000.0 / double(literals.size()), literals.size(), best_libc);
+}
+
+static void bench_double_table(const BenchOptions& options, const std::string& input, size_t count) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment);
+    x86::Assembler a(&code);
+    AsmParser parser(&a);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = parser.parse(input.data(), input.size());
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [AsmParser] .double table: %s\n", DebugUtils::error_as_string(err));
+      return;
+    }
+
+    if (code.text_section()->buffer().size() != count * 8u) {
+      printf("  [AsmParser] .double table: unexpected size of the section\n");
+      return;
+    }
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmParser] %-24s: %8.1f MB/s (%zu literals, %.1f ns/literal, %.3f ms)\n",
+    ".double table", mb_per_sec(input.size(), best), count, best * 1000000.0 / double(count), best);
+}
+
+// ============================================================================
+// [Bench - Data Directives]
+// ============================================================================
+
+// A table of integers as emitted by data generators (lookup tables, embedded resources) - `values_per_line` values of
+// `directive` per line, written as decimal or hexadecimal numbers.
+static std::string generate_integer_table(const char* directive, uint32_t n_bytes, bool hex, size_t values_per_line, size_t target_size) {
+  std::string s;
+  s.reserve(target_size + 64);
+
+  uint64_t state = 0x9E3779B97F4A7C15u;
+  uint64_t mask = n_bytes == 8 ? ~uint64_t(0) : (uint64_t(1) << (n_bytes * 8)) - 1u;
+  char buf[64];
+
+  while (s.size() < target_size) {
+    s.append(directive);
+
+    for (size_t i = 0; i < values_per_line; i++) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      snprintf(buf, sizeof(buf), hex ? "%s0x%llX" : "%s%llu", i ? ", " : " ", (unsigned long long)(state & mask));
+      s.append(buf);
+    }
+
+    s.append("\n");
+  }
+
+  return s;
+}
+
+static void bench_data_table(const BenchOptions& options, const char* name, const std::string& input) {
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  double best = 0.0;
+  size_t code_size = 0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment);
+    x86::Assembler a(&code);
+    AsmParser parser(&a);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = parser.parse(input.data(), input.size());
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [AsmParser] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return;
+    }
+
+    code_size = code.text_section()->buffer().size();
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmParser] %-24s: %8.1f MB/s (%zu bytes of data, %.3f ms)\n",
+    name, mb_per_sec(input.size(), best), code_size, best);
+}
+
+// A binary blob embedded by `.incbin` versus the same blob converted to `.db` lines, reported in MB of the blob.
+static void bench_incbin(const BenchOptions& options, size_t blob_size) {
+  std::error_code ec;
+  std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "asmtk_bench_incbin";
+  std::filesystem::create_directories(directory, ec);
+
+  std::vector<uint8_t> blob(blob_size);
+  uint64_t state = 0x9E3779B97F4A7C15u;
+  for (size_t i = 0; i < blob_size; i++) {
+    state = state * 6364136223846793005u + 1442695040888963407u;
+    blob[i] = uint8_t(state >> 56);
+  }
+
+  std::string blob_path = (directory / "blob.bin").string();
+  FILE* f = fopen(blob_path.c_str(), "wb");
+  if (!f || fwrite(blob.data(), 1, blob.size(), f) != blob.size()) {
+    if (f)
+      fclose(f);
+    printf("  [AsmParser] .incbin: failed to write %s\n", blob_path.c_str());
+    return;
+  }
+  fclose(f);
+
+  std::string db_input;
+  for (size_t i = 0; i < blob_size; i++) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%s%u", i % 64u ? ", " : (i ? "\n.db " : ".db "), unsigned(blob[i]));
+    db_input.append(buf);
+  }
+  db_input.append("\n");
+
+  std::string incbin_input = ".incbin \"blob.bin\"\n";
+  std::string include_dir = directory.string();
+
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  for (uint32_t use_incbin = 0; use_incbin < 2; use_incbin++) {
+    const std::string& input = use_incbin ? incbin_input : db_input;
+    double best = 0.0;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+      CodeHolder code;
+      code.init(environment);
+      x86::Assembler a(&code);
+      AsmParser parser(&a);
+      parser.set_include_dir(include_dir.c_str());
+
+      PerformanceTimer timer;
+      timer.start();
+      Error err = parser.parse(input.data(), input.size());
+      timer.stop();
+
+      if (err != Error::kOk || code.text_section()->buffer().size() != blob_size) {
+        printf("  [AsmParser] %s: %s\n", use_incbin ? ".incbin" : ".db blob", DebugUtils::error_as_string(err));
+        best = 0.0;
+        break;
+      }
+
+      if (i == 0 || timer.duration() < best)
+        best = timer.duration();
+    }
+
+    if (best > 0.0) {
+      printf("  [AsmParser] %-24s: %8.1f MB/s (%zu bytes of data, %zu bytes of input, %.3f ms)\n",
+        use_incbin ? ".incbin" : ".db blob", mb_per_sec(blob_size, best), blob_size, input.size(), best);
+    }
+  }
+
+  std::filesystem::remove_all(directory, ec);
+}
+
+// ============================================================================
+// [Bench - Batch]
+// ============================================================================
+
+// Many tiny independent snippets - the construct-per-snippet loop of `asmtk_test_x86parser` versus `AsmBatch`.
+static std::vector<std::string> generate_snippets(size_t count) {
+  static const char* const bodies[] = {
+    "mov eax, ebx\nadd eax, 1\nret\n",
+    "push rbp\nmov rbp, rsp\nlea rax, [rbp - 16]\npop rbp\nret\n",
+    "xor ecx, ecx\nL0:\ninc ecx\ncmp ecx, 16\njb L0\nret\n",
+    "vaddps ymm0, ymm1, ymm2\nvmovups [rdi], ymm0\nvzeroupper\nret\n"
+  };
+
+  std::vector<std::string> snippets;
+  snippets.reserve(count);
+
+  for (size_t i = 0; i < count; i++)
+    snippets.push_back(bodies[i % (sizeof(bodies) / sizeof(bodies[0]))]);
+
+  return snippets;
+}
+
+static void bench_batch(const BenchOptions& options) {
+  constexpr size_t kCount = 100000;
+
+  std::vector<std::string> snippets = generate_snippets(kCount);
+  std::vector<AsmBatch::Job> jobs;
+
+  for (size_t i = 0; i < kCount; i++)
+    jobs.push_back(AsmBatch::Job{snippets[i].data(), snippets[i].size(), Arch::kX64, 0x10000000u + i * 64u});
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+    timer.start();
+
+    for (const AsmBatch::Job& job : jobs) {
+      Environment environment;
+      environment.set_arch(job.arch);
+
+      CodeHolder code;
+      code.init(environment, job.base_address);
+      x86::Assembler a(&code);
+      AsmParser(&a).parse(job.input, job.size);
+    }
+
+    timer.stop();
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmBatch ] %-24s: %8.0f jobs/s (%zu jobs, %.3f ms)\n",
+    "construct-per-snippet", double(kCount) * 1000.0 / best, kCount, best);
+
+  uint32_t max_threads = std::max<uint32_t>(std::thread::hardware_concurrency(), 1u);
+
+  for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+    AsmBatch batch;
+    batch.init(thread_count);
+
+    double best_rate = 0.0;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+      Error err = batch.run(jobs.data(), jobs.size());
+      if (err != Error::kOk || batch.stats().failed_count) {
+        printf("  [AsmBatch ] %s\n", err != Error::kOk ? DebugUtils::error_as_string(err) : "Some jobs failed");
+        return;
+      }
+
+      best_rate = std::max(best_rate, batch.stats().jobs_per_second());
+    }
+
+    printf("  [AsmBatch ] %-24s: %8.0f jobs/s (%zu jobs, %u threads)\n",
+      "batch", best_rate, kCount, thread_count);
+  }
+}
+
+// ============================================================================
+// [Bench - Parser Construction]
+// ============================================================================
+
+static void bench_parser_construction(const BenchOptions& options) {
+  constexpr uint32_t kCount = 1000000;
+
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  CodeHolder code;
+  code.init(environment);
+  x86::Assembler a(&code);
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+
+    timer.start();
+    for (uint32_t j = 0; j < kCount; j++) {
+      AsmParser parser(&a);
+    }
+    timer.stop();
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  printf("  [AsmParser] %-24s: %8.1f ns/op (%u iterations, %.3f ms)\n",
+    "construct+destroy", best * 1000000.0 / double(kCount), kCount, best);
+}
+
+static void bench_parser_reuse(const BenchOptions& options) {
+  constexpr size_t kCount = 100000;
+
+  std::vector<std::string> snippets = generate_snippets(kCount);
+
+  Environment environment;
+  environment.set_arch(Arch::kX64);
+
+  // Two emitters the snippets alternate between, to exercise `attach()` as well.
+  CodeHolder code[2];
+  x86::Assembler a[2];
+
+  for (uint32_t i = 0; i < 2; i++) {
+    code[i].init(environment);
+    code[i].attach(&a[i]);
+  }
+
+  double construct_best = 0.0;
+  double reuse_best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+
+    timer.start();
+    for (size_t j = 0; j < kCount; j++) {
+      x86::Assembler& emitter = a[j & 1u];
+      emitter.code()->reinit();
+      AsmParser(&emitter).parse(snippets[j].data(), snippets[j].size());
+    }
+    timer.stop();
+
+    if (i == 0 || timer.duration() < construct_best)
+      construct_best = timer.duration();
+
+    AsmParser parser(&a[0]);
+
+    timer.start();
+    for (size_t j = 0; j < kCount; j++) {
+      x86::Assembler& emitter = a[j & 1u];
+      emitter.code()->reinit();
+      parser.attach(&emitter);
+      parser.parse(snippets[j].data(), snippets[j].size());
+    }
+    timer.stop();
+
+    if (i == 0 || timer.duration() < reuse_best)
+      reuse_best = timer.duration();
+  }
+
+  printf("  [AsmParser] %-24s: %8.1f ns/snippet (%zu snippets, %.3f ms)\n",
+    "construct per snippet", construct_best * 1000000.0 / double(kCount), kCount, construct_best);
+  printf("  [AsmParser] %-24s: %8.1f ns/snippet (%zu snippets, %.3f ms, %.2fx)\n",
+    "attach per snippet", reuse_best * 1000000.0 / double(kCount), kCount, reuse_best, construct_best / reuse_best);
+}
+
+// ============================================================================
+// [Bench - Validation]
+// ============================================================================
+
+// Compares assembling with `AsmValidation::kAlways` (the default) to sampled validation and no validation.
+static void bench_validation(const BenchOptions& options, const char* name, Arch arch, const std::string& input) {
+  static const AsmValidation modes[] = { AsmValidation::kAlways, AsmValidation::kSampled, AsmValidation::kNever };
+  static const char* const mode_names[] = { "always", "sampled (1/64)", "never" };
+
+  Environment environment;
+  environment.set_arch(arch);
+
+  double baseline = 0.0;
+
+  for (size_t m = 0; m < ASMJIT_ARRAY_SIZE(modes); m++) {
+    double best = 0.0;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+      CodeHolder code;
+      code.init(environment);
+      x86::Assembler a(&code);
+
+      AsmParser parser(&a);
+      parser.set_validation(modes[m], 64);
+
+      PerformanceTimer timer;
+      timer.start();
+      Error err = parser.parse(input.data(), input.size());
+      timer.stop();
+
+      if (err != Error::kOk) {
+        printf("  [Validation] %s: %s\n", name, DebugUtils::error_as_string(err));
+        return;
+      }
+
+      if (i == 0 || timer.duration() < best)
+        best = timer.duration();
+    }
+
+    if (m == 0)
+      baseline = best;
+
+    printf("  [Validation] %-14s %-15s: %8.1f MB/s (%.3f ms, %+.1f%%)\n",
+      name, mode_names[m], mb_per_sec(input.size(), best), best, baseline > 0.0 ? (baseline / best - 1.0) * 100.0 : 0.0);
+  }
+}
+
+// ============================================================================
+// [Bench - BasicAsmParser]
+// ============================================================================
+
+// Parses `input` by `ParserT` emitting to `EmitterT` and returns the best time, or a negative value on failure.
+template<typename ParserT, typename EmitterT>
+static double bench_parser_emitter(const BenchOptions& options, const char* name, Arch arch, const std::string& input) {
+  Environment environment;
+  environment.set_arch(arch);
+
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    CodeHolder code;
+    code.init(environment);
+    EmitterT emitter(&code);
+
+    ParserT parser(&emitter);
+
+    PerformanceTimer timer;
+    timer.start();
+    Error err = parser.parse(input.data(), input.size());
+    timer.stop();
+
+    if (err != Error::kOk) {
+      printf("  [BasicAsmParser] %s: %s\n", name, DebugUtils::error_as_string(err));
+      return -1.0;
+    }
+
+    if (i == 0 || timer.duration() < best)
+      best = timer.duration();
+  }
+
+  return best;
+}
+
+// Compares `AsmParser`, which calls the emitter virtually, to `BasicAsmParser` specialized to the emitter.
+template<typename EmitterT>
+static void bench_basic_parser(const BenchOptions& options, const char* name, Arch arch, const std::string& input) {
+  double erased = bench_parser_emitter<AsmParser, EmitterT>(options, name, arch, input);
+  double basic = bench_parser_emitter<BasicAsmParser<EmitterT>, EmitterT>(options, name, arch, input);
+
+  if (erased < 0.0 || basic < 0.0)
+    return;
+
+  printf("  [BasicAsmParser] %-22s: AsmParser %8.1f MB/s | BasicAsmParser %8.1f MB/s (%+.1f%%)\n",
+    name, mb_per_sec(input.size(), erased), mb_per_sec(input.size(), basic), (erased / basic - 1.0) * 100.0);
+}
+
+// ============================================================================
+// [Bench - Throughput]
+// ============================================================================
+
+// End-to-end throughput of each stage - tokenizing, parsing without emitting (parsed commands are recorded into
+// `AsmRecord`, which includes instruction validation, but not encoding), and assembling - measured on corpora that
+// resemble real inputs, for both X86 and X64. Results can be written as JSON by `--json=<file>` to track them
+// between releases.
+
+enum class ThroughputMode : uint32_t {
+  kTokenize,
+  kParse,
+  kAssemble
+};
+
+static const char* const throughput_mode_names[] = { "tokenize", "parse", "assemble" };
+
+struct ThroughputResult {
+  const Corpus* corpus;
+  ThroughputMode mode;
+  Error err;
+  double duration;
+};
+
+static const char* arch_name(Arch arch) noexcept {
+  return arch == Arch::kX86 ? "x86" : "x64";
+}
+
+static double per_sec(size_t count, double ms) {
+  return ms > 0.0 ? double(count) / (ms / 1000.0) : 0.0;
+}
+
+static Error run_throughput_mode(ThroughputMode mode, const Corpus& corpus, AsmTokenStream& stream, AsmRecord& record) {
+  if (mode == ThroughputMode::kTokenize) {
+    AsmTokenizer tokenizer;
+    tokenizer.set_input(reinterpret_cast<const uint8_t*>(corpus.input.data()), corpus.input.size());
+    stream.clear();
+    return tokenizer.tokenize_all(stream);
+  }
+
+  Environment environment;
+  environment.set_arch(corpus.arch);
+
+  CodeHolder code;
+  code.init(environment);
+  x86::Assembler a(&code);
+  AsmParser parser(&a);
+
+  if (mode == ThroughputMode::kParse) {
+    record.clear();
+    return parser.record(record, corpus.input.data(), corpus.input.size());
+  }
+  else {
+    return parser.parse(corpus.input.data(), corpus.input.size());
+  }
+}
+
+static ThroughputResult bench_throughput_mode(const BenchOptions& options, ThroughputMode mode, const Corpus& corpus) {
+  ThroughputResult result { &corpus, mode, Error::kOk, 0.0 };
+
+  // Reused by all iterations, so only the first iteration pays for growing them.
+  AsmTokenStream stream;
+  AsmRecord record;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    PerformanceTimer timer;
+    timer.start();
+    Error err = run_throughput_mode(mode, corpus, stream, record);
+    timer.stop();
+
+    if (err != Error::kOk) {
+      result.err = err;
+      break;
+    }
+
+    if (i == 0 || timer.duration() < result.duration)
+      result.duration = timer.duration();
+  }
+
+  if (result.err != Error::kOk) {
+    printf("  [Throughput] %s/%-14s %-8s: %s\n",
+      arch_name(corpus.arch), corpus.name, throughput_mode_names[uint32_t(mode)], DebugUtils::error_as_string(result.err));
+  }
+  else {
+    printf("  [Throughput] %s/%-14s %-8s: %8.1f MB/s %8.2f Mlines/s %8.2f Minsts/s (%.3f ms)\n",
+      arch_name(corpus.arch), corpus.name, throughput_mode_names[uint32_t(mode)],
+      mb_per_sec(corpus.input.size(), result.duration),
+      per_sec(corpus.line_count, result.duration) / 1e6,
+      per_sec(corpus.instruction_count, result.duration) / 1e6,
+      result.duration);
+  }
+
+  return result;
+}
+
+static bool write_throughput_json(const char* path, const BenchOptions& options, const std::vector<ThroughputResult>& results) {
+  FILE* f = fopen(path, "w");
+  if (!f)
+    return false;
+
+  fprintf(f, "{\n");
+  fprintf(f, "  \"asmtk_version\": \"%u.%u.%u\",\n",
+    (ASMTK_LIBRARY_VERSION >> 16) & 0xFFu, (ASMTK_LIBRARY_VERSION >> 8) & 0xFFu, ASMTK_LIBRARY_VERSION & 0xFFu);
+  fprintf(f, "  \"asmjit_version\": \"%u.%u.%u\",\n",
+    (ASMJIT_LIBRARY_VERSION >> 16) & 0xFFu, (ASMJIT_LIBRARY_VERSION >> 8) & 0xFFu, ASMJIT_LIBRARY_VERSION & 0xFFu);
+  fprintf(f, "  \"iterations\": %u,\n", options.iterations);
+  fprintf(f, "  \"results\": [");
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const ThroughputResult& result = results[i];
+    const Corpus& corpus = *result.corpus;
+
+    fprintf(f, "%s\n    {\"corpus\": \"%s\", \"arch\": \"%s\", \"mode\": \"%s\", \"bytes\": %zu, \"lines\": %zu, \"commands\": %zu, \"instructions\": %zu, ",
+      i ? "," : "", corpus.name, arch_name(corpus.arch), throughput_mode_names[uint32_t(result.mode)],
+      corpus.input.size(), corpus.line_count, corpus.command_count, corpus.instruction_count);
+
+    if (result.err != Error::kOk) {
+      fprintf(f, "\"error\": \"%s\"}", DebugUtils::error_as_string(result.err));
+    }
+    else {
+      fprintf(f, "\"ms\": %.3f, \"mb_per_sec\": %.2f, \"lines_per_sec\": %.0f, \"instructions_per_sec\": %.0f}",
+        result.duration,
+        mb_per_sec(corpus.input.size(), result.duration),
+        per_sec(corpus.line_count, result.duration),
+        per_sec(corpus.instruction_count, result.duration));
+    }
+  }
+
+  fprintf(f, "\n  ]\n}\n");
+  return fclose(f) == 0;
+}
+
+static void bench_throughput(const BenchOptions& options, const char* json_path) {
+  constexpr size_t kCorpusSize = 2 * 1024 * 1024;
+
+  std::vector<Corpus> corpora;
+  for (Arch arch : { Arch::kX86, Arch::kX64 }) {
+    corpora.push_back(generate_gp_heavy_corpus(arch, kCorpusSize));
+    corpora.push_back(generate_avx512_heavy_corpus(arch, kCorpusSize));
+    corpora.push_back(generate_label_dense_corpus(arch, uint32_t(kCorpusSize / 80u) + 1u));
+    corpora.push_back(generate_comment_heavy_corpus(arch, kCorpusSize));
+    corpora.push_back(generate_data_heavy_corpus(arch, kCorpusSize));
+  }
+
+  std::vector<ThroughputResult> results;
+  for (const Corpus& corpus : corpora)
+    for (ThroughputMode mode : { ThroughputMode::kTokenize, ThroughputMode::kParse, ThroughputMode::kAssemble })
+      results.push_back(bench_throughput_mode(options, mode, corpus));
+
+  if (json_path) {
+    if (write_throughput_json(json_path, options, results))
+      printf("  [Throughput] Results written to '%s'\n", json_path);
+    else
+      printf("  [Throughput] Failed to write '%s'\n", json_path);
+  }
+}
+
+// ============================================================================
+// [Bench - Main]
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+  CmdLine cmd_line(argc, argv);
+  BenchOptions options;
+
+  if (cmd_line.has_key("--quick"))
+    options.iterations = 1;
+
+  // `--json=<file>` writes throughput results to `<file>`, `--throughput` only runs the throughput benchmark.
+  const char* json_path = cmd_line.value_of("--json");
+  if (json_path && !json_path[0])
+    json_path = nullptr;
+
+  printf("AsmTK Benchmark (iterations=%u)\n", options.iterations);
+
+  bench_throughput(options, json_path);
+  if (cmd_line.has_key("--throughput"))
+    return 0;
+
+  bench_validation(options, "x64/gp-heavy", Arch::kX64, generate_gp_heavy_corpus(Arch::kX64, 8 * 1024 * 1024).input);
+  bench_validation(options, "x64/avx512", Arch::kX64, generate_avx512_heavy_corpus(Arch::kX64, 8 * 1024 * 1024).input);
+
+  std::string gp_heavy = generate_gp_heavy_corpus(Arch::kX64, 8 * 1024 * 1024).input;
+  bench_basic_parser<x86::Assembler>(options, "x64/gp-heavy/assembler", Arch::kX64, gp_heavy);
+  bench_basic_parser<x86::Builder>(options, "x64/gp-heavy/builder", Arch::kX64, gp_heavy);
+
+  std::string comment_heavy = generate_comment_heavy_corpus(Arch::kX64, 16 * 1024 * 1024).input;
+  bench_tokenizer(options, "comment-heavy", comment_heavy);
+  bench_tokenize_all(options, "comment-heavy", comment_heavy);
+
+  bench_register_recognizer(options);
+  bench_parser(options, "register-dense", generate_register_dense_input(4 * 1024 * 1024));
+
+  std::string instruction_heavy = generate_instruction_heavy_input(4 * 1024 * 1024);
+  bench_parser(options, "instruction-heavy", instruction_heavy);
+
+  std::string label_dense = generate_label_dense_corpus(Arch::kX64, 50000).input;
+  bench_parser(options, "label-dense", label_dense);
+  bench_label_scaling(options);
+
+  bench_parser_parallel(options, "parallel/instructions", instruction_heavy);
+  bench_parser_parallel(options, "parallel/labels", label_dense);
+
+  bench_parser_pipelined(options, "pipelined/instructions", instruction_heavy);
+  bench_parser_pipelined(options, "pipelined/labels", label_dense);
+
+  bench_replay(options, "replay/instructions", instruction_heavy);
+  bench_replay(options, "replay/labels", label_dense);
+
+  bench_cache(options, "cache/instructions", instruction_heavy);
+  bench_cache(options, "cache/labels", label_dense);
+
+  size_t double_count = 1000000;
+  std::string double_table = generate_double_table(double_count);
+  bench_strtod(options, double_table, double_count);
+  bench_double_table(options, double_table, double_count);
+
+  bench_data_table(options, ".db table (decimal)", generate_integer_table(".db", 1, false, 4096, 8 * 1024 * 1024));
+  bench_data_table(options, ".dd table (hex)", generate_integer_table(".dd", 4, true, 4096, 8 * 1024 * 1024));
+  bench_data_table(options, ".dq table (decimal)", generate_integer_table(".dq", 8, false, 4096, 8 * 1024 * 1024));
+  bench_incbin(options, 16 * 1024 * 1024);
+
+  bench_batch(options);
+  bench_parser_construction(options);
+  bench_parser_reuse(options);
+  return 0;
+}
@@ -71,6 +71,7 @@ int main(int argc, char* argv[]) {
   CmdLine cmd(argc, argv);
   const char* archArg = cmd.value_of("--arch");
   const char* baseArg = cmd.value_of("--base");
+  const char* fileArg = cmd.value_of("--file");
 
   Environment environment = Environment::host();
   Arch arch = environment.arch();
@@ -102,11 +103,33 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  // Assemble a whole file and print the code if a file was given.
+  if (fileArg) {
+    environment.set_arch(arch);
+
+    CodeHolder code;
+    code.init(environment, base_address);
+
+    x86::Assembler a(&code);
+    AsmParser p(&a);
+
+    Error err = p.parse_file(fileArg);
+    if (err != Error::kOk) {
+      printf("ERROR: 0x%08X at offset %zu: %s\n", uint32_t(err), p.current_command_offset(), DebugUtils::error_as_string(err));
+      return 1;
+    }
+
+    CodeBuffer& buffer = code.section_by_id(0)->buffer();
+    dumpCode(buffer.data(), buffer.size());
+    return 0;
+  }
+
   printf("===============================================================\n");
   printf("AsmTk [Assembler toolkit based on AsmJit]\n"                      );
   printf("  - A simple command-line based instruction encoder\n"            );
   printf("  - Architecture=%s [select by --arch=x86|x64]\n", archArg        );
   printf("  - Base-Address=%s [select by --base=hex]\n", baseArg            );
+  printf("  - Assemble a file instead by --file=path\n"                      );
   printf("---------------------------------------------------------------\n");
   printf("Input:\n"                                                         );
   printf("  - Enter instruction and its operands to be encoded.\n"          );
@@ -24,7 +24,19 @@ static Error ASMJIT_CDECL unknown_symbol_handler(AsmParser* parser, Operand* dst
     return Error::kOk;
   }
 
-  // Dst is initially an empty operand (none), if it's not changed AsmTK
+  // The handler can read the tokens that follow the symbol by its own rules.
+  if (size == 5 && memcmp(name, "TestC", 5) == 0) {
+    AsmToken token;
+    AsmTokenType type = parser->next_token(&token, ParseFlags::kIncludeDashes);
+
+    if (type != AsmTokenType::kSym || token.size() != 7 || memcmp(token.data(), "rdx-reg", 7) != 0)
+      return Error::kInvalidState;
+
+    *dst = x86::rdx;
+    return Error::kOk;
+  }
+
+    // Dst is initially an empty operand (none), if it's not changed AsmTK
   // will create label for it by default. Don't return error in any case
   // as that will terminate the parsing and return immediately.
   return Error::kOk;
@@ -54,11 +66,19 @@ int main(int argc, char* argv[]) {
   AsmParser parser(&a);
   parser.set_unknown_symbol_handler(unknown_symbol_handler);
 
-  err = parser.parse("mov rax, TestA\ncall TestB\n");
+  err = parser.parse("mov rax, TestA\ncall TestB\nmov rax, TestC rdx-reg\n");
   if (err != Error::kOk) {
     printf("[FAILURE] AsmParser.parse(): %s\n", DebugUtils::error_as_string(err));
     return 1;
   }
+
+  // Records resolve symbols when replayed, which would bypass the handler.
+  AsmRecord record;
+  err = parser.record(record, "mov rax, TestA\n");
+  if (err != Error::kInvalidState) {
+    printf("[FAILURE] AsmParser.record() must reject an unknown symbol handler: %s\n", DebugUtils::error_as_string(err));
+    return 1;
+  }
   else {
     printf("[SUCCESS]\n");
     return 0;
@@ -3,6 +3,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <filesystem>
+#include <string>
+#include <vector>
+
 #include <asmjit/x86.h>
 #include "./asmtk.h"
 #include "./cmdline.h"
@@ -18,6 +22,8 @@ struct TestEntry {
   uint8_t machine_code_size;
   char machine_code[16];
   char asm_string[64];
+  //! Error a failing entry must fail with, `Error::kOk` if it can fail with any error.
+  Error fail_error;
 };
 
 #define X86_PASS(BASE, MACHINE_CODE, ASM_STRING) { \
@@ -27,7 +33,8 @@ struct TestEntry {
   uint8_t(sizeof(ASM_STRING  ) - 1),               \
   uint8_t(sizeof(MACHINE_CODE) - 1),               \
   MACHINE_CODE,                                    \
-  ASM_STRING                                       \
+  ASM_STRING,                                      \
+  Error::kOk                                       \
 }
 
 #define X86_FAIL(BASE, ASM_STRING) {               \
@@ -37,7 +44,19 @@ struct TestEntry {
   uint8_t(sizeof(ASM_STRING  ) - 1),               \
   0,                                               \
   "",                                              \
-  ASM_STRING                                       \
+  ASM_STRING,                                      \
+  Error::kOk                                       \
+}
+
+#define X86_FAIL_WITH(BASE, ERROR, ASM_STRING) {   \
+  BASE,                                            \
+  Arch::kX86,                                      \
+  false,                                           \
+  uint8_t(sizeof(ASM_STRING  ) - 1),               \
+  0,                                               \
+  "",                                              \
+  ASM_STRING,                                      \
+  ERROR                                            \
 }
 
 #define X64_PASS(BASE, MACHINE_CODE, ASM_STRING) { \
@@ -47,7 +66,8 @@ struct TestEntry {
   uint8_t(sizeof(ASM_STRING  ) - 1),               \
   uint8_t(sizeof(MACHINE_CODE) - 1),               \
   MACHINE_CODE,                                    \
-  ASM_STRING                                       \
+  ASM_STRING,                                      \
+  Error::kOk                                       \
 }
 
 #define X64_FAIL(BASE, ASM_STRING) {               \
@@ -57,7 +77,8 @@ struct TestEntry {
   uint8_t(sizeof(ASM_STRING  ) - 1),               \
   0,                                               \
   "",                                              \
-  ASM_STRING                                       \
+  ASM_STRING,                                      \
+  Error::kOk                                       \
 }
 
 #define RELOC_BASE_ADDRESS Globals::kNoBaseAddress
@@ -102,6 +123,26 @@ static const TestEntry test_entries[] = {
   X64_PASS(RELOC_BASE_ADDRESS, "\x48\xBB\x00\x00\x00\x00\x00\x00\x00\x00"         , "long mov rbx, 0"),
   X64_PASS(RELOC_BASE_ADDRESS, "\x48\xBB\x00\x00\x00\x00\x00\x00\x00\x00"         , "movabs rbx, 0"),
 
+  // Integer data.
+  X86_PASS(RELOC_BASE_ADDRESS, "\x01\x02\x03\xFF"                                 , ".db 1, 2, 0x3, 255"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x08\x0A\x03"                                 , ".db 0, 010, 0ah, 11b"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x34\x12\xFF\xFF\x00\x00"                         , ".dw 0x1234, 65535, 0"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x78\x56\x34\x12\xFF\xFF\xFF\xFF"                 , ".dd 0x12345678, 4294967295"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\xEF\xCD\xAB\x89\x67\x45\x23\x01"                 , ".dq 0x0123456789ABCDEF"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\xD2\x0A\x1F\xEB\x8C\xA9\x54\xAB"                 , ".dq 12345678901234567890"),
+
+  // Floating point data.
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x3C"                                         , ".half 1"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x66\x2E"                                         , ".half 0.1"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x3C\x00\xC0"                                 , ".half 1, -2"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x00\xC0\x3F"                                 , ".float 1.5"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\xCD\xCC\xCC\x3D"                                 , ".float 0.1"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x00\x80\x41"                                 , ".float 0x10"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x00\x00\x80\x00\x00\x80\x3F"                 , ".FLOAT -0.0, 1E0"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x00\x00\x00\x00\x00\xF8\x3F"                 , ".double 1.5"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x9A\x99\x99\x99\x99\x99\xB9\x3F"                 , ".double 0.1"),
+  X86_PASS(RELOC_BASE_ADDRESS, "\x00\x00\x00\x00\x00\x00\xE0\xBF"                 , ".double -5e-1"),
+
   // 32-bit base instructions.
   X86_PASS(RELOC_BASE_ADDRESS, "\x88\xC4"                                         , "mov ah, al"),
   X86_PASS(RELOC_BASE_ADDRESS, "\x88\xC6"                                         , "mov dh, al"),
@@ -1007,6 +1048,15 @@ static const TestEntry test_entries[] = {
   X86_FAIL(RELOC_BASE_ADDRESS, "lock xacquire xrelease add [eax], ecx"),
   X86_FAIL(RELOC_BASE_ADDRESS, "vaddps xmm0 {k0}, xmm1, xmm2"),
   X86_FAIL(RELOC_BASE_ADDRESS, "vaddps xmm0 {k0}{z}, xmm1, xmm2"),
+  X86_FAIL(RELOC_BASE_ADDRESS, ".db 1, 256"),
+  X86_FAIL(RELOC_BASE_ADDRESS, ".db 1, 2,"),
+  X86_FAIL(RELOC_BASE_ADDRESS, ".dw 1, 2, 65536, 3"),
+  X86_FAIL_WITH(RELOC_BASE_ADDRESS, Error::kInvalidImmediate, ".half 65520"),
+  X86_FAIL_WITH(RELOC_BASE_ADDRESS, Error::kInvalidImmediate, ".float 1e50"),
+  X86_FAIL(RELOC_BASE_ADDRESS, ".float 1.5x"),
+  X86_FAIL_WITH(RELOC_BASE_ADDRESS, Error::kInvalidImmediate, ".float 1e400"),
+  X86_FAIL_WITH(RELOC_BASE_ADDRESS, Error::kInvalidImmediate, ".double 1e400"),
+  X86_FAIL(RELOC_BASE_ADDRESS, ".double abc"),
 
   // 64-bit malformed input - should cause either parsing or validation error.
   X64_FAIL(0x0000000000001000, "short jmp 0x2000"),
@@ -1052,21 +1102,106 @@ static void dump_hex(const char* s, size_t count) {
     printf("%02X", unsigned(uint8_t(s[i])));
 }
 
+static const char* arch_name(Arch arch) {
+  return arch == Arch::kX86 ? "X86" : "X64";
+}
+
+// Initializes `code` for the given `arch` and `base_address`.
+static Error init_code(CodeHolder& code, Arch arch, uint64_t base_address = Globals::kNoBaseAddress) {
+  Environment environment;
+  environment.set_arch(arch);
+  return code.init(environment, base_address);
+}
+
+// Initializes `code` for assembling `entry`.
+static Error init_code(CodeHolder& code, const TestEntry& entry) {
+  return init_code(code, entry.arch, entry.base_address);
+}
+
+// Tests whether `err` is the error a failing `entry` must fail with.
+static bool is_expected_failure(const TestEntry& entry, Error err) {
+  return err != Error::kOk && (entry.fail_error == Error::kOk || err == entry.fail_error);
+}
+
+// Checks the result of assembling `entry` - entries that must pass must produce the expected machine code in `data`,
+// other entries must fail. Prints the entry if the check fails.
+static bool check_entry(const TestEntry& entry, Error err, const void* data, size_t size, const char* test_name) {
+  bool ok = entry.must_pass
+    ? err == Error::kOk && size == entry.machine_code_size && memcmp(data, entry.machine_code, size) == 0
+    : is_expected_failure(entry, err);
+
+  if (!ok)
+    printf("-%s: %-55s -> [FAILED] %s\n", arch_name(entry.arch), entry.asm_string, test_name);
+  return ok;
+}
+
+static bool check_entry(const TestEntry& entry, Error err, CodeHolder& code, const char* test_name) {
+  const CodeBuffer& buf = code.section_by_id(0)->buffer();
+  return check_entry(entry, err, buf.data(), buf.size(), test_name);
+}
+
+// Tests whether the code in `buf` is the same as the code in `expected`.
+static bool has_same_code(const CodeBuffer& buf, const CodeBuffer& expected) {
+  return buf.size() == expected.size() && memcmp(buf.data(), expected.data(), buf.size()) == 0;
+}
+
+// Adds the result of a test to `stats`.
+static bool add_result(TestStats& stats, bool passed) {
+  stats.total++;
+  if (passed)
+    stats.passed++;
+  else
+    stats.failed++;
+  return passed;
+}
+
+// Assembles the entry again by feeding its input byte by byte, which must produce the same machine code.
+static bool run_chunked_test(const TestEntry& entry, const CodeBuffer& expected) {
+  CodeHolder code;
+  if (init_code(code, entry) != Error::kOk)
+    return false;
+
+  x86::Assembler a(&code);
+  AsmParser parser(&a);
+
+  for (size_t i = 0; i < entry.asm_size; i++)
+    if (parser.feed(entry.asm_string + i, 1) != Error::kOk)
+      return false;
+
+  if (parser.finish() != Error::kOk)
+    return false;
+
+  return has_same_code(code.section_by_id(0)->buffer(), expected);
+}
+
+// Records the entry and replays the record, which must produce the same machine code.
+static bool run_replay_test(const TestEntry& entry, const CodeBuffer& expected) {
+  CodeHolder code;
+  if (init_code(code, entry) != Error::kOk)
+    return false;
+
+  x86::Assembler a(&code);
+  AsmRecord record;
+
+  if (AsmParser(&a).record(record, entry.asm_string, entry.asm_size) != Error::kOk)
+    return false;
+
+  if (record.replay(&a) != Error::kOk)
+    return false;
+
+  return has_same_code(code.section_by_id(0)->buffer(), expected);
+}
+
 static bool run_tests(TestStats& out, const TestOptions& options, Span<const TestEntry> entries) {
   out.passed = 0;
   out.failed = 0;
   out.total  = uint32_t(entries.size());
 
   for (const TestEntry& entry : entries) {
-    const char* arch = entry.arch == Arch::kX86 ? "X86" : "X64";
+    const char* arch = arch_name(entry.arch);
 
-    // Initialize Environment with the requested architecture.
-    Environment environment;
-    environment.set_arch(entry.arch);
-
-    // Initialize CodeHolder.
     CodeHolder code;
-    Error err = code.init(environment, entry.base_address);
+    Error err = init_code(code, entry);
 
     if (err != Error::kOk) {
       printf("CodeHolder.init(): %s [FAILED]\n", DebugUtils::error_as_string(err));
@@ -1079,12 +1214,17 @@ static bool run_tests(TestStats& out, const TestOptions& options, Span<const Tes
     err = AsmParser(&a).parse(entry.asm_string, entry.asm_size);
 
     if (err != Error::kOk) {
-      if (!entry.must_pass) {
+      if (!entry.must_pass && is_expected_failure(entry, err)) {
         if (!options.only_failures) {
           printf(" %s: %-55s -> %s [OK]\n", arch, entry.asm_string, DebugUtils::error_as_string(err));
         }
         out.passed++;
       }
+      else if (!entry.must_pass) {
+        printf("-%s: %-55s -> %s [FAILED] Expected %s\n", arch, entry.asm_string,
+          DebugUtils::error_as_string(err), DebugUtils::error_as_string(entry.fail_error));
+        out.failed++;
+      }
       else {
         printf("-%s: %-55s -> %s [FAILED]\n", arch, entry.asm_string, DebugUtils::error_as_string(err));
         out.failed++;
@@ -1094,6 +1234,18 @@ static bool run_tests(TestStats& out, const TestOptions& options, Span<const Tes
       CodeBuffer& buf = code.section_by_id(0)->buffer();
 
       if (entry.must_pass && buf.size() == entry.machine_code_size && memcmp(buf.data(), entry.machine_code, entry.machine_code_size) == 0) {
+        if (!run_chunked_test(entry, buf)) {
+          printf("-%s: %-55s -> [FAILED] Chunked input\n", arch, entry.asm_string);
+          out.failed++;
+          continue;
+        }
+
+        if (!run_replay_test(entry, buf)) {
+          printf("-%s: %-55s -> [FAILED] Replay\n", arch, entry.asm_string);
+          out.failed++;
+          continue;
+        }
+
         if (!options.only_failures) {
           printf(" %s: %-55s -> ", arch, entry.asm_string);
           dump_hex(reinterpret_cast<const char*>(buf.data()), buf.size());
@@ -1129,6 +1281,687 @@ static bool run_tests(TestStats& out, const TestOptions& options, Span<const Tes
   return out.failed == 0;
 }
 
+// Concatenates relocatable X64 entries (interleaved by labels and jumps to exercise symbol resolution) into a large
+// input, which must assemble to the same code by `parse()` and by the multi-threaded variants of it.
+static std::string generate_large_input(Span<const TestEntry> entries) {
+  std::string input;
+  uint32_t entry_count = 0;
+  uint32_t function_id = 0;
+
+  while (input.size() < 1024 * 1024) {
+    for (const TestEntry& entry : entries) {
+      if (!entry.must_pass || entry.arch != Arch::kX64 || entry.base_address != RELOC_BASE_ADDRESS)
+        continue;
+
+      if ((entry_count++ & 0x7) == 0) {
+        char label[128];
+        snprintf(label, sizeof(label), "fn_%u:\n.loop:\njnz .loop\njz fn_%u.loop\ncall fn_%u\n", function_id, function_id / 2u, function_id + 3u);
+        input.append(label);
+        function_id++;
+      }
+
+      input.append(entry.asm_string, entry.asm_size);
+      input.append("\n");
+    }
+  }
+
+  return input;
+}
+
+// Inserts an invalid instruction at the beginning of the line at `position` (a fraction of the input size).
+static std::string insert_invalid_line(const std::string& input, double position) {
+  size_t offset = input.find('\n', size_t(double(input.size()) * position));
+  offset = offset == std::string::npos ? input.size() : offset + 1u;
+
+  std::string s(input, 0, offset);
+  s.append("invalid_instruction eax, ebx\n");
+  s.append(input, offset, std::string::npos);
+  return s;
+}
+
+enum class ParseVariant : uint32_t {
+  kParallel,
+  kPipelined
+};
+
+// Parses `input` by `parse()` and by the given `variant`, which must return the same error at the same command
+// offset and emit the same code - commands that precede a failed command are emitted by both.
+static bool run_variant_test(ParseVariant variant, const char* test_name, const std::string& input, bool must_pass) {
+  CodeHolder code_a;
+  CodeHolder code_b;
+
+  Error err = init_code(code_a, Arch::kX64);
+  if (err == Error::kOk)
+    err = init_code(code_b, Arch::kX64);
+
+  x86::Assembler a(&code_a);
+  x86::Assembler b(&code_b);
+
+  AsmParser parser_a(&a);
+  AsmParser parser_b(&b);
+
+  Error err_a = err;
+  Error err_b = err;
+
+  if (err == Error::kOk) {
+    err_a = parser_a.parse(input.data(), input.size());
+    err_b = variant == ParseVariant::kParallel ? parser_b.parse_parallel(input.data(), input.size(), 4)
+                                               : parser_b.parse_pipelined(input.data(), input.size());
+  }
+
+  bool ok = err == Error::kOk &&
+            (err_a == Error::kOk) == must_pass &&
+            err_a == err_b &&
+            parser_a.current_command_offset() == parser_b.current_command_offset() &&
+            has_same_code(code_b.section_by_id(0)->buffer(), code_a.section_by_id(0)->buffer());
+
+  // A failed parse must leave no thread behind and the parser ready for the next input.
+  if (ok && !must_pass) {
+    code_b.reset();
+    ok = init_code(code_b, Arch::kX64) == Error::kOk;
+    code_b.attach(&b);
+    parser_b.attach(&b);
+    ok = ok && parser_b.parse("nop\n") == Error::kOk && code_b.section_by_id(0)->buffer().size() == 1;
+  }
+
+  printf("%sX64: %s of %zu bytes -> %s at %zu [%s]\n",
+    ok ? " " : "-", test_name, input.size(), DebugUtils::error_as_string(err_b), parser_b.current_command_offset(), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Parses the input in parallel, and again with an invalid instruction in the last region, which must be reported
+// at its offset in the whole input after all regions before it were emitted.
+static bool run_parallel_test(const std::string& input) {
+  bool ok = run_variant_test(ParseVariant::kParallel, "Parallel parsing", input, true);
+  ok &= run_variant_test(ParseVariant::kParallel, "Parallel parsing (error)", insert_invalid_line(input, 0.9), false);
+  return ok;
+}
+
+// Records the input once and replays it twice, each replay must produce the same code as `parse()`.
+static bool run_record_test(const std::string& input) {
+  CodeHolder code_a;
+  Error err = init_code(code_a, Arch::kX64);
+  x86::Assembler a(&code_a);
+
+  if (err == Error::kOk)
+    err = AsmParser(&a).parse(input.data(), input.size());
+
+  AsmRecord record;
+  if (err == Error::kOk) {
+    CodeHolder code;
+    err = init_code(code, Arch::kX64);
+    x86::Assembler tmp(&code);
+
+    if (err == Error::kOk)
+      err = AsmParser(&tmp).record(record, input.data(), input.size());
+  }
+
+  bool ok = err == Error::kOk;
+  for (uint32_t i = 0; ok && i < 2; i++) {
+    CodeHolder code_b;
+    err = init_code(code_b, Arch::kX64);
+    x86::Assembler b(&code_b);
+
+    if (err == Error::kOk)
+      err = record.replay(&b);
+
+    ok = err == Error::kOk && has_same_code(code_b.section_by_id(0)->buffer(), code_a.section_by_id(0)->buffer());
+  }
+
+  printf("%sX64: Record and replay of %zu bytes -> %s [%s]\n",
+    ok ? " " : "-", input.size(), DebugUtils::error_as_string(err), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Parses the same input twice with a cache in a temporary directory - the first parse must store it and the second
+// must load it, both producing the same code as without the cache.
+static bool run_cache_test() {
+  std::string input;
+  for (uint32_t i = 0; i < 1000; i++) {
+    char function[256];
+    snprintf(function, sizeof(function),
+      "fn_%u:\n.loop:\ndec ecx\njnz .loop\ncall fn_%u\njmp fn_%u.exit\n.align 16\n.exit:\nret\n", i, i / 2u, i);
+    input.append(function);
+  }
+
+  std::error_code ec;
+  std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "asmtk_test_cache";
+  std::filesystem::remove_all(directory, ec);
+  std::filesystem::create_directories(directory, ec);
+
+  AsmCache cache;
+  Error err = cache.init(directory.string().c_str());
+
+  CodeHolder code_ref;
+  if (err == Error::kOk)
+    err = init_code(code_ref, Arch::kX64, 0x10000);
+  x86::Assembler ref(&code_ref);
+
+  if (err == Error::kOk)
+    err = AsmParser(&ref).parse(input.data(), input.size());
+
+  bool ok = err == Error::kOk;
+  for (uint32_t i = 0; ok && i < 2; i++) {
+    CodeHolder code;
+    err = init_code(code, Arch::kX64, 0x10000);
+    x86::Assembler a(&code);
+
+    AsmParser parser(&a);
+    parser.set_cache(&cache);
+    if (err == Error::kOk)
+      err = parser.parse(input.data(), input.size());
+
+    ok = err == Error::kOk && code.label_count() == code_ref.label_count() &&
+         has_same_code(code.section_by_id(0)->buffer(), code_ref.section_by_id(0)->buffer());
+  }
+
+  // Input that is not validated is neither served from the cache nor stored.
+  if (ok) {
+    CodeHolder code;
+    err = init_code(code, Arch::kX64, 0x10000);
+    x86::Assembler a(&code);
+
+    AsmParser parser(&a);
+    parser.set_cache(&cache);
+    parser.set_validation(AsmValidation::kNever);
+    if (err == Error::kOk)
+      err = parser.parse(input.data(), input.size());
+    ok = err == Error::kOk && cache.stats().bypass_count == 1;
+  }
+
+  ok = ok && cache.stats().store_count == 1 && cache.stats().hit_count == 1;
+  std::filesystem::remove_all(directory, ec);
+
+  printf("%sX64: Cached parsing of %zu bytes -> %s [%s]\n",
+    ok ? " " : "-", input.size(), DebugUtils::error_as_string(err), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Parses the input with tokenizing on another thread, and again with an invalid instruction in a late batch, which
+// must be reported at its offset after the tokenizer thread was stopped.
+static bool run_pipelined_test(const std::string& input) {
+  bool ok = run_variant_test(ParseVariant::kPipelined, "Pipelined parsing", input, true);
+  ok &= run_variant_test(ParseVariant::kPipelined, "Pipelined parsing (error)", insert_invalid_line(input, 0.9), false);
+  return ok;
+}
+
+// Assembles all entries (several times, to reuse workers across architectures and base addresses) by `AsmBatch`,
+// which must produce the same results as assembling them one by one.
+static bool run_batch_test(Span<const TestEntry> entries) {
+  constexpr uint32_t kRepeatCount = 16;
+
+  std::vector<AsmBatch::Job> jobs;
+  for (uint32_t i = 0; i < kRepeatCount; i++)
+    for (const TestEntry& entry : entries)
+      jobs.push_back(AsmBatch::Job{entry.asm_string, entry.asm_size, entry.arch, entry.base_address});
+
+  AsmBatch batch;
+  Error err = batch.init(4);
+  if (err == Error::kOk)
+    err = batch.run(jobs.data(), jobs.size());
+
+  size_t failed_count = 0;
+  if (err == Error::kOk) {
+    for (size_t i = 0; i < jobs.size(); i++) {
+      const AsmBatch::Result& result = batch.result_at(i);
+      if (!check_entry(entries[i % entries.size()], result.err, batch.job_data(i), result.size, "Batch"))
+        failed_count++;
+    }
+  }
+
+  bool ok = err == Error::kOk && failed_count == 0;
+  printf("%sX86/X64: Batch of %zu jobs -> %s [%s]\n",
+    ok ? " " : "-", jobs.size(), DebugUtils::error_as_string(err), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Parses input with errors in recovery mode, all errors must be reported and all valid lines emitted - the same
+// way whether the input is parsed at once or fed in chunks that split lines.
+static bool run_recovery_test() {
+  static const char input[] =
+    "mov eax, 1\n"
+    "mov eax, [\n"
+    "add eax, ebx\n"
+    "  bogus eax, ebx\n"
+    "L0: jmp L0\n"
+    "ret";
+
+  static const char valid_input[] =
+    "mov eax, 1\n"
+    "add eax, ebx\n"
+    "L0: jmp L0\n"
+    "ret";
+
+  struct ExpectedLocation { size_t line, column; };
+  static const ExpectedLocation expected[] = { { 2, 1 }, { 4, 3 } };
+
+  CodeHolder code_a;
+  CodeHolder code_b;
+  CodeHolder code_c;
+
+  if (init_code(code_a, Arch::kX64) != Error::kOk ||
+      init_code(code_b, Arch::kX64) != Error::kOk ||
+      init_code(code_c, Arch::kX64) != Error::kOk) {
+    printf("-X64: Recovery mode -> CodeHolder.init() [FAILED]\n");
+    return false;
+  }
+
+  x86::Assembler a(&code_a);
+  Error err_a = AsmParser(&a).parse(valid_input);
+
+  x86::Assembler b(&code_b);
+
+  AsmDiagnostics diagnostics;
+  AsmParser parser(&b);
+  parser.set_diagnostics(&diagnostics);
+  Error err_b = parser.parse(input);
+
+  x86::Assembler c(&code_c);
+
+  AsmDiagnostics fed_diagnostics;
+  parser.attach(&c);
+  parser.set_diagnostics(&fed_diagnostics);
+
+  size_t split = sizeof(input) / 2u;
+  Error err_c0 = parser.feed(input, split);
+  Error err_c1 = parser.feed(input + split, sizeof(input) - 1u - split);
+  Error err_c2 = parser.finish();
+  fed_diagnostics.set_source(input, sizeof(input) - 1u);
+
+  bool ok = err_a == Error::kOk &&
+            err_b != Error::kOk &&
+            (err_c0 != Error::kOk || err_c1 != Error::kOk) && err_c2 == Error::kOk &&
+            diagnostics.size() == ASMJIT_ARRAY_SIZE(expected) &&
+            fed_diagnostics.size() == ASMJIT_ARRAY_SIZE(expected) &&
+            err_b == diagnostics.diagnostic_at(0).err;
+
+  for (size_t i = 0; ok && i < ASMJIT_ARRAY_SIZE(expected); i++) {
+    const AsmDiagnostics::Diagnostic& d = diagnostics.diagnostic_at(i);
+    const AsmDiagnostics::Diagnostic& fd = fed_diagnostics.diagnostic_at(i);
+
+    AsmDiagnostics::Location loc;
+    AsmDiagnostics::Location fed_loc;
+
+    ok = diagnostics.location_of(d.offset, &loc) == Error::kOk &&
+         fed_diagnostics.location_of(fd.offset, &fed_loc) == Error::kOk &&
+         loc.line == expected[i].line && loc.column == expected[i].column &&
+         fed_loc.line == loc.line && fed_loc.column == loc.column &&
+         d.offset == fd.offset && d.size == fd.size && d.err == fd.err &&
+         input[d.offset + d.size] == '\n';
+  }
+
+  const CodeBuffer& buf_a = code_a.section_by_id(0)->buffer();
+  ok = ok && has_same_code(code_b.section_by_id(0)->buffer(), buf_a) && has_same_code(code_c.section_by_id(0)->buffer(), buf_a);
+
+  printf("%sX64: Recovery mode reported %zu errors -> %s [%s]\n",
+    ok ? " " : "-", diagnostics.size(), DebugUtils::error_as_string(err_b), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+#if defined(ASMTK_STATISTICS)
+static bool run_statistics_test() {
+  CodeHolder code;
+  Error err = init_code(code, Arch::kX64);
+  x86::Assembler a(&code);
+
+  AsmParser parser(&a);
+  if (err == Error::kOk)
+    err = parser.parse(
+      "mov eax, ebx\n"
+      "L0:\n"
+      "jmp L0\n"
+      "add eax, 1\n");
+
+  const AsmParserStatistics& stats = parser.statistics();
+  const CodeBuffer& buf = code.section_by_id(0)->buffer();
+
+  bool ok = err == Error::kOk &&
+            stats.validate_count == 3 &&
+            stats.emitted_size == buf.size() &&
+            stats.label_miss_count == 1 &&
+            stats.label_hit_count == 1 &&
+            stats.register_hit_count == 3 &&
+            stats.token_count[uint32_t(AsmTokenType::kNL)] == 4 &&
+            stats.token_count[uint32_t(AsmTokenType::kEnd)] == 1;
+
+  printf("%sX64: Statistics (%llu bytes emitted, %llu validations) [%s]\n",
+    ok ? " " : "-", (unsigned long long)stats.emitted_size, (unsigned long long)stats.validate_count, ok ? "OK" : "FAILED");
+  return ok;
+}
+#endif
+
+// Parses all entries that must pass without validation and with sampled validation, which must produce the same code.
+static bool run_validation_test(Span<const TestEntry> entries) {
+  static const AsmValidation modes[] = { AsmValidation::kSampled, AsmValidation::kNever };
+  static const char* const mode_names[] = { "Validation=Sampled", "Validation=Never" };
+
+  size_t count = 0;
+  size_t failed_count = 0;
+
+  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(modes); i++) {
+    for (const TestEntry& entry : entries) {
+      if (!entry.must_pass)
+        continue;
+
+      count++;
+
+      CodeHolder code;
+      if (init_code(code, entry) != Error::kOk) {
+        failed_count++;
+        continue;
+      }
+
+      x86::Assembler a(&code);
+      AsmParser parser(&a);
+      parser.set_validation(modes[i], 3);
+      Error err = parser.parse(entry.asm_string, entry.asm_size);
+
+      if (!check_entry(entry, err, code, mode_names[i]))
+        failed_count++;
+    }
+  }
+
+  bool ok = failed_count == 0;
+  printf("%sX86/X64: Parsed %zu entries without validation [%s]\n", ok ? " " : "-", count, ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Runs all entries through a single parser, which is attached to a new emitter for each entry. Failing entries leave
+// the parser in the middle of a command, which must not affect the next entry.
+static bool run_reuse_test(Span<const TestEntry> entries) {
+  CodeHolder code;
+  x86::Assembler a;
+  AsmParser parser(nullptr);
+
+  size_t failed_count = 0;
+
+  for (const TestEntry& entry : entries) {
+    code.reset();
+    if (init_code(code, entry) != Error::kOk) {
+      failed_count++;
+      continue;
+    }
+    code.attach(&a);
+
+    parser.attach(&a);
+    Error err = parser.parse(entry.asm_string, entry.asm_size);
+
+    if (!check_entry(entry, err, code, "Reuse"))
+      failed_count++;
+  }
+
+  bool ok = failed_count == 0;
+  printf("%sX86/X64: Reused parser for %zu entries [%s]\n", ok ? " " : "-", entries.size(), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Runs all entries twice through a single parser, the second pass validates by the validation cache. Each entry must
+// report the same error as a parser, which validates without the cache (it's cleared before each entry).
+static bool run_validation_cache_test(Span<const TestEntry> entries) {
+  CodeHolder code;
+  x86::Assembler a;
+  AsmParser parser(nullptr);
+
+  CodeHolder ref_code;
+  x86::Assembler ref_a;
+  AsmParser ref_parser(nullptr);
+
+  size_t failed_count = 0;
+
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    for (const TestEntry& entry : entries) {
+      code.reset();
+      ref_code.reset();
+
+      if (init_code(code, entry) != Error::kOk || init_code(ref_code, entry) != Error::kOk) {
+        failed_count++;
+        continue;
+      }
+
+      code.attach(&a);
+      parser.attach(&a);
+      Error err = parser.parse(entry.asm_string, entry.asm_size);
+
+      ref_code.attach(&ref_a);
+      ref_parser.attach(&ref_a);
+      ref_parser._validation_cache.reset();
+      Error ref_err = ref_parser.parse(entry.asm_string, entry.asm_size);
+
+      if (!check_entry(entry, err, code, pass == 0 ? "ValidationCache (pass 0)" : "ValidationCache (pass 1)")) {
+        failed_count++;
+      }
+      else if (err != ref_err) {
+        printf("-%s: %-55s -> %s != %s [FAILED] ValidationCache (pass %u)\n",
+          arch_name(entry.arch), entry.asm_string, DebugUtils::error_as_string(err), DebugUtils::error_as_string(ref_err), pass);
+        failed_count++;
+      }
+    }
+  }
+
+  // An instruction of a cached shape must be served from the cache - replace all cached results by an error, which
+  // validation of the instruction never returns, and check that it's reported.
+  bool hit = false;
+
+  code.reset();
+  Error err = init_code(code, Arch::kX64);
+
+  if (err == Error::kOk) {
+    code.attach(&a);
+
+    parser.attach(&a);
+    parser._validation_cache.reset();
+    err = parser.parse("add eax, 1");
+
+    AsmValidationCache::Entry* cache_entries = parser._validation_cache._entries;
+    if (err == Error::kOk && cache_entries) {
+      for (uint32_t i = 0; i < AsmValidationCache::kCapacity; i++)
+        if (cache_entries[i].key.words[0] != 0)
+          cache_entries[i].err = Error::kInvalidState;
+
+      err = parser.parse("add eax, 2");
+      hit = err == Error::kInvalidState;
+    }
+  }
+
+  if (!hit) {
+    printf("-X64: %-55s -> %s [FAILED] ValidationCache (not hit)\n", "add eax, 2", DebugUtils::error_as_string(err));
+    failed_count++;
+  }
+
+  bool ok = failed_count == 0;
+  printf("%sX86/X64: Validated %zu entries twice by the validation cache [%s]\n", ok ? " " : "-", entries.size(), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Parses data directives with thousands of values per line in all number formats the tokenizer recognizes, which
+// must produce the same bytes as the values written one by one.
+static bool run_data_test() {
+  static const char* const directives[] = { ".db", ".dw", ".dd", ".dq" };
+
+  std::string input;
+  std::vector<uint8_t> expected;
+  uint64_t state = 0x9E3779B97F4A7C15u;
+
+  for (uint32_t n_bytes = 1, d = 0; n_bytes <= 8; n_bytes *= 2, d++) {
+    input.append(directives[d]);
+
+    for (uint32_t i = 0; i < 5000; i++) {
+      state = state * 6364136223846793005u + 1442695040888963407u;
+      uint64_t value = n_bytes == 8 ? state : state & ((uint64_t(1) << (n_bytes * 8)) - 1u);
+
+      char buf[64];
+      switch (i % 5) {
+        case 0: snprintf(buf, sizeof(buf), "%llu", (unsigned long long)value); break;
+        case 1: snprintf(buf, sizeof(buf), "0x%llX", (unsigned long long)value); break;
+        case 2:
+          // A suffixed hexadecimal number must start with a decimal digit as `0b...h` would be a binary number.
+          snprintf(buf, sizeof(buf), "%llXh", (unsigned long long)value);
+          if (buf[0] > '9')
+            snprintf(buf, sizeof(buf), "0x%llx", (unsigned long long)value);
+          break;
+        case 3: snprintf(buf, sizeof(buf), "0%llo", (unsigned long long)value); break;
+        default: snprintf(buf, sizeof(buf), "%llu", (unsigned long long)(value & 0xFFu)); break;
+      }
+
+      input.append(i ? (i & 1u ? ", " : ",\t") : " ");
+      input.append(buf);
+
+      for (uint32_t j = 0; j < n_bytes; j++)
+        expected.push_back(uint8_t((n_bytes == 8 || i % 5 != 4 ? value : value & 0xFFu) >> (j * 8)));
+    }
+
+    input.append(" ; end of data\n");
+  }
+
+  CodeHolder code;
+  Error err = init_code(code, Arch::kX64);
+  x86::Assembler a(&code);
+
+  if (err == Error::kOk)
+    err = AsmParser(&a).parse(input.data(), input.size());
+  const CodeBuffer& buf = code.section_by_id(0)->buffer();
+
+  bool ok = err == Error::kOk && buf.size() == expected.size() && memcmp(buf.data(), expected.data(), buf.size()) == 0;
+
+  // A value that doesn't fit must fail even in the middle of a long list.
+  if (ok) {
+    std::string overflow(".dw 1");
+    for (uint32_t i = 0; i < 1000; i++)
+      overflow.append(i == 777 ? ", 65536" : ", 65535");
+
+    code.reinit();
+    ok = AsmParser(&a).parse(overflow.data(), overflow.size()) == Error::kInvalidImmediate;
+  }
+
+  printf("%sX64: Data directives of %zu bytes -> %s [%s]\n",
+    ok ? " " : "-", input.size(), DebugUtils::error_as_string(err), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Includes a file by `.incbin` relative to the include directory, with and without offset and length, and checks that
+// missing files, ranges out of the file, paths that leave the include directory, and `.incbin` without an include
+// directory are rejected.
+static bool run_incbin_test() {
+  std::error_code ec;
+  std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "asmtk_test_incbin";
+  std::filesystem::remove_all(directory, ec);
+  std::filesystem::create_directories(directory, ec);
+
+  std::vector<uint8_t> blob(1000);
+  for (size_t i = 0; i < blob.size(); i++)
+    blob[i] = uint8_t(i * 7u + 3u);
+
+  std::string blob_path = (directory / "blob.bin").string();
+  FILE* f = fopen(blob_path.c_str(), "wb");
+  bool ok = f && fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+  if (f)
+    fclose(f);
+
+  std::string include_dir = directory.string();
+  std::string input = ".db 1\n"
+                      ".incbin \"blob.bin\"\n"
+                      ".incbin \"blob.bin\", 990\n"
+                      ".incbin \"blob.bin\", 10, 5 ; comment\n"
+                      ".db 2\n";
+
+  std::vector<uint8_t> expected;
+  expected.push_back(1);
+  expected.insert(expected.end(), blob.begin(), blob.end());
+  expected.insert(expected.end(), blob.begin() + 990, blob.end());
+  expected.insert(expected.end(), blob.begin() + 10, blob.begin() + 15);
+  expected.push_back(2);
+
+  static const char* const failures[] = {
+    ".incbin \"missing.bin\"",
+    ".incbin \"blob.bin\", 1001",
+    ".incbin \"blob.bin\", 999, 2",
+    ".incbin \"blob.bin\",",
+    ".incbin \"\"",
+    ".incbin blob.bin",
+    ".incbin \"blob.bin",
+    ".incbin \"/etc/passwd\"",
+    ".incbin \"\\\\server\\share\\blob.bin\"",
+    ".incbin \"C:blob.bin\"",
+    ".incbin \"../asmtk_test_incbin/blob.bin\"",
+    ".incbin \"sub/../../blob.bin\"",
+    ".incbin \"sub\\..\\..\\blob.bin\""
+  };
+
+  CodeHolder code;
+  Error err = init_code(code, Arch::kX64);
+  ok = ok && err == Error::kOk;
+  x86::Assembler a(&code);
+
+  AsmParser parser(&a);
+  parser.set_include_dir(include_dir.c_str());
+
+  if (ok) {
+    err = parser.parse(input.data(), input.size());
+
+    const CodeBuffer& buf = code.section_by_id(0)->buffer();
+    ok = err == Error::kOk && buf.size() == expected.size() && memcmp(buf.data(), expected.data(), buf.size()) == 0;
+  }
+
+  for (const char* failure : failures) {
+    code.reinit();
+    if (parser.parse(failure) == Error::kOk) {
+      printf("-X64: %-55s -> [FAILED] Incbin must fail\n", failure);
+      ok = false;
+    }
+  }
+
+  // Including files is disabled without an include directory.
+  code.reinit();
+  parser.set_include_dir(nullptr);
+  if (parser.parse(".incbin \"blob.bin\"") != Error::kInvalidDirective) {
+    printf("-X64: .incbin without an include directory must fail\n");
+    ok = false;
+  }
+
+  std::filesystem::remove_all(directory, ec);
+
+  printf("%sX64: Included %zu bytes by .incbin -> %s [%s]\n",
+    ok ? " " : "-", expected.size(), DebugUtils::error_as_string(err), ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Parses all entries by `BasicAsmParser<x86::Assembler>` and by `BasicAsmParser<x86::Builder>`, which must produce
+// the same code as `AsmParser`.
+static bool run_basic_parser_test(Span<const TestEntry> entries) {
+  size_t failed_count = 0;
+
+  for (const TestEntry& entry : entries) {
+    for (uint32_t use_builder = 0; use_builder < 2; use_builder++) {
+      CodeHolder code;
+      if (init_code(code, entry) != Error::kOk) {
+        failed_count++;
+        continue;
+      }
+
+      Error err;
+      if (use_builder) {
+        x86::Builder cb(&code);
+        BasicAsmParser<x86::Builder> parser(&cb);
+        err = parser.parse(entry.asm_string, entry.asm_size);
+        if (err == Error::kOk)
+          err = cb.finalize();
+      }
+      else {
+        x86::Assembler a(&code);
+        BasicAsmParser<x86::Assembler> parser(&a);
+        err = parser.parse(entry.asm_string, entry.asm_size);
+      }
+
+      if (!check_entry(entry, err, code, use_builder ? "BasicAsmParser<x86::Builder>" : "BasicAsmParser<x86::Assembler>"))
+        failed_count++;
+    }
+  }
+
+  bool ok = failed_count == 0;
+  printf("%sX86/X64: Parsed %zu entries by BasicAsmParser [%s]\n", ok ? " " : "-", entries.size(), ok ? "OK" : "FAILED");
+  return ok;
+}
+
 int main(int argc, char* argv[]) {
   CmdLine cmd_line(argc, argv);
 
@@ -1138,7 +1971,27 @@ int main(int argc, char* argv[]) {
   if (cmd_line.has_key("--only-failures"))
     options.only_failures = true;
 
-  bool all_passed = run_tests(stats, options, Span<const TestEntry>::from_array(test_entries));
+  Span<const TestEntry> entries = Span<const TestEntry>::from_array(test_entries);
+  bool all_passed = run_tests(stats, options, entries);
+
+  std::string large_input = generate_large_input(entries);
+
+  all_passed &= add_result(stats, run_parallel_test(large_input));
+  all_passed &= add_result(stats, run_record_test(large_input));
+  all_passed &= add_result(stats, run_pipelined_test(large_input));
+  all_passed &= add_result(stats, run_cache_test());
+  all_passed &= add_result(stats, run_batch_test(entries));
+  all_passed &= add_result(stats, run_reuse_test(entries));
+  all_passed &= add_result(stats, run_recovery_test());
+  all_passed &= add_result(stats, run_validation_test(entries));
+  all_passed &= add_result(stats, run_validation_cache_test(entries));
+  all_passed &= add_result(stats, run_basic_parser_test(entries));
+  all_passed &= add_result(stats, run_data_test());
+  all_passed &= add_result(stats, run_incbin_test());
+#if defined(ASMTK_STATISTICS)
+  all_passed &= add_result(stats, run_statistics_test());
+#endif
+
   if (all_passed) {
     printf("All %u tests passed!\n", stats.total);
     return 0;